@@ -86,6 +86,21 @@ cmicr2_pdma_tx_ring_unused(struct pdma_tx_queue *txq)
     return (txq->nb_desc + txq->dirt - txq->curr - 1) % txq->nb_desc;
 }
 
+/*!
+ * Kick off Tx DMA for the descriptors queued since the last kick
+ */
+static inline void
+cmicr2_pdma_tx_kick(struct pdma_hw *hw, struct pdma_tx_queue *txq)
+{
+    dma_addr_t halt_addr = txq->ring_addr + sizeof(TX_DCB_t) * txq->curr;
+
+    if (txq->halt_addr != halt_addr) {
+        txq->halt_addr = halt_addr;
+        hw->hdls.chan_goto(hw, txq->chan_id, txq->halt_addr);
+        txq->stats.doorbells++;
+    }
+}
+
 /*!
  * Fetch Tx vring
  */
@@ -133,6 +148,8 @@ cmicr2_pdma_tx_ring_check(struct pdma_hw *hw, struct pdma_tx_queue *txq)
 
     if (dev->suspended) {
         txq->stats.xoffs++;
+        /* Flush the deferred descriptors before the queue is stopped */
+        cmicr2_pdma_tx_kick(hw, txq);
         if (dev->tx_suspend) {
             dev->tx_suspend(dev, txq->queue_id);
             return SHR_E_BUSY;
@@ -150,6 +167,7 @@ cmicr2_pdma_tx_ring_check(struct pdma_hw *hw, struct pdma_tx_queue *txq)
     if (!cmicr2_pdma_tx_ring_unused(txq)) {
         txq->status |= PDMA_TX_QUEUE_XOFF;
         txq->stats.xoffs++;
+        cmicr2_pdma_tx_kick(hw, txq);
         if (dev->tx_suspend) {
             dev->tx_suspend(dev, txq->queue_id);
         }
@@ -161,6 +179,36 @@ cmicr2_pdma_tx_ring_check(struct pdma_hw *hw, struct pdma_tx_queue *txq)
     return SHR_E_NONE;
 }
 
+/*!
+ * \brief Kick off deferred Tx descriptors
+ *
+ * Descriptors held back by PDMA_TX_MORE_PKT are normally kicked off by
+ * the last packet of a burst. This is used when that packet never gets
+ * to this queue.
+ *
+ * \param [in] hw HW structure point.
+ * \param [in] txq Tx queue structure point.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
+ */
+static int
+cmicr2_pdma_tx_flush(struct pdma_hw *hw, struct pdma_tx_queue *txq)
+{
+    struct pdma_dev *dev = hw->dev;
+
+    /* Only the suspend capable Tx path defers descriptors */
+    if (!dev->tx_suspend) {
+        return SHR_E_UNAVAIL;
+    }
+
+    sal_spinlock_lock(txq->mutex);
+    cmicr2_pdma_tx_kick(hw, txq);
+    sal_spinlock_unlock(txq->mutex);
+
+    return SHR_E_NONE;
+}
+
 /*!
  * \brief Start packet transmission
  *
@@ -181,6 +229,7 @@ cmicr2_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
     struct pkt_hdr *pkh = NULL;
     dma_addr_t addr;
     uint32_t curr;
+    int more = 0;
     int retry = 5000000;
     int rv;
 
@@ -216,6 +265,7 @@ cmicr2_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
     if (dev->mode == DEV_MODE_HNET && !buf) {
         rv = cmicr2_pdma_tx_vring_fetch(hw, txq, pbuf);
         if (SHR_FAILURE(rv)) {
+            cmicr2_pdma_tx_kick(hw, txq);
             sal_spinlock_unlock(txq->mutex);
             return SHR_E_EMPTY;
         }
@@ -225,6 +275,7 @@ cmicr2_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
         pkh = bm->tx_buf_get(dev, txq, pbuf, buf);
         if (!pkh) {
             txq->stats.dropped++;
+            cmicr2_pdma_tx_kick(hw, txq);
             if (dev->tx_suspend) {
                 sal_spinlock_unlock(txq->mutex);
             } else {
@@ -234,6 +285,7 @@ cmicr2_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
         }
         bm->tx_buf_dma(dev, txq, pbuf, &addr);
         cmicr2_tx_desc_config(&ring[curr], addr, pbuf->len, pkh->hdr_prof, pkh->attrs);
+        more = pkh->attrs & PDMA_TX_MORE_PKT && !(dev->flags & PDMA_CHAIN_MODE);
     }
 
     /* Notify HNET to process if needed */
@@ -273,9 +325,10 @@ cmicr2_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
         sal_spinlock_unlock(txq->lock);
     }
 
-    /* Kick off DMA */
-    txq->halt_addr = txq->ring_addr + sizeof(TX_DCB_t) * curr;
-    hw->hdls.chan_goto(hw, txq->chan_id, txq->halt_addr);
+    /* Kick off DMA unless more packets follow in this burst */
+    if (!more) {
+        cmicr2_pdma_tx_kick(hw, txq);
+    }
 
     /* Count the packets/bytes */
     txq->stats.packets++;
@@ -350,6 +403,7 @@ bcmcnet_cmicr2_pdma_driver_attach(struct pdma_dev *dev)
     bcmcnet_cmicr_pdma_desc_ops_init(hw);
 
     hw->dops.pkt_xmit = cmicr2_pdma_pkt_xmit;
+    hw->dops.tx_kick = cmicr2_pdma_tx_flush;
 
     dev->flags |= PDMA_NO_FCS;
 
@@ -246,6 +246,38 @@ cmicr_pdma_tx_ring_unused(struct pdma_tx_queue *txq)
     return (txq->nb_desc + txq->dirt - txq->curr - 1) % txq->nb_desc;
 }
 
+/*!
+ * Move Rx halt point to release the re-armed descriptors before it
+ */
+static inline void
+cmicr_pdma_rx_halt_update(struct pdma_hw *hw, struct pdma_rx_queue *rxq, uint32_t halt)
+{
+    sal_spinlock_lock(rxq->lock);
+    if (!(rxq->status & PDMA_RX_QUEUE_XOFF) && (rxq->halt != halt)) {
+        /* Descriptor cherry pick */
+        rxq->halt_addr = rxq->ring_addr + sizeof(RX_DCB_t) * halt;
+        hw->hdls.chan_goto(hw, rxq->chan_id, rxq->halt_addr);
+        rxq->halt = halt;
+        rxq->stats.doorbells++;
+    }
+    sal_spinlock_unlock(rxq->lock);
+}
+
+/*!
+ * Kick off Tx DMA for the descriptors queued since the last kick
+ */
+static inline void
+cmicr_pdma_tx_kick(struct pdma_hw *hw, struct pdma_tx_queue *txq)
+{
+    dma_addr_t halt_addr = txq->ring_addr + sizeof(TX_DCB_t) * txq->curr;
+
+    if (txq->halt_addr != halt_addr) {
+        txq->halt_addr = halt_addr;
+        hw->hdls.chan_goto(hw, txq->chan_id, txq->halt_addr);
+        txq->stats.doorbells++;
+    }
+}
+
 /*!
  * Initialize Rx descriptors
  */
@@ -481,6 +513,7 @@ cmicr_pdma_rx_ring_refill(struct pdma_hw *hw, struct pdma_rx_queue *rxq)
         /* Descriptor cherry pick */
         rxq->halt_addr = rxq->ring_addr + sizeof(RX_DCB_t) * rxq->halt;
         hw->hdls.chan_goto(hw, rxq->chan_id, rxq->halt_addr);
+        rxq->stats.doorbells++;
     }
     sal_spinlock_unlock(rxq->lock);
 
@@ -517,17 +550,10 @@ cmicr_pdma_rx_ring_clean(struct pdma_hw *hw, struct pdma_rx_queue *rxq, int budg
             break;
         }
 
-        /* Move forward */
-        if (!(rxq->state & PDMA_RX_BATCH_REFILL)) {
-            /* coverity[double_lock : FALSE] */
-            sal_spinlock_lock(rxq->lock);
-            if (!(rxq->status & PDMA_RX_QUEUE_XOFF)) {
-                /* Descriptor cherry pick */
-                rxq->halt_addr = rxq->ring_addr + sizeof(RX_DCB_t) * curr;
-                hw->hdls.chan_goto(hw, rxq->chan_id, rxq->halt_addr);
-                rxq->halt = curr;
-            }
-            sal_spinlock_unlock(rxq->lock);
+        /* Move forward once a batch of descriptors has been re-armed */
+        if (!(rxq->state & PDMA_RX_BATCH_REFILL) &&
+            (curr + rxq->nb_desc - rxq->halt) % rxq->nb_desc >= rxq->refill_batch) {
+            cmicr_pdma_rx_halt_update(hw, rxq, curr);
         }
 
         /* Get the current pktbuf to process */
@@ -537,6 +563,9 @@ cmicr_pdma_rx_ring_clean(struct pdma_hw *hw, struct pdma_rx_queue *rxq, int budg
         if (!pkh) {
             CNET_ERROR(hw->unit, "RX buffer build failed, retry ...\n");
             rxq->stats.nomems++;
+            if (!(rxq->state & PDMA_RX_BATCH_REFILL)) {
+                cmicr_pdma_rx_halt_update(hw, rxq, curr);
+            }
             /* Set busy state to retry */
             rxq->state |= PDMA_RX_QUEUE_BUSY;
             return budget;
@@ -553,6 +582,9 @@ cmicr_pdma_rx_ring_clean(struct pdma_hw *hw, struct pdma_rx_queue *rxq, int budg
             if (dev->mode == DEV_MODE_HNET && pkh->attrs & PDMA_RX_TO_VNET) {
                 rv = cmicr_pdma_rx_vring_process(hw, rxq, pbuf);
                 if (SHR_FAILURE(rv) && rv == SHR_E_BUSY) {
+                    if (!(rxq->state & PDMA_RX_BATCH_REFILL)) {
+                        cmicr_pdma_rx_halt_update(hw, rxq, curr);
+                    }
                     rxq->state |= PDMA_RX_QUEUE_BUSY;
                     return done;
                 }
@@ -617,12 +649,6 @@ cmicr_pdma_rx_ring_clean(struct pdma_hw *hw, struct pdma_rx_queue *rxq, int budg
         /* Update the indicators */
         if (!(rxq->state & PDMA_RX_BATCH_REFILL)) {
             sal_spinlock_lock(rxq->lock);
-            if (!(rxq->status & PDMA_RX_QUEUE_XOFF) && (rxq->halt != curr)) {
-                /* Descriptor cherry pick */
-                rxq->halt_addr = rxq->ring_addr + sizeof(RX_DCB_t) * curr;
-                hw->hdls.chan_goto(hw, rxq->chan_id, rxq->halt_addr);
-                rxq->halt = curr;
-            }
             curr = (curr + 1) % rxq->nb_desc;
             rxq->curr = curr;
             sal_spinlock_unlock(rxq->lock);
@@ -644,6 +670,11 @@ cmicr_pdma_rx_ring_clean(struct pdma_hw *hw, struct pdma_rx_queue *rxq, int budg
         }
     }
 
+    /* Release the descriptors re-armed since the last halt update */
+    if (!(rxq->state & PDMA_RX_BATCH_REFILL) && done) {
+        cmicr_pdma_rx_halt_update(hw, rxq, (curr + rxq->nb_desc - 1) % rxq->nb_desc);
+    }
+
     /* One more poll for chain done in chain mode */
     if (dev->flags & PDMA_CHAIN_MODE) {
         if (curr == rxq->nb_desc - 1 && done) {
@@ -888,6 +919,8 @@ cmicr_pdma_tx_ring_check(struct pdma_hw *hw, struct pdma_tx_queue *txq)
 
     if (dev->suspended) {
         txq->stats.xoffs++;
+        /* Flush the deferred descriptors before the queue is stopped */
+        cmicr_pdma_tx_kick(hw, txq);
         if (dev->tx_suspend) {
             dev->tx_suspend(dev, txq->queue_id);
             return SHR_E_BUSY;
@@ -905,6 +938,7 @@ cmicr_pdma_tx_ring_check(struct pdma_hw *hw, struct pdma_tx_queue *txq)
     if (!cmicr_pdma_tx_ring_unused(txq)) {
         txq->status |= PDMA_TX_QUEUE_XOFF;
         txq->stats.xoffs++;
+        cmicr_pdma_tx_kick(hw, txq);
         if (dev->tx_suspend) {
             dev->tx_suspend(dev, txq->queue_id);
         }
@@ -916,6 +950,36 @@ cmicr_pdma_tx_ring_check(struct pdma_hw *hw, struct pdma_tx_queue *txq)
     return SHR_E_NONE;
 }
 
+/*!
+ * \brief Kick off deferred Tx descriptors
+ *
+ * Descriptors held back by PDMA_TX_MORE_PKT are normally kicked off by
+ * the last packet of a burst. This is used when that packet never gets
+ * to this queue.
+ *
+ * \param [in] hw HW structure point.
+ * \param [in] txq Tx queue structure point.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
+ */
+static int
+cmicr_pdma_tx_flush(struct pdma_hw *hw, struct pdma_tx_queue *txq)
+{
+    struct pdma_dev *dev = hw->dev;
+
+    /* Only the suspend capable Tx path defers descriptors */
+    if (!dev->tx_suspend) {
+        return SHR_E_UNAVAIL;
+    }
+
+    sal_spinlock_lock(txq->mutex);
+    cmicr_pdma_tx_kick(hw, txq);
+    sal_spinlock_unlock(txq->mutex);
+
+    return SHR_E_NONE;
+}
+
 /*!
  * \brief Start packet transmission
  *
@@ -936,6 +1000,7 @@ cmicr_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
     struct pkt_hdr *pkh = NULL;
     dma_addr_t addr;
     uint32_t curr;
+    int more = 0;
     int retry = 5000000;
     int rv;
 
@@ -971,6 +1036,7 @@ cmicr_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
     if (dev->mode == DEV_MODE_HNET && !buf) {
         rv = cmicr_pdma_tx_vring_fetch(hw, txq, pbuf);
         if (SHR_FAILURE(rv)) {
+            cmicr_pdma_tx_kick(hw, txq);
             sal_spinlock_unlock(txq->mutex);
             return SHR_E_EMPTY;
         }
@@ -980,6 +1046,7 @@ cmicr_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
         pkh = bm->tx_buf_get(dev, txq, pbuf, buf);
         if (!pkh) {
             txq->stats.dropped++;
+            cmicr_pdma_tx_kick(hw, txq);
             if (dev->tx_suspend) {
                 sal_spinlock_unlock(txq->mutex);
             } else {
@@ -989,6 +1056,7 @@ cmicr_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
         }
         bm->tx_buf_dma(dev, txq, pbuf, &addr);
         cmicr_tx_desc_config(&ring[curr], addr, pbuf->len, pkh->attrs);
+        more = pkh->attrs & PDMA_TX_MORE_PKT && !(dev->flags & PDMA_CHAIN_MODE);
     }
 
     /* Notify HNET to process if needed */
@@ -1028,9 +1096,10 @@ cmicr_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
         sal_spinlock_unlock(txq->lock);
     }
 
-    /* Kick off DMA */
-    txq->halt_addr = txq->ring_addr + sizeof(TX_DCB_t) * curr;
-    hw->hdls.chan_goto(hw, txq->chan_id, txq->halt_addr);
+    /* Kick off DMA unless more packets follow in this burst */
+    if (!more) {
+        cmicr_pdma_tx_kick(hw, txq);
+    }
 
     /* Count the packets/bytes */
     txq->stats.packets++;
@@ -1120,6 +1189,12 @@ cmicr_pdma_rx_resume(struct pdma_hw *hw, struct pdma_rx_queue *rxq)
         rxq->halt = (rxq->curr + rxq->nb_desc - 1) % rxq->nb_desc;
         rxq->halt_addr = rxq->ring_addr + sizeof(RX_DCB_t) * rxq->halt;
         hw->hdls.chan_goto(hw, rxq->chan_id, rxq->halt_addr);
+    } else if ((rxq->halt != rxq->curr) &&
+               (rxq->halt != (rxq->curr + rxq->nb_desc - 1) % rxq->nb_desc)) {
+        /* Release the descriptors held back by a deferred halt update */
+        rxq->halt = (rxq->curr + rxq->nb_desc - 1) % rxq->nb_desc;
+        rxq->halt_addr = rxq->ring_addr + sizeof(RX_DCB_t) * rxq->halt;
+        hw->hdls.chan_goto(hw, rxq->chan_id, rxq->halt_addr);
     }
     if (hw->dev->flags & PDMA_CHAIN_MODE) {
         rxq->curr = 0;
@@ -1152,6 +1227,7 @@ bcmcnet_cmicr_pdma_desc_ops_init(struct pdma_hw *hw)
     hw->dops.tx_ring_clean = cmicr_pdma_tx_ring_clean;
     hw->dops.tx_ring_dump = cmicr_pdma_tx_ring_dump;
     hw->dops.pkt_xmit = cmicr_pdma_pkt_xmit;
+    hw->dops.tx_kick = cmicr_pdma_tx_flush;
 
     return SHR_E_NONE;
 }
@@ -204,6 +204,38 @@ cmicx_pdma_tx_ring_unused(struct pdma_tx_queue *txq)
     return (txq->nb_desc + txq->dirt - txq->curr - 1) % txq->nb_desc;
 }
 
+/*!
+ * Move Rx halt point to release the re-armed descriptors before it
+ */
+static inline void
+cmicx_pdma_rx_halt_update(struct pdma_hw *hw, struct pdma_rx_queue *rxq, uint32_t halt)
+{
+    sal_spinlock_lock(rxq->lock);
+    if (!(rxq->status & PDMA_RX_QUEUE_XOFF) && (rxq->halt != halt)) {
+        /* Descriptor cherry pick */
+        rxq->halt_addr = rxq->ring_addr + sizeof(struct cmicx_rx_desc) * halt;
+        hw->hdls.chan_goto(hw, rxq->chan_id, rxq->halt_addr);
+        rxq->halt = halt;
+        rxq->stats.doorbells++;
+    }
+    sal_spinlock_unlock(rxq->lock);
+}
+
+/*!
+ * Kick off Tx DMA for the descriptors queued since the last kick
+ */
+static inline void
+cmicx_pdma_tx_kick(struct pdma_hw *hw, struct pdma_tx_queue *txq)
+{
+    dma_addr_t halt_addr = txq->ring_addr + sizeof(struct cmicx_tx_desc) * txq->curr;
+
+    if (txq->halt_addr != halt_addr) {
+        txq->halt_addr = halt_addr;
+        hw->hdls.chan_goto(hw, txq->chan_id, txq->halt_addr);
+        txq->stats.doorbells++;
+    }
+}
+
 /*!
  * Initialize Rx descriptors
  */
@@ -439,6 +471,7 @@ cmicx_pdma_rx_ring_refill(struct pdma_hw *hw, struct pdma_rx_queue *rxq)
         /* Descriptor cherry pick */
         rxq->halt_addr = rxq->ring_addr + sizeof(struct cmicx_rx_desc) * rxq->halt;
         hw->hdls.chan_goto(hw, rxq->chan_id, rxq->halt_addr);
+        rxq->stats.doorbells++;
     }
     sal_spinlock_unlock(rxq->lock);
 
@@ -475,16 +508,10 @@ cmicx_pdma_rx_ring_clean(struct pdma_hw *hw, struct pdma_rx_queue *rxq, int budg
             break;
         }
 
-        /* Move forward */
-        if (!(rxq->state & PDMA_RX_BATCH_REFILL)) {
-            sal_spinlock_lock(rxq->lock);
-            if (!(rxq->status & PDMA_RX_QUEUE_XOFF)) {
-                /* Descriptor cherry pick */
-                rxq->halt_addr = rxq->ring_addr + sizeof(struct cmicx_rx_desc) * curr;
-                hw->hdls.chan_goto(hw, rxq->chan_id, rxq->halt_addr);
-                rxq->halt = curr;
-            }
-            sal_spinlock_unlock(rxq->lock);
+        /* Move forward once a batch of descriptors has been re-armed */
+        if (!(rxq->state & PDMA_RX_BATCH_REFILL) &&
+            (curr + rxq->nb_desc - rxq->halt) % rxq->nb_desc >= rxq->refill_batch) {
+            cmicx_pdma_rx_halt_update(hw, rxq, curr);
         }
 
         /* Get the current pktbuf to process */
@@ -495,6 +522,9 @@ cmicx_pdma_rx_ring_clean(struct pdma_hw *hw, struct pdma_rx_queue *rxq, int budg
         if (!pkh) {
             CNET_ERROR(hw->unit, "RX buffer build failed, retry ...\n");
             rxq->stats.nomems++;
+            if (!(rxq->state & PDMA_RX_BATCH_REFILL)) {
+                cmicx_pdma_rx_halt_update(hw, rxq, curr);
+            }
             /* Set busy state to retry */
             rxq->state |= PDMA_RX_QUEUE_BUSY;
             return budget;
@@ -512,6 +542,9 @@ cmicx_pdma_rx_ring_clean(struct pdma_hw *hw, struct pdma_rx_queue *rxq, int budg
             if (dev->mode == DEV_MODE_HNET && pkh->attrs & PDMA_RX_TO_VNET) {
                 rv = cmicx_pdma_rx_vring_process(hw, rxq, pbuf);
                 if (SHR_FAILURE(rv) && rv == SHR_E_BUSY) {
+                    if (!(rxq->state & PDMA_RX_BATCH_REFILL)) {
+                        cmicx_pdma_rx_halt_update(hw, rxq, curr);
+                    }
                     rxq->state |= PDMA_RX_QUEUE_BUSY;
                     return done;
                 }
@@ -581,12 +614,6 @@ cmicx_pdma_rx_ring_clean(struct pdma_hw *hw, struct pdma_rx_queue *rxq, int budg
         /* Update the indicators */
         if (!(rxq->state & PDMA_RX_BATCH_REFILL)) {
             sal_spinlock_lock(rxq->lock);
-            if (!(rxq->status & PDMA_RX_QUEUE_XOFF) && (rxq->halt != curr)) {
-                /* Descriptor cherry pick */
-                rxq->halt_addr = rxq->ring_addr + sizeof(struct cmicx_rx_desc) * curr;
-                hw->hdls.chan_goto(hw, rxq->chan_id, rxq->halt_addr);
-                rxq->halt = curr;
-            }
             curr = (curr + 1) % rxq->nb_desc;
             rxq->curr = curr;
             sal_spinlock_unlock(rxq->lock);
@@ -607,6 +634,11 @@ cmicx_pdma_rx_ring_clean(struct pdma_hw *hw, struct pdma_rx_queue *rxq, int budg
         }
     }
 
+    /* Release the descriptors re-armed since the last halt update */
+    if (!(rxq->state & PDMA_RX_BATCH_REFILL) && done) {
+        cmicx_pdma_rx_halt_update(hw, rxq, (curr + rxq->nb_desc - 1) % rxq->nb_desc);
+    }
+
     /* One more poll for chain done in chain mode */
     if (dev->flags & PDMA_CHAIN_MODE) {
         if (curr == rxq->nb_desc - 1 && done) {
@@ -846,6 +878,8 @@ cmicx_pdma_tx_ring_check(struct pdma_hw *hw, struct pdma_tx_queue *txq)
 
     if (dev->suspended) {
         txq->stats.xoffs++;
+        /* Flush the deferred descriptors before the queue is stopped */
+        cmicx_pdma_tx_kick(hw, txq);
         if (dev->tx_suspend) {
             dev->tx_suspend(dev, txq->queue_id);
             return SHR_E_BUSY;
@@ -863,6 +897,7 @@ cmicx_pdma_tx_ring_check(struct pdma_hw *hw, struct pdma_tx_queue *txq)
     if (!cmicx_pdma_tx_ring_unused(txq)) {
         txq->status |= PDMA_TX_QUEUE_XOFF;
         txq->stats.xoffs++;
+        cmicx_pdma_tx_kick(hw, txq);
         if (dev->tx_suspend) {
             dev->tx_suspend(dev, txq->queue_id);
         }
@@ -874,6 +909,36 @@ cmicx_pdma_tx_ring_check(struct pdma_hw *hw, struct pdma_tx_queue *txq)
     return SHR_E_NONE;
 }
 
+/*!
+ * \brief Kick off deferred Tx descriptors
+ *
+ * Descriptors held back by PDMA_TX_MORE_PKT are normally kicked off by
+ * the last packet of a burst. This is used when that packet never gets
+ * to this queue.
+ *
+ * \param [in] hw HW structure point.
+ * \param [in] txq Tx queue structure point.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
+ */
+static int
+cmicx_pdma_tx_flush(struct pdma_hw *hw, struct pdma_tx_queue *txq)
+{
+    struct pdma_dev *dev = hw->dev;
+
+    /* Only the suspend capable Tx path defers descriptors */
+    if (!dev->tx_suspend) {
+        return SHR_E_UNAVAIL;
+    }
+
+    sal_spinlock_lock(txq->mutex);
+    cmicx_pdma_tx_kick(hw, txq);
+    sal_spinlock_unlock(txq->mutex);
+
+    return SHR_E_NONE;
+}
+
 /*!
  * \brief Start packet transmission
  *
@@ -894,6 +959,7 @@ cmicx_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
     struct pkt_hdr *pkh = NULL;
     dma_addr_t addr;
     uint32_t curr, flags = 0;
+    int more = 0;
     int retry = 5000000;
     int rv;
 
@@ -929,6 +995,7 @@ cmicx_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
     if (dev->mode == DEV_MODE_HNET && !buf) {
         rv = cmicx_pdma_tx_vring_fetch(hw, txq, pbuf);
         if (SHR_FAILURE(rv)) {
+            cmicx_pdma_tx_kick(hw, txq);
             sal_spinlock_unlock(txq->mutex);
             return SHR_E_EMPTY;
         }
@@ -938,6 +1005,7 @@ cmicx_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
         pkh = bm->tx_buf_get(dev, txq, pbuf, buf);
         if (!pkh) {
             txq->stats.dropped++;
+            cmicx_pdma_tx_kick(hw, txq);
             if (dev->tx_suspend) {
                 sal_spinlock_unlock(txq->mutex);
             } else {
@@ -949,6 +1017,7 @@ cmicx_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
         flags |= pkh->attrs & PDMA_TX_HIGIG_PKT ? CMICX_DESC_TX_HIGIG_PKT : 0;
         flags |= pkh->attrs & PDMA_TX_PURGE_PKT ? CMICX_DESC_TX_PURGE_PKT : 0;
         cmicx_tx_desc_config(&ring[curr], addr, pbuf->len, flags);
+        more = pkh->attrs & PDMA_TX_MORE_PKT && !(dev->flags & PDMA_CHAIN_MODE);
     }
 
     /* Notify HNET to process if needed */
@@ -988,9 +1057,10 @@ cmicx_pdma_pkt_xmit(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf)
         sal_spinlock_unlock(txq->lock);
     }
 
-    /* Kick off DMA */
-    txq->halt_addr = txq->ring_addr + sizeof(struct cmicx_tx_desc) * curr;
-    hw->hdls.chan_goto(hw, txq->chan_id, txq->halt_addr);
+    /* Kick off DMA unless more packets follow in this burst */
+    if (!more) {
+        cmicx_pdma_tx_kick(hw, txq);
+    }
 
     /* Count the packets/bytes */
     txq->stats.packets++;
@@ -1080,6 +1150,12 @@ cmicx_pdma_rx_resume(struct pdma_hw *hw, struct pdma_rx_queue *rxq)
         rxq->halt = (rxq->curr + rxq->nb_desc - 1) % rxq->nb_desc;
         rxq->halt_addr = rxq->ring_addr + sizeof(struct cmicx_rx_desc) * rxq->halt;
         hw->hdls.chan_goto(hw, rxq->chan_id, rxq->halt_addr);
+    } else if ((rxq->halt != rxq->curr) &&
+               (rxq->halt != (rxq->curr + rxq->nb_desc - 1) % rxq->nb_desc)) {
+        /* Release the descriptors held back by a deferred halt update */
+        rxq->halt = (rxq->curr + rxq->nb_desc - 1) % rxq->nb_desc;
+        rxq->halt_addr = rxq->ring_addr + sizeof(struct cmicx_rx_desc) * rxq->halt;
+        hw->hdls.chan_goto(hw, rxq->chan_id, rxq->halt_addr);
     }
     if (hw->dev->flags & PDMA_CHAIN_MODE) {
         rxq->curr = 0;
@@ -1112,6 +1188,7 @@ bcmcnet_cmicx_pdma_desc_ops_init(struct pdma_hw *hw)
     hw->dops.tx_ring_clean = cmicx_pdma_tx_ring_clean;
     hw->dops.tx_ring_dump = cmicx_pdma_tx_ring_dump;
     hw->dops.pkt_xmit = cmicx_pdma_pkt_xmit;
+    hw->dops.tx_kick = cmicx_pdma_tx_flush;
 
     return SHR_E_NONE;
 }
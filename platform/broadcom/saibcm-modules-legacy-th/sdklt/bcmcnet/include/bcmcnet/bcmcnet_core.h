@@ -70,6 +70,8 @@ struct pkt_hdr {
 #define PDMA_TX_NO_PAD      (1 << 5)
     /*! Tx to HNET */
 #define PDMA_TX_TO_HNET     (1 << 6)
+    /*! Tx more packets follow, defer DMA kick-off */
+#define PDMA_TX_MORE_PKT    (1 << 7)
     /*! Rx to VNET */
 #define PDMA_RX_TO_VNET     (1 << 10)
     /*! Rx strip vlan tag */
@@ -260,6 +262,9 @@ struct dev_ctrl {
     /*! Common Rx buffer size for all queues */
     uint32_t rx_buf_size;
 
+    /*! Rx descriptors to re-arm per halt update in single fill mode */
+    uint32_t rx_refill_batch;
+
     /*! Rx descriptor size */
     uint32_t rx_desc_size;
 
@@ -1034,6 +1039,30 @@ bcmcnet_pdma_dev_rx_suspend(struct pdma_dev *dev);
 extern int
 bcmcnet_pdma_dev_rx_resume(struct pdma_dev *dev);
 
+/*!
+ * \brief Suspend a device Rx queue.
+ *
+ * \param [in] dev Device structure point.
+ * \param [in] queue Rx queue number.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
+ */
+extern int
+bcmcnet_pdma_dev_rx_queue_suspend(struct pdma_dev *dev, int queue);
+
+/*!
+ * \brief Resume a device Rx queue.
+ *
+ * \param [in] dev Device structure point.
+ * \param [in] queue Rx queue number.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
+ */
+extern int
+bcmcnet_pdma_dev_rx_queue_resume(struct pdma_dev *dev, int queue);
+
 /*!
  * \brief Dock device.
  *
@@ -432,6 +432,17 @@ typedef int (*tx_ring_dump_f)(struct pdma_hw *hw, struct pdma_tx_queue *txq);
  */
 typedef int (*pkt_xmit_f)(struct pdma_hw *hw, struct pdma_tx_queue *txq, void *buf);
 
+/*!
+ * \brief Kick off deferred Tx descriptors.
+ *
+ * \param [in] hw Pointer to hardware structure.
+ * \param [in] txq Pointer to Tx queue struture.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
+ */
+typedef int (*tx_kick_f)(struct pdma_hw *hw, struct pdma_tx_queue *txq);
+
 /*!
  * \brief Descriptor operations.
  */
@@ -468,6 +479,9 @@ struct desc_operations {
 
     /*! Tx transmit */
     pkt_xmit_f pkt_xmit;
+
+    /*! Tx deferred kick-off */
+    tx_kick_f tx_kick;
 };
 
 /*!
@@ -97,6 +97,9 @@ struct pdma_rx_queue {
     /*! Max free descriptors to hold */
     uint32_t free_thresh;
 
+    /*! Re-armed descriptors to hold before moving halt point */
+    uint32_t refill_batch;
+
     /*! Rx interrupt coalesce value */
     uint32_t ic_val;
 
@@ -397,6 +400,18 @@ bcmcnet_pdma_tx_queue_resume(struct pdma_dev *dev, int queue);
 extern int
 bcmcnet_pdma_tx_queue_wakeup(struct pdma_dev *dev, int queue);
 
+/*!
+ * \brief Kick off Tx descriptors deferred by PDMA_TX_MORE_PKT.
+ *
+ * \param [in] dev Device structure point.
+ * \param [in] queue Tx queue number.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
+ */
+extern int
+bcmcnet_pdma_tx_queue_kick(struct pdma_dev *dev, int queue);
+
 /*!
  * \brief Start Tx queue transmission.
  *
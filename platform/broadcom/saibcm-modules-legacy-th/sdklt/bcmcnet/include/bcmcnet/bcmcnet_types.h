@@ -162,6 +162,9 @@ typedef struct bcmcnet_rxq_stats {
 
     /*! Number of failed allocation */
     uint64_t nomems;
+
+    /*! Number of halt register updates */
+    uint64_t doorbells;
 } bcmcnet_rxq_stats_t;
 
 /*!
@@ -182,6 +185,9 @@ typedef struct bcmcnet_txq_stats {
 
     /*! Number of suspends */
     uint64_t xoffs;
+
+    /*! Number of halt register updates */
+    uint64_t doorbells;
 } bcmcnet_txq_stats_t;
 
 /*!
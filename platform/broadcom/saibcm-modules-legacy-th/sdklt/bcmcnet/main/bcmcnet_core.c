@@ -282,6 +282,38 @@ bcmcnet_pdma_dev_rx_resume(struct pdma_dev *dev)
     return SHR_E_NONE;
 }
 
+/*!
+ * Suspend a Rx queue
+ */
+int
+bcmcnet_pdma_dev_rx_queue_suspend(struct pdma_dev *dev, int queue)
+{
+    if (!dev->attached) {
+        return SHR_E_UNAVAIL;
+    }
+    if (queue < 0 || queue >= (int)dev->ctrl.nb_rxq) {
+        return SHR_E_PARAM;
+    }
+
+    return dev->ops->rx_queue_suspend(dev, queue);
+}
+
+/*!
+ * Resume a Rx queue
+ */
+int
+bcmcnet_pdma_dev_rx_queue_resume(struct pdma_dev *dev, int queue)
+{
+    if (!dev->attached) {
+        return SHR_E_UNAVAIL;
+    }
+    if (queue < 0 || queue >= (int)dev->ctrl.nb_rxq) {
+        return SHR_E_PARAM;
+    }
+
+    return dev->ops->rx_queue_resume(dev, queue);
+}
+
 /*!
  * Dock to HNET
  */
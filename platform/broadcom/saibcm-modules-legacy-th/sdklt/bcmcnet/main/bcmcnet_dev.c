@@ -226,6 +226,14 @@ bcn_rx_queue_group_parse(struct pdma_dev *dev, uint32_t qbm)
                     rxq->free_thresh = rxq->nb_desc / 4;
                     rxq->state |= PDMA_RX_BATCH_REFILL;
                 }
+                /* Set halt update batch for single fill mode */
+                rxq->refill_batch = ctrl->rx_refill_batch;
+                if (rxq->refill_batch > rxq->nb_desc / 4) {
+                    rxq->refill_batch = rxq->nb_desc / 4;
+                }
+                if (!rxq->refill_batch) {
+                    rxq->refill_batch = 1;
+                }
                 /* Update queue index */
                 rxq->queue_id = ctrl->nb_rxq;
                 ctrl->rx_queue[rxq->queue_id] = rxq;
@@ -521,6 +521,28 @@ bcmcnet_pdma_tx_queue_wakeup(struct pdma_dev *dev, int queue)
     return SHR_E_NONE;
 }
 
+/*!
+ * Kick off deferred Tx descriptors
+ */
+int
+bcmcnet_pdma_tx_queue_kick(struct pdma_dev *dev, int queue)
+{
+    struct dev_ctrl *ctrl = &dev->ctrl;
+    struct pdma_hw *hw = (struct pdma_hw *)ctrl->hw;
+    struct pdma_tx_queue *txq = NULL;
+
+    txq = (struct pdma_tx_queue *)ctrl->tx_queue[queue];
+    if (!txq || !(txq->state & PDMA_TX_QUEUE_ACTIVE)) {
+        return SHR_E_DISABLED;
+    }
+
+    if (!hw->dops.tx_kick) {
+        return SHR_E_UNAVAIL;
+    }
+
+    return hw->dops.tx_kick(hw, txq);
+}
+
 /*!
  * Transmit a outputing packet
  */
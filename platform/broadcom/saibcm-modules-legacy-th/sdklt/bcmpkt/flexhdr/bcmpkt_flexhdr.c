@@ -68,6 +68,69 @@ int *bcmpkt_flexhdr_variant_support_map[] = {
     NULL
 };
 
+/*
+ * Name lookup caches.
+ *
+ * Field and reason names are resolved by a case-insensitive hash into
+ * small direct-mapped caches of pointers into the static chip tables, so
+ * repeated lookups of the same name skip the linear table scan. Each slot
+ * is a single pointer, written and read whole, and a hit is only accepted
+ * if the cached entry lies within the table being searched and its name
+ * matches; a stale or racing slot therefore only costs a table scan.
+ * These are caches, not an index of the tables: a first lookup, or one
+ * whose slot was taken by another name, still scans the table linearly.
+ */
+#define NAME_CACHE_SIZE 256
+
+static bcmpkt_flex_field_metadata_t * volatile field_name_cache[NAME_CACHE_SIZE];
+static shr_enum_map_t * volatile reason_name_cache[NAME_CACHE_SIZE];
+
+/* RXPMD_FLEX_T header ID plus one for each variant, zero if unknown. */
+static volatile int rxpmd_flex_hid[BCMLRD_VARIANT_T_COUNT];
+
+static uint32_t
+name_hash(const char *name)
+{
+    uint32_t hash = 2166136261U;
+
+    while (*name) {
+        hash ^= (uint8_t)sal_tolower(*name++);
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+static inline uint32_t
+name_cache_slot(uint32_t hash, const void *tbl)
+{
+    uintptr_t addr = (uintptr_t)tbl;
+
+    hash ^= (uint32_t)(addr >> 4);
+    hash ^= hash >> 16;
+
+    return hash & (NAME_CACHE_SIZE - 1);
+}
+
+static int
+rxpmd_flex_hid_get(bcmlrd_variant_t variant, uint32_t *hid)
+{
+    int rv;
+
+    if (variant > BCMLRD_VARIANT_T_NONE && variant < BCMLRD_VARIANT_T_COUNT &&
+        rxpmd_flex_hid[variant] > 0) {
+        *hid = rxpmd_flex_hid[variant] - 1;
+        return SHR_E_NONE;
+    }
+
+    rv = bcmpkt_flexhdr_header_id_get(variant, "RXPMD_FLEX_T", hid);
+    if (SHR_SUCCESS(rv)) {
+        rxpmd_flex_hid[variant] = *hid + 1;
+    }
+
+    return rv;
+}
+
 int
 bcmpkt_flexhdr_header_name_get(bcmlrd_variant_t variant,
                                uint32_t hid, char **name)
@@ -333,6 +396,8 @@ bcmpkt_flexhdr_field_id_get(bcmlrd_variant_t variant, uint32_t hid,
 {
     int i;
     bcmpkt_flex_pmd_info_t *pmd_info = NULL;
+    bcmpkt_flex_field_metadata_t *info, *ent;
+    uint32_t slot;
 
     if ((name == NULL) || (fid == NULL)) {
         return SHR_E_PARAM;
@@ -357,9 +422,20 @@ bcmpkt_flexhdr_field_id_get(bcmlrd_variant_t variant, uint32_t hid,
         return SHR_E_UNAVAIL;
     }
 
+    info = pmd_info->field_info->info;
+    slot = name_cache_slot(name_hash(name), info);
+    ent = field_name_cache[slot];
+    if (ent > &info[BCMPKT_FID_INVALID] &&
+        ent < &info[pmd_info->field_info->num_fields] &&
+        sal_strcasecmp(ent->name, name) == 0) {
+        *fid = ent->fid;
+        return SHR_E_NONE;
+    }
+
     for (i = BCMPKT_FID_INVALID + 1; i < pmd_info->field_info->num_fields; i++) {
-        if (sal_strcasecmp(pmd_info->field_info->info[i].name, name) == 0) {
-            *fid = pmd_info->field_info->info[i].fid;
+        if (sal_strcasecmp(info[i].name, name) == 0) {
+            field_name_cache[slot] = &info[i];
+            *fid = info[i].fid;
             return SHR_E_NONE;
         }
     }
@@ -410,7 +486,7 @@ bcmpkt_rxpmd_flex_reasons_get(bcmlrd_variant_t variant,
         return SHR_E_PARAM;
     }
 
-    ret = bcmpkt_flexhdr_header_id_get(variant, "RXPMD_FLEX_T", &hid);
+    ret = rxpmd_flex_hid_get(variant, &hid);
     if (ret < 0) {
         return ret;
     }
@@ -444,7 +520,7 @@ bcmpkt_rxpmd_flex_reasons_set(bcmlrd_variant_t variant,
         return SHR_E_PARAM;
     }
 
-    ret = bcmpkt_flexhdr_header_id_get(variant, "RXPMD_FLEX_T", &hid);
+    ret = rxpmd_flex_hid_get(variant, &hid);
     if (ret < 0) {
         return ret;
     }
@@ -477,7 +553,7 @@ bcmpkt_rxpmd_flex_reason_name_get(bcmlrd_variant_t variant,
         return SHR_E_PARAM;
     }
 
-    ret = bcmpkt_flexhdr_header_id_get(variant, "RXPMD_FLEX_T", &hid);
+    ret = rxpmd_flex_hid_get(variant, &hid);
     if (ret < 0) {
         return ret;
     }
@@ -517,7 +593,7 @@ bcmpkt_rxpmd_flex_reason_max_get(bcmlrd_variant_t variant, uint32_t *num)
         return SHR_E_PARAM ;
     }
 
-    ret = bcmpkt_flexhdr_header_id_get(variant, "RXPMD_FLEX_T", &hid);
+    ret = rxpmd_flex_hid_get(variant, &hid);
     if (ret < 0) {
         return ret;
     }
@@ -543,14 +619,15 @@ bcmpkt_rxpmd_flex_reason_id_get(bcmlrd_variant_t variant,
 {
     int32_t ret = SHR_E_NONE;
     bcmpkt_flex_pmd_info_t *pmd_info = NULL;
+    shr_enum_map_t *names, *ent;
     int i;
-    uint32_t hid;
+    uint32_t hid, slot;
 
     if ((name == NULL) || (rid == NULL)) {
         return SHR_E_PARAM;
     }
 
-    ret = bcmpkt_flexhdr_header_id_get(variant, "RXPMD_FLEX_T", &hid);
+    ret = rxpmd_flex_hid_get(variant, &hid);
     if (ret < 0) {
         return ret;
     }
@@ -568,10 +645,20 @@ bcmpkt_rxpmd_flex_reason_id_get(bcmlrd_variant_t variant,
     if (pmd_info->reasons_info->reason_names == NULL) {
         return SHR_E_UNAVAIL;
     }
+    names = pmd_info->reasons_info->reason_names;
+    slot = name_cache_slot(name_hash(name), names);
+    ent = reason_name_cache[slot];
+    if (ent >= &names[0] &&
+        ent < &names[pmd_info->reasons_info->num_reasons] &&
+        sal_strcasecmp(ent->name, name) == 0) {
+        *rid = ent->val;
+        return SHR_E_NONE;
+    }
+
     for (i = 0; i < pmd_info->reasons_info->num_reasons; i++) {
-        if (sal_strcasecmp(pmd_info->reasons_info->reason_names[i].name,
-            name) == 0) {
-            *rid = pmd_info->reasons_info->reason_names[i].val;
+        if (sal_strcasecmp(names[i].name, name) == 0) {
+            reason_name_cache[slot] = &names[i];
+            *rid = names[i].val;
             return SHR_E_NONE;
         }
     }
@@ -51,6 +51,19 @@ static int bcmgenl_packet_qlen = BCMGENL_PACKET_QLEN_DFLT;
 MODULE_PARAM(bcmgenl_packet_qlen, int, 0);
 MODULE_PARM_DESC(bcmgenl_packet_qlen, "generic cb queue length (default 1024 buffers)");
 
+#define BCMGENL_PACKET_BATCH_DFLT 32
+static int bcmgenl_packet_batch = BCMGENL_PACKET_BATCH_DFLT;
+MODULE_PARAM(bcmgenl_packet_batch, int, 0);
+MODULE_PARM_DESC(bcmgenl_packet_batch, "generic cb pkts queued before delivery is kicked (default 32)");
+
+#define BCMGENL_PACKET_FLUSH_USECS_DFLT 100
+static int bcmgenl_packet_flush_usecs = BCMGENL_PACKET_FLUSH_USECS_DFLT;
+MODULE_PARAM(bcmgenl_packet_flush_usecs, int, 0);
+MODULE_PARM_DESC(bcmgenl_packet_flush_usecs, "generic cb max delay before delivering a partial batch (default 100 usecs)");
+
+/* Highest logical port in the port to ifindex table */
+#define BCMGENL_PACKET_PORT_MAX 1024
+
 #define FCS_SZ 4
 
 static bcmgenl_info_t g_bcmgenl_packet_info = {{0}};
@@ -77,6 +90,10 @@ typedef struct bcmgenl_packet_stats_s {
     unsigned long pkts_d_meta_srcport;
     unsigned long pkts_d_meta_dstport;
     unsigned long pkts_d_invalid_size;
+    unsigned long batches;
+    unsigned long batches_full;
+    unsigned long batches_timer;
+    unsigned long batch_pkts_hi;
 } bcmgenl_packet_stats_t;
 static bcmgenl_packet_stats_t g_bcmgenl_packet_stats = {0};
 
@@ -93,13 +110,27 @@ typedef struct genl_pkt_s {
     struct sk_buff *skb;
 } genl_pkt_t;
 
+/*
+ * Queued pkts are delivered in batches. The filter callback kicks the
+ * worker as soon as a full batch is queued, otherwise the worker runs
+ * once the flush timer expires, so a single lock acquisition and worker
+ * run covers many pkts at high trap rates.
+ */
 typedef struct bcmgenl_packet_work_s {
     struct list_head pkt_list;
-    struct work_struct wq;
+    struct delayed_work dwq;
     spinlock_t lock;
+    bool kicked;
 } bcmgenl_packet_work_t;
 static bcmgenl_packet_work_t g_bcmgenl_packet_work = {{0}};
 
+/*
+ * Logical port to ifindex map, maintained from the netif create and
+ * destroy callbacks so per-packet lookups are a single load. Entries hold
+ * the ifindex of the lowest netif ID on the port, 0 if there is none.
+ */
+static int g_bcmgenl_packet_port_ifindex[BCMGENL_PACKET_PORT_MAX];
+
 /* driver proc entry root */
 static struct proc_dir_entry *bcmgenl_packet_proc_root = NULL;
 
@@ -125,24 +156,38 @@ bcmgenl_packet_netif_lookup_by_ifindex(int ifindex)
     return (NULL);
 }
 
-static bcmgenl_netif_t *
-bcmgenl_packet_netif_lookup_by_port(int port)
+static int
+bcmgenl_packet_ifindex_lookup_by_port(int port)
+{
+    if (port < 0 || port >= BCMGENL_PACKET_PORT_MAX) {
+        return 0;
+    }
+    return READ_ONCE(g_bcmgenl_packet_port_ifindex[port]);
+}
+
+/*
+ * Recompute the ifindex of a port from the netif list.
+ * Called with g_bcmgenl_packet_info.lock held.
+ */
+static void
+bcmgenl_packet_port_ifindex_update(int port)
 {
     struct list_head *list;
-    bcmgenl_netif_t *bcmgenl_netif = NULL;
-    unsigned long flags;
+    bcmgenl_netif_t *bcmgenl_netif;
+    int ifindex = 0;
+
+    if (port < 0 || port >= BCMGENL_PACKET_PORT_MAX) {
+        return;
+    }
 
-    /* look for port from list of available net_devices */
-    spin_lock_irqsave(&g_bcmgenl_packet_info.lock, flags);
     list_for_each(list, &g_bcmgenl_packet_info.netif_list) {
         bcmgenl_netif = (bcmgenl_netif_t*)list;
-        if (bcmgenl_netif->port == port) {
-            spin_unlock_irqrestore(&g_bcmgenl_packet_info.lock, flags);
-            return bcmgenl_netif;
+        if (bcmgenl_netif->port == port && bcmgenl_netif->dev) {
+            ifindex = bcmgenl_netif->dev->ifindex;
+            break;
         }
     }
-    spin_unlock_irqrestore(&g_bcmgenl_packet_info.lock, flags);
-    return (NULL);
+    WRITE_ONCE(g_bcmgenl_packet_port_ifindex[port], ifindex);
 }
 
 static int
@@ -150,7 +195,6 @@ bcmgenl_packet_generic_meta_get(bcmgenl_pkt_t *bcmgenl_pkt, genl_packet_meta_t *
 {
     int srcport, dstport, dstport_type;
     int src_ifindex = 0, dst_ifindex = 0;
-    bcmgenl_netif_t *bcmgenl_netif = NULL;
 
     if (!bcmgenl_pkt || !genl_packet_meta) {
         GENL_DBG_WARN("%s: bcmgenl_pkt or genl_packet_meta is NULL\n", __func__);
@@ -168,9 +212,7 @@ bcmgenl_packet_generic_meta_get(bcmgenl_pkt_t *bcmgenl_pkt, genl_packet_meta_t *
 
     /* find src port netif (no need to lookup CPU port) */
     if (srcport != 0) {
-        if ((bcmgenl_netif = bcmgenl_packet_netif_lookup_by_port(srcport))) {
-            src_ifindex = bcmgenl_netif->dev->ifindex;
-        } else {
+        if ((src_ifindex = bcmgenl_packet_ifindex_lookup_by_port(srcport)) == 0) {
             src_ifindex = -1;
             g_bcmgenl_packet_stats.pkts_d_meta_srcport++;
             GENL_DBG_VERB("%s: could not find srcport(%d)\n", __func__, srcport);
@@ -184,9 +226,7 @@ bcmgenl_packet_generic_meta_get(bcmgenl_pkt_t *bcmgenl_pkt, genl_packet_meta_t *
         g_bcmgenl_packet_stats.pkts_f_dst_mc++;
     } else if (dstport != 0) {
         /* find dst port netif for UC pkts (no need to lookup CPU port) */
-        if ((bcmgenl_netif = bcmgenl_packet_netif_lookup_by_port(dstport))) {
-            dst_ifindex = bcmgenl_netif->dev->ifindex;
-        } else {
+        if ((dst_ifindex = bcmgenl_packet_ifindex_lookup_by_port(dstport)) == 0) {
             dst_ifindex = -1;
             g_bcmgenl_packet_stats.pkts_d_meta_dstport++;
             GENL_DBG_VERB("%s: could not find dstport(%d)\n", __func__, dstport);
@@ -358,7 +398,17 @@ bcmgenl_packet_filter_cb(struct sk_buff *skb, ngknet_filter_t **filt)
             g_bcmgenl_packet_stats.pkts_c_qlen_cur;
     }
 
-    schedule_work(&g_bcmgenl_packet_work.wq);
+    if (g_bcmgenl_packet_stats.pkts_c_qlen_cur >= bcmgenl_packet_batch) {
+        /* full batch, deliver now */
+        if (!g_bcmgenl_packet_work.kicked) {
+            g_bcmgenl_packet_work.kicked = true;
+            mod_delayed_work(system_wq, &g_bcmgenl_packet_work.dwq, 0);
+        }
+    } else {
+        /* no-op if the flush timer is already running */
+        schedule_delayed_work(&g_bcmgenl_packet_work.dwq,
+                              usecs_to_jiffies(bcmgenl_packet_flush_usecs));
+    }
     spin_unlock_irqrestore(&g_bcmgenl_packet_work.lock, flags);
 
     /*
@@ -389,41 +439,61 @@ static void
 bcmgenl_packet_task(struct work_struct *work)
 {
     bcmgenl_packet_work_t *packet_work =
-        container_of(work, bcmgenl_packet_work_t, wq);
+        container_of(to_delayed_work(work), bcmgenl_packet_work_t, dwq);
     unsigned long flags;
     struct list_head *list_ptr, *list_next;
+    LIST_HEAD(batch);
     genl_pkt_t *pkt;
+    unsigned long pkts = 0;
+    int batch_size = bcmgenl_packet_batch > 0 ?
+                     bcmgenl_packet_batch : BCMGENL_PACKET_BATCH_DFLT;
 
+    /* take everything queued so far in one go */
     spin_lock_irqsave(&packet_work->lock, flags);
-    list_for_each_safe(list_ptr, list_next, &packet_work->pkt_list) {
+    list_splice_init(&packet_work->pkt_list, &batch);
+    g_bcmgenl_packet_stats.pkts_c_qlen_cur = 0;
+    if (packet_work->kicked) {
+        g_bcmgenl_packet_stats.batches_full++;
+    } else {
+        g_bcmgenl_packet_stats.batches_timer++;
+    }
+    packet_work->kicked = false;
+    spin_unlock_irqrestore(&packet_work->lock, flags);
+
+    list_for_each_safe(list_ptr, list_next, &batch) {
         /* dequeue pkt from list */
         pkt = list_entry(list_ptr, genl_pkt_t, list);
         list_del(list_ptr);
-        g_bcmgenl_packet_stats.pkts_c_qlen_cur--;
-        spin_unlock_irqrestore(&packet_work->lock, flags);
 
         /* send generic_pkt to generic netlink */
-        if (pkt) {
-            GENL_DBG_VERB
-                ("%s: netns 0x%p, in_ifindex %d, out_ifindex %d, context 0x%08x\n",
-                 __func__,
-                 pkt->netns,
-                 pkt->meta.in_ifindex,
-                 pkt->meta.out_ifindex,
-                 pkt->meta.context);
-            genl_packet_send_packet(pkt->netns,
-                                    pkt->skb,
-                                    pkt->meta.in_ifindex,
-                                    pkt->meta.out_ifindex,
-                                    pkt->meta.context);
-            g_bcmgenl_packet_stats.pkts_f_packet_mod++;
-
-            dev_kfree_skb_any(pkt->skb);
-            kfree(pkt);
+        GENL_DBG_VERB
+            ("%s: netns 0x%p, in_ifindex %d, out_ifindex %d, context 0x%08x\n",
+             __func__,
+             pkt->netns,
+             pkt->meta.in_ifindex,
+             pkt->meta.out_ifindex,
+             pkt->meta.context);
+        genl_packet_send_packet(pkt->netns,
+                                pkt->skb,
+                                pkt->meta.in_ifindex,
+                                pkt->meta.out_ifindex,
+                                pkt->meta.context);
+        g_bcmgenl_packet_stats.pkts_f_packet_mod++;
+
+        dev_kfree_skb_any(pkt->skb);
+        kfree(pkt);
+
+        if ((++pkts % batch_size) == 0) {
+            cond_resched();
+        }
+    }
+
+    if (pkts) {
+        g_bcmgenl_packet_stats.batches++;
+        if (pkts > g_bcmgenl_packet_stats.batch_pkts_hi) {
+            g_bcmgenl_packet_stats.batch_pkts_hi = pkts;
         }
-        spin_lock_irqsave(&packet_work->lock, flags);
     }
-    spin_unlock_irqrestore(&packet_work->lock, flags);
 }
 
 static int
@@ -472,6 +542,7 @@ bcmgenl_packet_netif_create_cb(ngknet_dev_info_t *dinfo, ngknet_netif_t *netif)
         list_add_tail(&new_netif->list, &g_bcmgenl_packet_info.netif_list);
     }
     g_bcmgenl_packet_info.netif_count++;
+    bcmgenl_packet_port_ifindex_update(new_netif->port);
     spin_unlock_irqrestore(&g_bcmgenl_packet_info.lock, flags);
 
     GENL_DBG_VERB
@@ -486,6 +557,7 @@ bcmgenl_packet_netif_destroy_cb(ngknet_dev_info_t *dinfo, ngknet_netif_t *netif)
     struct list_head *list;
     bcmgenl_netif_t *lbcmgenl_netif;
     unsigned long flags;
+    int port;
 
     if (!dinfo || !netif) {
         GENL_DBG_WARN("%s: dinfo or netif is NULL\n", __func__);
@@ -502,11 +574,13 @@ bcmgenl_packet_netif_destroy_cb(ngknet_dev_info_t *dinfo, ngknet_netif_t *netif)
         lbcmgenl_netif = (bcmgenl_netif_t *)list;
         if (netif->id == lbcmgenl_netif->id) {
             found = true;
+            port = lbcmgenl_netif->port;
             list_del(&lbcmgenl_netif->list);
             GENL_DBG_VERB
                 ("%s: removing generic netif '%s'\n", __func__, netif->name);
             kfree(lbcmgenl_netif);
             g_bcmgenl_packet_info.netif_count--;
+            bcmgenl_packet_port_ifindex_update(port);
             break;
         }
     }
@@ -586,6 +660,13 @@ bcmgenl_packet_proc_stats_show(struct seq_file *m, void *v)
     seq_printf(m, "  pkts with invalid src port     %10lu\n", g_bcmgenl_packet_stats.pkts_d_meta_srcport);
     seq_printf(m, "  pkts with invalid dst port     %10lu\n", g_bcmgenl_packet_stats.pkts_d_meta_dstport);
     seq_printf(m, "  pkts with invalid orig pkt sz  %10lu\n", g_bcmgenl_packet_stats.pkts_d_invalid_size);
+    seq_printf(m, "  batches delivered              %10lu\n", g_bcmgenl_packet_stats.batches);
+    seq_printf(m, "  batches kicked when full       %10lu\n", g_bcmgenl_packet_stats.batches_full);
+    seq_printf(m, "  batches flushed by timer       %10lu\n", g_bcmgenl_packet_stats.batches_timer);
+    seq_printf(m, "  batch pkts average             %10lu\n",
+               g_bcmgenl_packet_stats.batches ?
+               g_bcmgenl_packet_stats.pkts_f_packet_mod / g_bcmgenl_packet_stats.batches : 0);
+    seq_printf(m, "  batch pkts high                %10lu\n", g_bcmgenl_packet_stats.batch_pkts_hi);
     return 0;
 }
 
@@ -642,6 +723,8 @@ bcmgenl_packet_proc_debug_show(struct seq_file *m, void *v)
     seq_printf(m, "  cdma_channels:   %d\n",   g_bcmgenl_packet_info.hw.cdma_channels);
     seq_printf(m, "  netif_count:     %d\n",   g_bcmgenl_packet_info.netif_count);
     seq_printf(m, "  queue length:    %d\n",   bcmgenl_packet_qlen);
+    seq_printf(m, "  batch size:      %d\n",   bcmgenl_packet_batch);
+    seq_printf(m, "  flush usecs:     %d\n",   bcmgenl_packet_flush_usecs);
 
     return 0;
 }
@@ -754,7 +837,7 @@ genl_cb_cleanup(void)
 {
     genl_pkt_t *pkt;
 
-    cancel_work_sync(&g_bcmgenl_packet_work.wq);
+    cancel_delayed_work_sync(&g_bcmgenl_packet_work.dwq);
 
     while (!list_empty(&g_bcmgenl_packet_work.pkt_list)) {
         pkt = list_entry(g_bcmgenl_packet_work.pkt_list.next,
@@ -782,7 +865,9 @@ genl_cb_init(void)
     /* setup generic work queue */
     spin_lock_init(&g_bcmgenl_packet_work.lock);
     INIT_LIST_HEAD(&g_bcmgenl_packet_work.pkt_list);
-    INIT_WORK(&g_bcmgenl_packet_work.wq, bcmgenl_packet_task);
+    INIT_DELAYED_WORK(&g_bcmgenl_packet_work.dwq, bcmgenl_packet_task);
+    memset(g_bcmgenl_packet_port_ifindex, 0,
+           sizeof(g_bcmgenl_packet_port_ifindex));
 
     /* get net namespace */
     g_bcmgenl_packet_info.netns = get_net_ns_by_pid(current->pid);
@@ -25,6 +25,7 @@
 
 #include <lkm/lkm.h>
 #include <lkm/ngbde_kapi.h>
+#include <linux/hrtimer.h>
 
 /*! Module name. */
 #define MOD_NAME        "linux_ngbde"
@@ -244,6 +245,27 @@ typedef struct ngbde_intr_ctrl_s {
     /*! Run user mode interrupt handler for this interrupt line. */
     bool run_user_isr;
 
+    /*! Eventfd for user mode interrupt notification. */
+    struct eventfd_ctx *evt_ctx;
+
+    /*! Latched interrupt events shared with user mode. */
+    struct ngbde_intr_evt_ring_s *evt_ring;
+
+    /*! Lock for event ring producer and notification state. */
+    spinlock_t evt_lock;
+
+    /*! Timer for time-based notification coalescing. */
+    struct hrtimer evt_timer;
+
+    /*! Events posted since the last notification. */
+    unsigned int evt_pend;
+
+    /*! Number of events to coalesce into one notification. */
+    unsigned int evt_coal_cnt;
+
+    /*! Maximum notification delay in microseconds. */
+    unsigned int evt_coal_usecs;
+
 } ngbde_intr_ctrl_t;
 
 /*! Convenience macro for 1 kilobyte. */
@@ -575,6 +597,54 @@ ngbde_intr_wait(int kdev, unsigned int irq_num);
 extern int
 ngbde_intr_stop(int kdev, unsigned int irq_num);
 
+/*!
+ * \brief Configure eventfd-based interrupt event delivery.
+ *
+ * Attach an eventfd to an interrupt line and allocate the event ring
+ * shared with user mode, or detach the eventfd if \c efd is negative.
+ *
+ * \param [in] kdev Device number.
+ * \param [in] irq_num Interrupt number (MSI vector).
+ * \param [in] efd Eventfd file descriptor or -1 to detach.
+ * \param [in] coal_cnt Number of events per notification.
+ * \param [in] coal_usecs Maximum notification delay in microseconds.
+ * \param [out] ring_addr Physical address of the event ring.
+ *
+ * \retval 0 No errors
+ * \retval -1 Something went wrong.
+ */
+extern int
+ngbde_intr_evt_set(int kdev, unsigned int irq_num, int efd,
+                   unsigned int coal_cnt, unsigned int coal_usecs,
+                   phys_addr_t *ring_addr);
+
+/*!
+ * \brief Post a software-triggered interrupt event.
+ *
+ * Runs the same event delivery path as a hardware interrupt, but
+ * without reading any interrupt registers.
+ *
+ * \param [in] kdev Device number.
+ * \param [in] irq_num Interrupt number (MSI vector).
+ *
+ * \retval 0 No errors
+ * \retval -1 Something went wrong.
+ */
+extern int
+ngbde_intr_evt_trigger(int kdev, unsigned int irq_num);
+
+/*!
+ * \brief Check if memory range is an interrupt event ring.
+ *
+ * \param [in] paddr Physical start address of memory range.
+ * \param [in] size Size of memory range.
+ *
+ * \retval true Range is valid.
+ * \retval false Range is not valid.
+ */
+extern bool
+ngbde_intr_evt_range_valid(unsigned long paddr, unsigned long size);
+
 /*!
  * \brief Clear list of interrupt status/mask registers.
  *
@@ -20,6 +20,10 @@
  * be found in the LICENSES folder.
  */
 
+#include <linux/eventfd.h>
+#include <linux/mutex.h>
+#include <lkm/ngbde_ioctl.h>
+
 #include <ngbde.h>
 
 /*! \cond */
@@ -29,6 +33,28 @@ MODULE_PARM_DESC(intr_debug,
 "Interrupt debug output enable (default 0).");
 /*! \endcond */
 
+/* Eventfd signal lost its count argument in Linux 6.8 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,8,0)
+#define NGBDE_EVENTFD_SIGNAL(_ctx) eventfd_signal(_ctx)
+#else
+#define NGBDE_EVENTFD_SIGNAL(_ctx) eventfd_signal(_ctx, 1)
+#endif
+
+/* Timer callback is passed at setup from Linux 6.13 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,13,0)
+#define NGBDE_HRTIMER_SETUP(_t, _f) \
+    hrtimer_setup(_t, _f, CLOCK_MONOTONIC, HRTIMER_MODE_REL)
+#else
+#define NGBDE_HRTIMER_SETUP(_t, _f)                             \
+    do {                                                        \
+        hrtimer_init(_t, CLOCK_MONOTONIC, HRTIMER_MODE_REL);    \
+        (_t)->function = _f;                                    \
+    } while (0)
+#endif
+
+/*! Serializes eventfd attach/detach, including the ring allocation. */
+static DEFINE_MUTEX(ngbde_intr_evt_mutex);
+
 /*!
  * \brief Shared register write.
  *
@@ -80,6 +106,141 @@ ngbde_intr_shared_write32(struct ngbde_dev_s *sd, struct ngbde_intr_ctrl_s *ic,
     return 0;
 }
 
+/*!
+ * \brief Signal user mode about posted interrupt events.
+ *
+ * Must be called with the event lock held.
+ *
+ * \param [in] ic Interrupt control information.
+ */
+static void
+ngbde_intr_evt_notify(ngbde_intr_ctrl_t *ic)
+{
+    ic->evt_pend = 0;
+    if (ic->evt_ctx) {
+        NGBDE_EVENTFD_SIGNAL(ic->evt_ctx);
+    }
+}
+
+/*!
+ * \brief Notification coalescing timer.
+ *
+ * \param [in] timer Event timer of the interrupt control structure.
+ *
+ * \retval HRTIMER_NORESTART Always.
+ */
+static enum hrtimer_restart
+ngbde_intr_evt_timer(struct hrtimer *timer)
+{
+    ngbde_intr_ctrl_t *ic = container_of(timer, ngbde_intr_ctrl_t, evt_timer);
+    unsigned long flags;
+
+    spin_lock_irqsave(&ic->evt_lock, flags);
+    if (ic->evt_pend) {
+        ngbde_intr_evt_notify(ic);
+    }
+    spin_unlock_irqrestore(&ic->evt_lock, flags);
+
+    return HRTIMER_NORESTART;
+}
+
+/*!
+ * \brief Post an interrupt event to the event ring.
+ *
+ * For hardware interrupts the user mode bits of all interrupt status
+ * registers are latched into the event, so that user mode can
+ * dispatch without reading the status registers again.
+ *
+ * The eventfd is signaled according to the coalescing settings.
+ *
+ * \param [in] ic Interrupt control information.
+ * \param [in] evt_flags Event flags (NGBDE_INTR_EVT_F_xxx).
+ */
+static void
+ngbde_intr_evt_post(ngbde_intr_ctrl_t *ic, uint32_t evt_flags)
+{
+    struct ngbde_intr_evt_ring_s *ring = ic->evt_ring;
+    struct ngbde_intr_evt_s *evt;
+    unsigned long flags;
+    uint32_t head, stat;
+    int idx;
+
+    spin_lock_irqsave(&ic->evt_lock, flags);
+
+    if (!ic->evt_ctx) {
+        spin_unlock_irqrestore(&ic->evt_lock, flags);
+        return;
+    }
+
+    head = ring->head;
+    if (head - READ_ONCE(ring->tail) >= NGBDE_INTR_EVT_RING_SIZE) {
+        ring->drops++;
+    } else {
+        evt = &ring->evt[head % NGBDE_INTR_EVT_RING_SIZE];
+        evt->tstamp = ktime_to_ns(ktime_get());
+        evt->flags = evt_flags;
+        evt->num_stat = 0;
+        if (!(evt_flags & NGBDE_INTR_EVT_F_SW)) {
+            for (idx = 0; idx < ic->num_regs; idx++) {
+                ngbde_irq_reg_t *ir = &ic->regs[idx];
+
+                evt->stat[idx] = 0;
+                if (ir->umask) {
+                    stat = NGBDE_IOREAD32(&ic->iomem[ir->status_reg]);
+                    if (!ir->status_is_masked) {
+                        /* Get enabled interrupts by applying mask register */
+                        stat &= NGBDE_IOREAD32(&ic->iomem[ir->mask_reg]);
+                    }
+                    evt->stat[idx] = stat & ir->umask;
+                }
+            }
+            evt->num_stat = ic->num_regs;
+        }
+        /* Publish the event before the producer index */
+        smp_wmb();
+        WRITE_ONCE(ring->head, head + 1);
+    }
+
+    if (++ic->evt_pend >= ic->evt_coal_cnt || ic->evt_coal_usecs == 0) {
+        hrtimer_try_to_cancel(&ic->evt_timer);
+        ngbde_intr_evt_notify(ic);
+    } else if (ic->evt_pend == 1) {
+        hrtimer_start(&ic->evt_timer,
+                      ns_to_ktime((u64)ic->evt_coal_usecs * NSEC_PER_USEC),
+                      HRTIMER_MODE_REL);
+    }
+
+    spin_unlock_irqrestore(&ic->evt_lock, flags);
+}
+
+/*!
+ * \brief Detach eventfd from interrupt line.
+ *
+ * \param [in] ic Interrupt control information.
+ */
+static void
+ngbde_intr_evt_detach(ngbde_intr_ctrl_t *ic)
+{
+    struct eventfd_ctx *ctx;
+    unsigned long flags;
+
+    if (!ic->evt_ring) {
+        return;
+    }
+
+    spin_lock_irqsave(&ic->evt_lock, flags);
+    ctx = ic->evt_ctx;
+    ic->evt_ctx = NULL;
+    ic->evt_pend = 0;
+    spin_unlock_irqrestore(&ic->evt_lock, flags);
+
+    hrtimer_cancel(&ic->evt_timer);
+
+    if (ctx) {
+        eventfd_ctx_put(ctx);
+    }
+}
+
 /*!
  * \brief Interrupt handler for user mode thread.
  *
@@ -134,6 +295,11 @@ ngbde_user_isr(ngbde_intr_ctrl_t *ic)
         }
     }
 
+    /* Latch the status for user mode before the interrupts are masked */
+    if (ic->evt_ctx) {
+        ngbde_intr_evt_post(ic, 0);
+    }
+
     /* Disable (mask off) all user mode interrupts */
     for (idx = 0; idx < ic->num_regs; idx++) {
         ngbde_irq_reg_t *ir = &ic->regs[idx];
@@ -511,6 +677,10 @@ ngbde_intr_disconnect(int kdev, unsigned int irq_num)
         free_irq(ic->irq_vect, ic);
     }
 
+    mutex_lock(&ngbde_intr_evt_mutex);
+    ngbde_intr_evt_detach(ic);
+    mutex_unlock(&ngbde_intr_evt_mutex);
+
     ic->irq_active = 0;
     sd->active_irqs--;
 
@@ -534,7 +704,146 @@ ngbde_intr_cleanup(void)
             ngbde_intr_disconnect(idx, irq_num);
         }
         ngbde_intr_free(idx);
+        for (irq_num = 0; irq_num < NGBDE_NUM_IRQS_MAX; irq_num++) {
+            ngbde_intr_ctrl_t *ic = &swdev[idx].intr_ctrl[irq_num];
+
+            mutex_lock(&ngbde_intr_evt_mutex);
+            if (ic->evt_ring) {
+                ngbde_intr_evt_detach(ic);
+                ClearPageReserved(virt_to_page(ic->evt_ring));
+                free_page((unsigned long)ic->evt_ring);
+                ic->evt_ring = NULL;
+            }
+            mutex_unlock(&ngbde_intr_evt_mutex);
+        }
+    }
+}
+
+int
+ngbde_intr_evt_set(int kdev, unsigned int irq_num, int efd,
+                   unsigned int coal_cnt, unsigned int coal_usecs,
+                   phys_addr_t *ring_addr)
+{
+    struct ngbde_dev_s *sd;
+    struct ngbde_intr_ctrl_s *ic;
+    struct eventfd_ctx *ctx = NULL;
+    unsigned long flags;
+
+    sd = ngbde_swdev_get(kdev);
+    if (!sd) {
+        return -1;
+    }
+
+    if (irq_num >= NGBDE_NUM_IRQS_MAX) {
+        return -1;
+    }
+
+    ic = &sd->intr_ctrl[irq_num];
+
+    if (efd >= 0) {
+        ctx = eventfd_ctx_fdget(efd);
+        if (IS_ERR(ctx)) {
+            printk(KERN_WARNING "%s: Invalid eventfd %d for device %d\n",
+                   MOD_NAME, efd, kdev);
+            return -1;
+        }
+    }
+
+    mutex_lock(&ngbde_intr_evt_mutex);
+
+    if (!ic->evt_ring) {
+        if (!ctx) {
+            mutex_unlock(&ngbde_intr_evt_mutex);
+            return 0;
+        }
+        ic->evt_ring = (struct ngbde_intr_evt_ring_s *)get_zeroed_page(GFP_KERNEL);
+        if (!ic->evt_ring) {
+            mutex_unlock(&ngbde_intr_evt_mutex);
+            eventfd_ctx_put(ctx);
+            return -1;
+        }
+        /* The ring is mapped to user space via the BDE device file */
+        SetPageReserved(virt_to_page(ic->evt_ring));
+        spin_lock_init(&ic->evt_lock);
+        NGBDE_HRTIMER_SETUP(&ic->evt_timer, ngbde_intr_evt_timer);
+    }
+
+    ngbde_intr_evt_detach(ic);
+
+    if (ctx) {
+        spin_lock_irqsave(&ic->evt_lock, flags);
+        ic->evt_ring->head = 0;
+        ic->evt_ring->tail = 0;
+        ic->evt_ring->drops = 0;
+        ic->evt_coal_cnt = coal_cnt ? coal_cnt : 1;
+        ic->evt_coal_usecs = coal_usecs;
+        ic->evt_ctx = ctx;
+        spin_unlock_irqrestore(&ic->evt_lock, flags);
+    }
+
+    if (intr_debug) {
+        printk("INTR: %s eventfd (%d) [cnt:%u,usecs:%u]\n",
+               ctx ? "Attached" : "Detached", irq_num, coal_cnt, coal_usecs);
+    }
+
+    *ring_addr = virt_to_phys(ic->evt_ring);
+
+    mutex_unlock(&ngbde_intr_evt_mutex);
+
+    return 0;
+}
+
+int
+ngbde_intr_evt_trigger(int kdev, unsigned int irq_num)
+{
+    struct ngbde_dev_s *sd;
+    struct ngbde_intr_ctrl_s *ic;
+
+    sd = ngbde_swdev_get(kdev);
+    if (!sd) {
+        return -1;
+    }
+
+    if (irq_num >= NGBDE_NUM_IRQS_MAX) {
+        return -1;
+    }
+
+    ic = &sd->intr_ctrl[irq_num];
+
+    if (!ic->evt_ctx) {
+        return -1;
+    }
+
+    if (intr_debug >= 2) {
+        printk("INTR: Software trigger (%d)\n", irq_num);
+    }
+    ngbde_intr_evt_post(ic, NGBDE_INTR_EVT_F_SW);
+
+    return 0;
+}
+
+bool
+ngbde_intr_evt_range_valid(unsigned long paddr, unsigned long size)
+{
+    struct ngbde_dev_s *swdev;
+    unsigned int num_swdev, idx, irq_num;
+    struct ngbde_intr_ctrl_s *ic;
+
+    if (size > PAGE_SIZE) {
+        return false;
+    }
+
+    ngbde_swdev_get_all(&swdev, &num_swdev);
+
+    for (idx = 0; idx < num_swdev; idx++) {
+        for (irq_num = 0; irq_num < NGBDE_NUM_IRQS_MAX; irq_num++) {
+            ic = &swdev[idx].intr_ctrl[irq_num];
+            if (ic->evt_ring && paddr == virt_to_phys(ic->evt_ring)) {
+                return true;
+            }
+        }
     }
+    return false;
 }
 
 int
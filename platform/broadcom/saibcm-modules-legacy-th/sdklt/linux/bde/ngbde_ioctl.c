@@ -47,7 +47,7 @@ ngbde_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
     switch (cmd) {
     case NGBDE_IOC_MOD_INFO:
         ioc.op.mod_info.version = NGBDE_IOC_VERSION;
-        ioc.op.mod_info.compat = NGBDE_COMPAT_IRQ_INIT;
+        ioc.op.mod_info.compat = NGBDE_COMPAT_IRQ_INIT | NGBDE_COMPAT_INTR_EVT;
         break;
     case NGBDE_IOC_PROBE_INFO:
         ngbde_swdev_get_all(NULL, &num_swdev);
@@ -143,6 +143,11 @@ ngbde_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
                 ioc.rc = NGBDE_IOC_FAIL;
             }
             break;
+        case NGBDE_ICTL_INTR_TRIG:
+            if (ngbde_intr_evt_trigger(ioc.devid, irq_num) < 0) {
+                ioc.rc = NGBDE_IOC_FAIL;
+            }
+            break;
         default:
             printk(KERN_WARNING
                    "%s: unknown interrupt control command (%d)\n",
@@ -222,6 +227,19 @@ ngbde_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
             ioc.op.irq_init.irq_max = rv;
         }
         break;
+    case NGBDE_IOC_INTR_EVT_SET:
+        irq_num = ioc.op.intr_evt.irq_num;
+        if (ngbde_intr_evt_set(ioc.devid, irq_num, ioc.op.intr_evt.efd,
+                               ioc.op.intr_evt.coal_cnt,
+                               ioc.op.intr_evt.coal_usecs, &addr) < 0) {
+            printk(KERN_WARNING
+                   "%s: Unable to configure interrupt events\n",
+                   MOD_NAME);
+            ioc.rc = NGBDE_IOC_FAIL;
+            break;
+        }
+        ioc.op.intr_evt.ring_addr = addr;
+        break;
     case NGBDE_IOC_PIO_WIN_MAP:
         swdev = ngbde_swdev_get(ioc.devid);
         if (!swdev) {
@@ -201,6 +201,10 @@ ngbde_mmap(struct file *filp, struct vm_area_struct *vma)
 
     if (ngbde_dma_range_valid(paddr, size)) {
         range_valid = 1;
+    } else if (ngbde_intr_evt_range_valid(paddr, size)) {
+        /* Interrupt event ring is only accessed by the CPU */
+        map_noncached = 0;
+        range_valid = 1;
     } else {
         map_noncached = 1;
         if (ngbde_pio_range_valid(paddr, size)) {
@@ -85,6 +85,9 @@
 /*! Initialize kernel interrupt driver. */
 #define NGBDE_IOC_IRQ_INIT      _IOW(NGBDE_IOC_MAGIC, 11, __u64)
 
+/*! Configure eventfd-based interrupt event delivery. */
+#define NGBDE_IOC_INTR_EVT_SET  _IOW(NGBDE_IOC_MAGIC, 12, __u64)
+
 /*! \} */
 
 /*! IOCTL command return code for success. */
@@ -107,6 +110,9 @@
 /*! Support for IRQ_INIT IOCTL command. */
 #define NGBDE_COMPAT_IRQ_INIT   (1 << 0)
 
+/*! Support for INTR_EVT_SET IOCTL command and the event ring. */
+#define NGBDE_COMPAT_INTR_EVT   (1 << 1)
+
 /*! \} */
 
 /*! Kernel module information. */
@@ -255,6 +261,9 @@ struct ngbde_ioc_irq_init_s {
 /*! Clear list of interrupt status/mask registers. */
 #define NGBDE_ICTL_REGS_CLR     4
 
+/*! Post a software-triggered event to the interrupt event ring. */
+#define NGBDE_ICTL_INTR_TRIG    5
+
 /*! \} */
 
 /*! Interrupt control operation. */
@@ -381,6 +390,93 @@ struct ngbde_ioc_irq_mask_wr_s {
     __u32 val;
 };
 
+/*!
+ * \brief Interrupt event delivery configuration.
+ *
+ * When an eventfd is attached to an interrupt line, the user mode
+ * ISR latches the user mode interrupt status words into an event ring
+ * before masking the interrupts, and then signals the eventfd. The
+ * event ring (\ref ngbde_intr_evt_ring_s) is mapped into user space
+ * by calling mmap on the BDE device file with the returned physical
+ * address as the offset.
+ *
+ * The eventfd is signaled once \c coal_cnt events have been posted,
+ * or \c coal_usecs microseconds after the first unsignaled event,
+ * whichever comes first. If \c coal_usecs is zero, every event is
+ * signaled immediately.
+ */
+struct ngbde_ioc_intr_evt_s {
+
+    /*! Interrupt instance for this device. */
+    __u32 irq_num;
+
+    /*! Eventfd file descriptor, or -1 to detach. */
+    __s32 efd;
+
+    /*! Number of events to coalesce into one notification. */
+    __u32 coal_cnt;
+
+    /*! Maximum notification delay in microseconds. */
+    __u32 coal_usecs;
+
+    /*! Physical address of the event ring (output). */
+    __u64 ring_addr;
+};
+
+/*! Maximum number of status words latched per interrupt event. */
+#define NGBDE_INTR_EVT_STAT_MAX         16
+
+/*! Number of entries in the interrupt event ring (power of two). */
+#define NGBDE_INTR_EVT_RING_SIZE        32
+
+/*! Event was posted by \ref NGBDE_ICTL_INTR_TRIG. */
+#define NGBDE_INTR_EVT_F_SW             (1 << 0)
+
+/*! Latched interrupt event. */
+struct ngbde_intr_evt_s {
+
+    /*! Kernel monotonic time of the interrupt in nanoseconds. */
+    __u64 tstamp;
+
+    /*! Number of valid status words. */
+    __u32 num_stat;
+
+    /*! Event flags (\ref NGBDE_INTR_EVT_F_SW). */
+    __u32 flags;
+
+    /*!
+     * User mode bits of each interrupt status register, in the order
+     * the registers were added.
+     */
+    __u32 stat[NGBDE_INTR_EVT_STAT_MAX];
+};
+
+/*!
+ * \brief Interrupt event ring shared with user space.
+ *
+ * The kernel advances \c head after writing an event and user space
+ * advances \c tail after consuming one. Both indexes are
+ * free-running, and the entry index is the index modulo \ref
+ * NGBDE_INTR_EVT_RING_SIZE.
+ */
+struct ngbde_intr_evt_ring_s {
+
+    /*! Producer index (written by the kernel). */
+    __u32 head;
+
+    /*! Consumer index (written by user space). */
+    __u32 tail;
+
+    /*! Number of events dropped because the ring was full. */
+    __u32 drops;
+
+    /*! Reserved. */
+    __u32 rsvd;
+
+    /*! Event entries. */
+    struct ngbde_intr_evt_s evt[NGBDE_INTR_EVT_RING_SIZE];
+};
+
 /*! IOCTL operation data. */
 union ngbde_ioc_op_s {
 
@@ -416,6 +512,9 @@ union ngbde_ioc_op_s {
 
     /*! Map device registers in kernel space. */
     struct ngbde_ioc_pio_win_s pio_win;
+
+    /*! Configure interrupt event delivery. */
+    struct ngbde_ioc_intr_evt_s intr_evt;
 };
 
 /*! IOCTL command message. */
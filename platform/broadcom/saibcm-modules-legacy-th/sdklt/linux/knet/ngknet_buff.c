@@ -48,6 +48,97 @@ ngknet_ring_buf_free(struct pdma_dev *dev, uint32_t size, void *addr, dma_addr_t
     dma_free_coherent(kdev->dev, size, addr, dma);
 }
 
+#if NGKNET_PAGE_POOL
+/*!
+ * Destroy Rx page pools of a channel
+ */
+static void
+ngknet_rx_pool_destroy(struct ngknet_dev *kdev, int chan)
+{
+    /* Pages still held by SKBs are released when they come back */
+    if (kdev->rx_ring_pool[chan] && kdev->rx_ring_pool[chan] != kdev->rx_pool[chan]) {
+        page_pool_destroy((struct page_pool *)kdev->rx_ring_pool[chan]);
+    }
+    if (kdev->rx_pool[chan]) {
+        page_pool_destroy((struct page_pool *)kdev->rx_pool[chan]);
+    }
+    kdev->rx_ring_pool[chan] = NULL;
+    kdev->rx_pool[chan] = NULL;
+}
+
+/*!
+ * Set Rx page pool for new buffers of a channel
+ *
+ * A pool which still backs the buffers on the ring is kept until those
+ * buffers are released, see ngknet_rx_pool_sync().
+ */
+static void
+ngknet_rx_pool_set(struct ngknet_dev *kdev, int chan, void *pool)
+{
+    if (kdev->rx_pool[chan] && kdev->rx_pool[chan] != kdev->rx_ring_pool[chan]) {
+        page_pool_destroy((struct page_pool *)kdev->rx_pool[chan]);
+    }
+    kdev->rx_pool[chan] = pool;
+}
+
+/*!
+ * Switch the ring over to the current Rx page pool
+ *
+ * This is called when a buffer is allocated, at which point the buffers
+ * from a replaced pool have all been released by the queue.
+ */
+static void
+ngknet_rx_pool_sync(struct ngknet_dev *kdev, int chan)
+{
+    if (kdev->rx_ring_pool[chan] == kdev->rx_pool[chan]) {
+        return;
+    }
+    if (kdev->rx_ring_pool[chan]) {
+        page_pool_destroy((struct page_pool *)kdev->rx_ring_pool[chan]);
+    }
+    kdev->rx_ring_pool[chan] = kdev->rx_pool[chan];
+}
+
+/*!
+ * Create Rx page pool for a queue
+ *
+ * The pool keeps its pages DMA mapped and syncs only the receive area
+ * when a page is recycled, so a refill costs neither a page allocation
+ * nor a mapping as long as the stack returns the SKBs in time.
+ */
+static int
+ngknet_rx_pool_create(struct ngknet_dev *kdev, struct pdma_rx_queue *rxq)
+{
+    struct page_pool_params pp = {0};
+    struct page_pool *pool;
+
+    /* Keep the pool as is if its buffer layout does not change */
+    pool = (struct page_pool *)kdev->rx_pool[rxq->chan_id];
+    if (pool && pool->p.order == rxq->page_order &&
+        pool->p.max_len == rxq->buf_size + PDMA_RXB_META) {
+        return SHR_E_NONE;
+    }
+
+    pp.order = rxq->page_order;
+    pp.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+    pp.pool_size = rxq->nb_desc ? rxq->nb_desc : 256;
+    pp.nid = dev_to_node(kdev->dev);
+    pp.dev = kdev->dev;
+    pp.dma_dir = DMA_FROM_DEVICE;
+    pp.offset = PDMA_RXB_RESV;
+    pp.max_len = rxq->buf_size + PDMA_RXB_META;
+
+    pool = page_pool_create(&pp);
+    if (IS_ERR(pool)) {
+        ngknet_rx_pool_set(kdev, rxq->chan_id, NULL);
+        return SHR_E_MEMORY;
+    }
+    ngknet_rx_pool_set(kdev, rxq->chan_id, pool);
+
+    return SHR_E_NONE;
+}
+#endif /* NGKNET_PAGE_POOL */
+
 /*!
  * Allocate Rx buffer
  */
@@ -56,11 +147,26 @@ ngknet_rx_buf_alloc(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
                     struct pdma_rx_buf *pbuf)
 {
     struct ngknet_dev *kdev = (struct ngknet_dev *)dev->priv;
+    struct ngknet_rxb_stats *rxbs = &kdev->rxb_stats[rxq->chan_id];
     dma_addr_t dma;
     struct page *page;
     struct sk_buff *skb;
 
     if (rxq->buf_mode == PDMA_BUF_MODE_PAGE) {
+#if NGKNET_PAGE_POOL
+        ngknet_rx_pool_sync(kdev, rxq->chan_id);
+        if (kdev->rx_pool[rxq->chan_id]) {
+            page = page_pool_dev_alloc_pages((struct page_pool *)kdev->rx_pool[rxq->chan_id]);
+            if (unlikely(!page)) {
+                return SHR_E_MEMORY;
+            }
+            pbuf->dma = page_pool_get_dma_addr(page);
+            pbuf->page = page;
+            pbuf->page_offset = 0;
+            rxbs->allocs++;
+            return SHR_E_NONE;
+        }
+#endif
         page = kal_dev_alloc_pages(rxq->page_order);
         if (unlikely(!page)) {
             return SHR_E_MEMORY;
@@ -89,6 +195,8 @@ ngknet_rx_buf_alloc(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
         }
         pbuf->dma = dma;
     }
+    rxbs->allocs++;
+    rxbs->maps++;
 
     return SHR_E_NONE;
 }
@@ -116,11 +224,65 @@ ngknet_rx_buf_avail(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
 {
     if (rxq->buf_mode == PDMA_BUF_MODE_PAGE) {
         pbuf->skb = NULL;
+    } else if (pbuf->hold_skb) {
+        /* Copy-break SKB has been sent up, take back the mapped one */
+        pbuf->skb = pbuf->hold_skb;
+        pbuf->pkb = (struct pkt_buf *)pbuf->skb->data;
+        pbuf->hold_skb = NULL;
     }
 
     return (pbuf->dma != 0);
 }
 
+/*!
+ * Copy a small packet out of the Rx buffer
+ *
+ * The packet is copied into a new SKB which is sent up instead, and the
+ * original buffer stays mapped for the next descriptor.
+ */
+static struct pkt_hdr *
+ngknet_rx_buf_copy(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
+                   struct pdma_rx_buf *pbuf, int len)
+{
+    struct ngknet_dev *kdev = (struct ngknet_dev *)dev->priv;
+    struct sk_buff *skb;
+    struct pkt_buf *pkb;
+    dma_addr_t dma;
+    unsigned int offset;
+    uint8_t *data;
+
+    skb = netdev_alloc_skb(kdev->net_dev, PDMA_RXB_RESV + pbuf->adj + len);
+    if (unlikely(!skb)) {
+        return NULL;
+    }
+    skb_reserve(skb, PDMA_RXB_ALIGN - (((unsigned long)skb->data) & (PDMA_RXB_ALIGN - 1)));
+    pkb = (struct pkt_buf *)skb->data;
+
+    if (rxq->buf_mode == PDMA_BUF_MODE_PAGE) {
+        dma = pbuf->dma;
+        offset = pbuf->page_offset + PDMA_RXB_RESV + pbuf->adj;
+        data = (uint8_t *)page_address(pbuf->page) + offset;
+    } else {
+        dma = pbuf->dma;
+        offset = 0;
+        data = &pbuf->pkb->data + pbuf->adj;
+    }
+    dma_sync_single_range_for_cpu(kdev->dev, dma, offset, len, DMA_FROM_DEVICE);
+    memcpy(&pkb->data + pbuf->adj, data, len);
+    dma_sync_single_range_for_device(kdev->dev, dma, offset, len, DMA_FROM_DEVICE);
+
+    if (rxq->buf_mode != PDMA_BUF_MODE_PAGE) {
+        pbuf->hold_skb = pbuf->skb;
+    }
+    pbuf->skb = skb;
+    pbuf->pkb = pkb;
+    skb_put(skb, PKT_HDR_SIZE + pbuf->adj + len);
+    kdev->rxb_stats[rxq->chan_id].copies++;
+    kdev->rxb_stats[rxq->chan_id].reuses++;
+
+    return &pkb->pkh;
+}
+
 /*!
  * Get Rx buffer
  */
@@ -129,20 +291,55 @@ ngknet_rx_buf_get(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
                   struct pdma_rx_buf *pbuf, int len)
 {
     struct ngknet_dev *kdev = (struct ngknet_dev *)dev->priv;
+    struct ngknet_rxb_stats *rxbs = &kdev->rxb_stats[rxq->chan_id];
     struct sk_buff *skb;
     uint32_t pages_size;
+    int copybreak;
+
+    if (pbuf->hold_skb) {
+        return &pbuf->pkb->pkh;
+    }
+
+    copybreak = ngknet_rx_copybreak_get();
+    if (copybreak > 0 && dev->mode == DEV_MODE_KNET && pbuf->dma &&
+        len <= copybreak + (int)dev->rx_ph_size &&
+        (rxq->buf_mode != PDMA_BUF_MODE_PAGE || !pbuf->skb)) {
+        if (ngknet_rx_buf_copy(dev, rxq, pbuf, len)) {
+            return &pbuf->pkb->pkh;
+        }
+        /* Fall back to sending the buffer itself up */
+    }
 
     if (rxq->buf_mode == PDMA_BUF_MODE_PAGE) {
         if (pbuf->skb) {
             return &pbuf->pkb->pkh;
         }
+        pages_size = PAGE_SIZE * (1 << rxq->page_order);
+#if NGKNET_PAGE_POOL
+        if (kdev->rx_ring_pool[rxq->chan_id]) {
+            skb = kal_build_skb(page_address(pbuf->page), pages_size);
+            if (unlikely(!skb)) {
+                return NULL;
+            }
+            skb_reserve(skb, PDMA_RXB_ALIGN);
+            dma_sync_single_range_for_cpu(kdev->dev, pbuf->dma,
+                                          PDMA_RXB_RESV + pbuf->adj, len,
+                                          DMA_FROM_DEVICE);
+            /* The page goes back to the pool when the SKB is freed */
+            skb_mark_for_recycle(skb);
+            pbuf->skb = skb;
+            pbuf->pkb = (struct pkt_buf *)skb->data;
+            pbuf->dma = 0;
+            skb_put(skb, PKT_HDR_SIZE + pbuf->adj + len);
+            return &pbuf->pkb->pkh;
+        }
+#endif
         skb = kal_build_skb(page_address(pbuf->page) + pbuf->page_offset,
                             PDMA_RXB_SIZE(rxq->buf_size + pbuf->adj));
         if (unlikely(!skb)) {
             return NULL;
         }
         skb_reserve(skb, PDMA_RXB_ALIGN);
-        pages_size = PAGE_SIZE * (1 << rxq->page_order);
         dma_sync_single_range_for_cpu(kdev->dev, pbuf->dma, pbuf->page_offset,
                                       pages_size >> 1, DMA_FROM_DEVICE);
         pbuf->skb = skb;
@@ -160,6 +357,7 @@ ngknet_rx_buf_get(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
             page_ref_inc(pbuf->page);
             dma_sync_single_range_for_device(kdev->dev, pbuf->dma, pbuf->page_offset,
                                              pages_size >> 1, DMA_FROM_DEVICE);
+            rxbs->reuses++;
         }
     } else {
         if (!pbuf->dma) {
@@ -188,6 +386,9 @@ ngknet_rx_buf_put(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
 
     if (rxq->buf_mode == PDMA_BUF_MODE_PAGE) {
         dev_kfree_skb_any(pbuf->skb);
+    } else if (pbuf->hold_skb) {
+        /* Drop the copy, the mapped buffer is taken back by rx_buf_avail */
+        dev_kfree_skb_any(pbuf->skb);
     } else {
         skb = pbuf->skb;
         if (pbuf->pkb != (struct pkt_buf *)skb->data) {
@@ -204,6 +405,8 @@ ngknet_rx_buf_put(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
         }
         pbuf->dma = dma;
         skb_trim(skb, 0);
+        kdev->rxb_stats[rxq->chan_id].maps++;
+        kdev->rxb_stats[rxq->chan_id].reuses++;
     }
 
     return SHR_E_NONE;
@@ -223,11 +426,26 @@ ngknet_rx_buf_free(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
         if (!pbuf->page) {
             return;
         }
+#if NGKNET_PAGE_POOL
+        /* The buffer goes back to the pool it was allocated from */
+        if (kdev->rx_ring_pool[rxq->chan_id]) {
+            if (pbuf->dma) {
+                page_pool_put_full_page((struct page_pool *)kdev->rx_ring_pool[rxq->chan_id],
+                                        pbuf->page, false);
+            }
+            goto done;
+        }
+#endif
         pages_size = PAGE_SIZE * (1 << rxq->page_order);
         kal_dma_unmap_page_attrs(kdev->dev, pbuf->dma, pages_size, DMA_FROM_DEVICE,
                                  DMA_ATTR_SKIP_CPU_SYNC | DMA_ATTR_WEAK_ORDERING);
         __free_pages(pbuf->page, rxq->page_order);
     } else {
+        if (pbuf->hold_skb) {
+            dev_kfree_skb_any(pbuf->skb);
+            pbuf->skb = pbuf->hold_skb;
+            pbuf->hold_skb = NULL;
+        }
         if (!pbuf->skb) {
             return;
         }
@@ -235,6 +453,9 @@ ngknet_rx_buf_free(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
         dev_kfree_skb_any(pbuf->skb);
     }
 
+#if NGKNET_PAGE_POOL
+done:
+#endif
     pbuf->dma = 0;
     pbuf->page = NULL;
     pbuf->page_offset = 0;
@@ -249,13 +470,34 @@ ngknet_rx_buf_free(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
 static enum buf_mode
 ngknet_rx_buf_mode(struct pdma_dev *dev, struct pdma_rx_queue *rxq)
 {
+    struct ngknet_dev *kdev = (struct ngknet_dev *)dev->priv;
     uint32_t len, order;
 
+    sal_memset(&kdev->rxb_stats[rxq->chan_id], 0, sizeof(kdev->rxb_stats[0]));
+
     if (ngknet_page_buffer_mode_get() == 0) {
         return PDMA_BUF_MODE_SKB;
     }
 
     len = dev->rx_ph_size ? rxq->buf_size : rxq->buf_size + PDMA_RXB_META;
+
+#if NGKNET_PAGE_POOL
+    if (ngknet_rx_page_pool_get()) {
+        /* One buffer per page, the pool recycles whole pages */
+        for (order = 0; order < 32; order++) {
+            if (PDMA_RXB_SIZE(len) <= PAGE_SIZE * (1 << order)) {
+                rxq->page_order = order;
+                break;
+            }
+        }
+        if (SHR_SUCCESS(ngknet_rx_pool_create(kdev, rxq))) {
+            return PDMA_BUF_MODE_PAGE;
+        }
+    } else {
+        ngknet_rx_pool_set(kdev, rxq->chan_id, NULL);
+    }
+#endif
+
     for (order = 0; order < 32; order++) {
         if (PDMA_RXB_SIZE(len) * 2 <= PAGE_SIZE * (1 << order)) {
             rxq->page_order = order;
@@ -349,3 +591,16 @@ bcmcnet_buf_mngr_init(struct pdma_dev *dev)
     dev->ctrl.buf_mngr = (struct pdma_buf_mngr *)&buf_mngr;
 }
 
+void
+ngknet_rx_buf_pool_cleanup(struct pdma_dev *dev)
+{
+#if NGKNET_PAGE_POOL
+    struct ngknet_dev *kdev = (struct ngknet_dev *)dev->priv;
+    int chan;
+
+    for (chan = 0; chan < NUM_Q_MAX; chan++) {
+        ngknet_rx_pool_destroy(kdev, chan);
+    }
+#endif
+}
+
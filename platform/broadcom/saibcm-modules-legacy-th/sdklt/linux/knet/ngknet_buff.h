@@ -50,6 +50,9 @@ struct pdma_rx_buf {
     /*! Rx SKB */
     struct sk_buff *skb;
 
+    /*! Rx SKB kept mapped while a copy-break SKB is sent up */
+    struct sk_buff *hold_skb;
+
     /*! Packet buffer point */
     struct pkt_buf *pkb;
 
@@ -77,5 +80,15 @@ struct pdma_tx_buf {
     uint32_t adj;
 };
 
+/*!
+ * \brief Release Rx buffer pools.
+ *
+ * Called once all Rx buffers of the device have been freed.
+ *
+ * \param [in] dev Device structure point.
+ */
+extern void
+ngknet_rx_buf_pool_cleanup(struct pdma_dev *dev);
+
 #endif /* NGKNET_BUFF_H */
 
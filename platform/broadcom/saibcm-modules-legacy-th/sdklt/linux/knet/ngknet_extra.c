@@ -43,6 +43,10 @@
 #include <linux/delay.h>
 #include <linux/bitops.h>
 #include <linux/time.h>
+#include <linux/rcupdate.h>
+#include <linux/sched.h>
+#include <linux/percpu.h>
+#include <linux/ktime.h>
 
 #include <lkm/ngknet_dev.h>
 #include <lkm/ngknet_kapi.h>
@@ -55,6 +59,12 @@
 /*! Defalut Rx tick for Rx rate limit control. */
 #define NGKNET_EXTRA_RATE_LIMIT_DEFAULT_RX_TICK 10
 
+/*! Filter lookups per RCU read-side section in the filter benchmark. */
+#define NGKNET_FILTER_BENCH_CHUNK 4096
+
+/*! Timed lookups of one packet in the filter benchmark. */
+#define NGKNET_FILTER_BENCH_BURST 64
+
 /*!
  * SKB replicate mode when multiple filter hits, default to use skb_copy to be
  * safe.
@@ -144,18 +154,49 @@ ngknet_filter_callback(struct ngknet_dev *dev, struct filt_ctrl *fc,
     return SHR_E_NONE;
 }
 
-static inline bool
-ngknet_filter_match(struct ngknet_dev *dev, int chan_id,
-                    struct sk_buff *skb, ngknet_filter_t *filt)
+/*
+ * Get a match word straight from the packet buffer. The words are laid out
+ * as the filter data, i.e. OOB bytes followed by packet bytes.
+ */
+static inline uint32_t
+ngknet_filter_word(ngknet_filter_t *filt, uint8_t *oob, uint8_t *pkt, int idx)
 {
-    struct pkt_buf *pkb;
-    ngknet_filter_t scratch;
-    uint8_t *oob;
-    int idx, wsize;
+    union {
+        uint32_t w;
+        uint8_t b[4];
+    } u;
+    int off = idx * 4;
+    int size = filt->oob_data_size + filt->pkt_data_size;
+    int bi;
+
+    if (off + 4 <= filt->oob_data_size) {
+        memcpy(&u.w, &oob[off], 4);
+        return u.w;
+    }
+    if (off >= filt->oob_data_size && off + 4 <= size) {
+        memcpy(&u.w, &pkt[off - filt->oob_data_size], 4);
+        return u.w;
+    }
 
-    if (!dev || !skb || !filt) {
-        return false;
+    /* Word straddles OOB and packet data, or the end of the data */
+    u.w = 0;
+    for (bi = 0; bi < 4 && off + bi < size; bi++) {
+        if (off + bi < filt->oob_data_size) {
+            u.b[bi] = oob[off + bi];
+        } else {
+            u.b[bi] = pkt[off + bi - filt->oob_data_size];
+        }
     }
+    return u.w;
+}
+
+static inline bool
+ngknet_filter_match(struct filt_entry *fe, int chan_id, struct pkt_buf *pkb)
+{
+    ngknet_filter_t *filt = &fe->fc->filt;
+    uint8_t *oob, *pkt;
+    int idx;
+
     if (filt->flags & NGKNET_FILTER_F_ANY_DATA) {
         return true;
     }
@@ -163,25 +204,94 @@ ngknet_filter_match(struct ngknet_dev *dev, int chan_id,
         return false;
     }
 
-    pkb = (struct pkt_buf *)skb->data;
-    oob = &pkb->data;
-
-    memcpy(&scratch.data.b[0],
-           &oob[filt->oob_data_offset], filt->oob_data_size);
-    memcpy(&scratch.data.b[filt->oob_data_size],
-           &pkb->data + pkb->pkh.meta_len + filt->pkt_data_offset,
-           filt->pkt_data_size);
-    wsize = NGKNET_BYTES2WORDS(filt->oob_data_size + filt->pkt_data_size);
-    for (idx = 0; idx < wsize; idx++) {
-        scratch.data.w[idx] &= filt->mask.w[idx];
-        if (scratch.data.w[idx] != filt->data.w[idx]) {
+    oob = &pkb->data + filt->oob_data_offset;
+    pkt = &pkb->data + pkb->pkh.meta_len + filt->pkt_data_offset;
+    for (idx = 0; idx < fe->wsize; idx++) {
+        if (filt->mask.w[idx] == 0) {
+            if (filt->data.w[idx] != 0) {
+                return false;
+            }
+            continue;
+        }
+        if ((ngknet_filter_word(filt, oob, pkt, idx) & filt->mask.w[idx]) !=
+            filt->data.w[idx]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Get the first filter from index start on that matches the packet.
+ * Return fi->num if none matches.
+ */
+static inline int
+ngknet_filter_lookup(struct filt_index *fi, int start, int chan_id,
+                     struct pkt_buf *pkb)
+{
+    int idx;
+
+    for (idx = start; idx < fi->num; idx++) {
+        if (ngknet_filter_match(&fi->ent[idx], chan_id, pkb)) {
             break;
         }
     }
-    if (idx == wsize) {
-        return true;
+    return idx;
+}
+
+static void
+ngknet_filter_index_free(struct rcu_head *rcu)
+{
+    kfree(container_of(rcu, struct filt_index, rcu));
+}
+
+static void
+ngknet_filter_ctrl_free(struct rcu_head *rcu)
+{
+    struct filt_ctrl *fc = container_of(rcu, struct filt_ctrl, rcu);
+
+    free_percpu(fc->hits);
+    kfree(fc);
+}
+
+static struct filt_index *
+ngknet_filter_index_alloc(void)
+{
+    return kzalloc(sizeof(struct filt_index) +
+                   NUM_FILTER_MAX * sizeof(struct filt_entry), GFP_KERNEL);
+}
+
+/*
+ * Publish a new filter index built from the filter list into fi.
+ * Called with the device lock held. Return the retired index, which must be
+ * released with call_rcu().
+ */
+static struct filt_index *
+ngknet_filter_index_update(struct ngknet_dev *dev, struct filt_index *fi)
+{
+    struct filt_index *old;
+    struct list_head *list;
+    struct filt_ctrl *fc;
+    int num = 0;
+
+    list_for_each(list, &dev->filt_list) {
+        fc = (struct filt_ctrl *)list;
+        fi->ent[num].fc = fc;
+        fi->ent[num].wsize =
+            NGKNET_BYTES2WORDS(fc->filt.oob_data_size + fc->filt.pkt_data_size);
+        num++;
+    }
+    fi->num = num;
+
+    old = rcu_dereference_protected(dev->filt_idx, lockdep_is_held(&dev->lock));
+    if (num) {
+        rcu_assign_pointer(dev->filt_idx, fi);
+    } else {
+        RCU_INIT_POINTER(dev->filt_idx, NULL);
+        call_rcu(&fi->rcu, ngknet_filter_index_free);
     }
-    return false;
+
+    return old;
 }
 
 static inline int
@@ -304,6 +414,7 @@ int
 ngknet_filter_create(struct ngknet_dev *dev, ngknet_filter_t *filter)
 {
     struct filt_ctrl *fc = NULL;
+    struct filt_index *fi = NULL;
     struct list_head *list = NULL;
     ngknet_filter_t *filt = NULL;
     filter_cb_t *filter_cb;
@@ -331,6 +442,14 @@ ngknet_filter_create(struct ngknet_dev *dev, ngknet_filter_t *filter)
     if (!fc) {
         return SHR_E_MEMORY;
     }
+    fc->hits = alloc_percpu(uint64_t);
+    fi = ngknet_filter_index_alloc();
+    if (!fc->hits || !fi) {
+        free_percpu(fc->hits);
+        kfree(fc);
+        kfree(fi);
+        return SHR_E_MEMORY;
+    }
 
     spin_lock_irqsave(&dev->lock, flags);
 
@@ -342,7 +461,9 @@ ngknet_filter_create(struct ngknet_dev *dev, ngknet_filter_t *filter)
     }
     if (id > NUM_FILTER_MAX) {
         spin_unlock_irqrestore(&dev->lock, flags);
+        free_percpu(fc->hits);
         kfree(fc);
+        kfree(fi);
         return SHR_E_RESOURCE;
     }
 
@@ -392,10 +513,16 @@ ngknet_filter_create(struct ngknet_dev *dev, ngknet_filter_t *filter)
         list_add_tail(&fc->list, &dev->filt_list);
     }
 
+    fi = ngknet_filter_index_update(dev, fi);
+
     filter->id = fc->filt.id;
 
     spin_unlock_irqrestore(&dev->lock, flags);
 
+    if (fi) {
+        call_rcu(&fi->rcu, ngknet_filter_index_free);
+    }
+
     return SHR_E_NONE;
 }
 
@@ -403,23 +530,50 @@ int
 ngknet_filter_destroy(struct ngknet_dev *dev, int id)
 {
     struct filt_ctrl *fc = NULL;
+    struct filt_index *fi = NULL;
     unsigned long flags;
+    bool rebuild = false;
     int num;
 
     if (id <= 0 || id > NUM_FILTER_MAX) {
         return SHR_E_PARAM;
     }
 
+    /* Do not allocate for a filter that was never created */
+    if (!READ_ONCE(dev->fc[id])) {
+        return SHR_E_NOT_FOUND;
+    }
+
+    fi = ngknet_filter_index_alloc();
+
     spin_lock_irqsave(&dev->lock, flags);
 
     fc = (struct filt_ctrl *)dev->fc[id];
     if (!fc) {
         spin_unlock_irqrestore(&dev->lock, flags);
+        kfree(fi);
         return SHR_E_NOT_FOUND;
     }
 
     list_del(&fc->list);
-    kfree(fc);
+    if (fi) {
+        fi = ngknet_filter_index_update(dev, fi);
+    } else {
+        /*
+         * Out of memory. Unpublish the index and rebuild it in place once
+         * the Rx path has left it, destroying must not fail.
+         */
+        fi = rcu_dereference_protected(dev->filt_idx,
+                                       lockdep_is_held(&dev->lock));
+        RCU_INIT_POINTER(dev->filt_idx, NULL);
+        rebuild = fi != NULL;
+    }
+
+    /* The Rx path may still be walking the retired index */
+    if (fi && !rebuild) {
+        call_rcu(&fi->rcu, ngknet_filter_index_free);
+    }
+    call_rcu(&fc->rcu, ngknet_filter_ctrl_free);
 
     dev->fc[id] = NULL;
     num = (long)dev->fc[0];
@@ -432,6 +586,19 @@ ngknet_filter_destroy(struct ngknet_dev *dev, int id)
 
     spin_unlock_irqrestore(&dev->lock, flags);
 
+    if (rebuild) {
+        synchronize_rcu();
+
+        spin_lock_irqsave(&dev->lock, flags);
+        fi = ngknet_filter_index_update(dev, fi);
+        spin_unlock_irqrestore(&dev->lock, flags);
+
+        /* A filter created meanwhile may have published an index */
+        if (fi) {
+            call_rcu(&fi->rcu, ngknet_filter_index_free);
+        }
+    }
+
     return SHR_E_NONE;
 }
 
@@ -506,19 +673,134 @@ ngknet_filter_get_next(struct ngknet_dev *dev, ngknet_filter_t *filter)
     return ngknet_filter_get(dev, filter->next, filter);
 }
 
+int
+ngknet_filter_hits_get(struct ngknet_dev *dev, int id, uint64_t *hits)
+{
+    struct filt_ctrl *fc = NULL;
+    unsigned long flags;
+    int cpu;
+
+    if (id <= 0 || id > NUM_FILTER_MAX) {
+        return SHR_E_PARAM;
+    }
+
+    spin_lock_irqsave(&dev->lock, flags);
+
+    fc = (struct filt_ctrl *)dev->fc[id];
+    if (!fc) {
+        spin_unlock_irqrestore(&dev->lock, flags);
+        return SHR_E_NOT_FOUND;
+    }
+
+    *hits = 0;
+    for_each_possible_cpu(cpu) {
+        *hits += *per_cpu_ptr(fc->hits, cpu);
+    }
+
+    spin_unlock_irqrestore(&dev->lock, flags);
+
+    return SHR_E_NONE;
+}
+
+/*
+ * Build a packet the filter matches: its data is planted under its mask at
+ * the OOB and packet offsets. Return the channel to look the packet up on.
+ */
+static int
+ngknet_filter_bench_plant(ngknet_filter_t *filt, int chan_id,
+                          struct pkt_buf *pkb)
+{
+    uint8_t *oob, *pkt, *byte;
+    int size = filt->oob_data_size + filt->pkt_data_size;
+    int idx;
+
+    /* Keep the packet data clear of the OOB data where meta_len allows */
+    pkb->pkh.meta_len = min(filt->oob_data_offset + filt->oob_data_size, 0xff);
+    oob = &pkb->data + filt->oob_data_offset;
+    pkt = &pkb->data + pkb->pkh.meta_len + filt->pkt_data_offset;
+    for (idx = 0; idx < size; idx++) {
+        if (idx < filt->oob_data_size) {
+            byte = &oob[idx];
+        } else {
+            byte = &pkt[idx - filt->oob_data_size];
+        }
+        *byte = (*byte & ~filt->mask.b[idx]) |
+                (filt->data.b[idx] & filt->mask.b[idx]);
+    }
+
+    return filt->flags & NGKNET_FILTER_F_MATCH_CHAN ? filt->chan : chan_id;
+}
+
+int
+ngknet_filter_bench(struct ngknet_dev *dev, int chan_id, int loops,
+                    int *filters, int *matches, uint64_t *ns)
+{
+    struct filt_index *fi = NULL;
+    struct pkt_buf *pkb;
+    ktime_t start;
+    int loop, done, burst, idx, chan, next = 0;
+
+    /* Large enough for any filter offset */
+    pkb = vzalloc(PKT_HDR_SIZE + 0x20000 + NGKNET_FILTER_BYTES_MAX);
+    if (!pkb) {
+        return SHR_E_MEMORY;
+    }
+
+    *filters = 0;
+    *matches = 0;
+    *ns = 0;
+
+    /*
+     * Take turns on the installed filters, timing a burst of lookups of a
+     * packet each one matches. Lower ranked filters are walked past on the
+     * way, as on the Rx path. Leave the read-side section between chunks to
+     * let others run.
+     */
+    for (loop = 0; loop < loops; ) {
+        rcu_read_lock();
+        fi = rcu_dereference(dev->filt_idx);
+        if (!fi) {
+            rcu_read_unlock();
+            break;
+        }
+        *filters = fi->num;
+        for (done = 0; done < NGKNET_FILTER_BENCH_CHUNK && loop < loops;
+             done += burst, loop += burst) {
+            chan = ngknet_filter_bench_plant(&fi->ent[next++ % fi->num].fc->filt,
+                                             chan_id, pkb);
+            burst = min3(loops - loop, NGKNET_FILTER_BENCH_CHUNK - done,
+                         NGKNET_FILTER_BENCH_BURST);
+            start = ktime_get();
+            for (idx = 0; idx < burst; idx++) {
+                if (ngknet_filter_lookup(fi, 0, chan, pkb) < fi->num) {
+                    (*matches)++;
+                }
+            }
+            *ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+        }
+        rcu_read_unlock();
+
+        cond_resched();
+    }
+
+    vfree(pkb);
+
+    return SHR_E_NONE;
+}
+
 int
 ngknet_rx_pkt_filter(struct ngknet_dev *dev, struct sk_buff *skb)
 {
     struct sk_buff *fskb = NULL;
     struct net_device *dest_ndev = NULL;
     struct ngknet_private *priv = NULL;
+    struct filt_index *fi = NULL;
     struct filt_ctrl *fc = NULL;
-    struct list_head *list = NULL, *next_list = NULL;
-    ngknet_filter_t *filt = NULL, *next_filt = NULL;
+    ngknet_filter_t *filt = NULL;
     struct pkt_buf *pkb = (struct pkt_buf *)skb->data;
     unsigned long flags;
     int rv, chan_id;
-    uint32_t next_filter_match = 0, same_pri_idx;
+    int idx, next_idx, same_idx;
 
     rv = bcmcnet_pdma_dev_queue_to_chan(&dev->pdma_dev, pkb->pkh.queue_id,
                                         PDMA_Q_RX, &chan_id);
@@ -526,94 +808,153 @@ ngknet_rx_pkt_filter(struct ngknet_dev *dev, struct sk_buff *skb)
         return rv;
     }
 
-    spin_lock_irqsave(&dev->lock, flags);
-
-    dest_ndev = dev->bdev[chan_id];
-    if (dest_ndev) {
-        skb->dev = dest_ndev;
-        priv = netdev_priv(dest_ndev);
-        priv->users++;
+    if (READ_ONCE(dev->bdev[chan_id])) {
+        spin_lock_irqsave(&dev->lock, flags);
+        dest_ndev = dev->bdev[chan_id];
+        if (dest_ndev) {
+            skb->dev = dest_ndev;
+            priv = netdev_priv(dest_ndev);
+            priv->users++;
+            spin_unlock_irqrestore(&dev->lock, flags);
+            priv->pkt_recv(dest_ndev, skb);
+            return SHR_E_NONE;
+        }
         spin_unlock_irqrestore(&dev->lock, flags);
-        priv->pkt_recv(dest_ndev, skb);
-        return SHR_E_NONE;
     }
 
-    if (list_empty(&dev->filt_list)) {
-        spin_unlock_irqrestore(&dev->lock, flags);
+    rcu_read_lock();
+
+    fi = rcu_dereference(dev->filt_idx);
+    if (!fi) {
+        rcu_read_unlock();
         return SHR_E_NO_HANDLER;
     }
 
     rv = SHR_E_NO_HANDLER;
-    list_for_each(list, &dev->filt_list) {
-        fc = (struct filt_ctrl *)list;
+    idx = ngknet_filter_lookup(fi, 0, chan_id, pkb);
+    while (idx < fi->num) {
+        fc = fi->ent[idx].fc;
         filt = &fc->filt;
-        if (next_filter_match || ngknet_filter_match(dev, chan_id, skb, filt)) {
-            if (next_filter_match && --next_filter_match > 0) {
-                /* Same priority, but not matching */
-                continue;
+        this_cpu_inc(*fc->hits);
+        fskb = skb;
+        next_idx = fi->num;
+        /* Look for matching filters with same priority */
+        for (same_idx = idx + 1; same_idx < fi->num; same_idx++) {
+            if (fi->ent[same_idx].fc->filt.priority != filt->priority) {
+                break;
             }
-            fc->hits++;
-            fskb = skb;
-            next_list = list->next;
-            same_pri_idx = 0;
-            /* Look for matching filters with same priority */
-            while (next_list != &dev->filt_list) {
-                next_filt = &((struct filt_ctrl *)next_list)->filt;
-                if (next_filt->priority != filt->priority) {
-                    break;
-                }
-                same_pri_idx++;
-                if (ngknet_filter_match(dev, chan_id, skb, next_filt)) {
-                    /* Found another matching filter with same priority */
-                    fskb = skb_replicate(skb, GFP_ATOMIC);
-                    next_filter_match = same_pri_idx;
-                    break;
-                }
-                next_list = next_list->next;
+            if (ngknet_filter_match(&fi->ent[same_idx], chan_id, pkb)) {
+                /* Found another matching filter with same priority */
+                fskb = skb_replicate(skb, GFP_ATOMIC);
+                next_idx = same_idx;
+                break;
             }
+        }
 
-            spin_unlock_irqrestore(&dev->lock, flags);
+        if (filt->dest_type == NGKNET_FILTER_DEST_T_CB) {
+            (void)ngknet_filter_callback(dev, fc, &fskb, &filt);
+        }
 
-            if (filt->dest_type == NGKNET_FILTER_DEST_T_CB) {
-                (void)ngknet_filter_callback(dev, fc, &fskb, &filt);
-            }
+        rv = ngknet_filter_process(dev, fskb, filt);
+        if (SHR_FAILURE(rv) && fskb != skb) {
+            dev_kfree_skb_any(fskb);
+        }
 
-            rv = ngknet_filter_process(dev, fskb, filt);
-            if (SHR_FAILURE(rv) && fskb != skb) {
-                dev_kfree_skb_any(fskb);
-            }
+        idx = next_idx;
+    }
 
-            spin_lock_irqsave(&dev->lock, flags);
+    rcu_read_unlock();
 
-            if (!next_filter_match) {
-                break;
+    return rv;
+}
+
+/*
+ * Use a smaller tick (larger interval) to support lower rates.
+ */
+static int
+ngknet_rl_ticks(int limit)
+{
+    struct ngknet_rl_queue *rq;
+    int rate = limit, di, qi;
+
+    if (rl_ctrl.queues_limited) {
+        for (di = 0; di < NUM_PDMA_DEV_MAX; di++) {
+            for (qi = 0; qi < NUM_Q_MAX; qi++) {
+                rq = &rl_ctrl.queue[di][qi];
+                if (rq->rate >= 0 && (rate < 0 || rq->rate < rate)) {
+                    rate = rq->rate;
+                }
             }
         }
     }
 
-    spin_unlock_irqrestore(&dev->lock, flags);
+    if (rate >= 0 && rate < 1000) {
+        return rate < 100 ? 1 : (rate + 99) / 100;
+    }
+    return NGKNET_EXTRA_RATE_LIMIT_DEFAULT_RX_TICK;
+}
 
-    return rv;
+/*
+ * Add credit to a bucket, capped at the burst size. Debt from the packets
+ * drained after a suspend is carried over, but only for one burst.
+ */
+static void
+ngknet_rl_refill(atomic_t *tokens, int credit, int burst)
+{
+    int old, new;
+
+    do {
+        old = atomic_read(tokens);
+        new = old < -burst ? -burst : old;
+        new += credit;
+        if (new > burst) {
+            new = burst;
+        }
+    } while (atomic_cmpxchg(tokens, old, new) != old);
 }
 
 static void
 ngknet_rl_process(timer_context_t data)
 {
     struct ngknet_rl_ctrl *rc = timer_arg(rc, data, timer);
+    struct ngknet_rl_queue *rq;
     struct ngknet_dev *dev;
-    unsigned long flags;
-    int idx;
+    int limit = ngknet_rx_rate_limit_get();
+    int credit, di, qi;
+
+    rc->rx_ticks = ngknet_rl_ticks(limit);
+
+    if (limit >= 0) {
+        credit = limit / rc->rx_ticks;
+        ngknet_rl_refill(&rc->rx_tokens, credit, credit);
+    }
 
-    spin_lock_irqsave(&rc->lock, flags);
-    rc->rx_pkts = 0;
-    for (idx = 0; idx < NUM_PDMA_DEV_MAX; idx++) {
-        dev = &rc->devs[idx];
-        if (rc->dev_active[idx] && rc->dev_paused[idx]) {
-            bcmcnet_pdma_dev_rx_resume(&dev->pdma_dev);
-            rl_ctrl.dev_paused[dev->dev_info.dev_no] = 0;
+    for (di = 0; di < NUM_PDMA_DEV_MAX; di++) {
+        dev = &rc->devs[di];
+        for (qi = 0; qi < NUM_Q_MAX; qi++) {
+            rq = &rc->queue[di][qi];
+            if (rq->rate >= 0) {
+                credit = rq->rate / rc->rx_ticks;
+                if (rq->rate && !credit) {
+                    credit = 1;
+                }
+                ngknet_rl_refill(&rq->tokens, credit, rq->burst);
+            }
+            if (!atomic_read(&rq->paused)) {
+                continue;
+            }
+            if (rq->rate >= 0 && atomic_read(&rq->tokens) <= 0) {
+                continue;
+            }
+            if (!rq->protect && limit >= 0 &&
+                atomic_read(&rc->rx_tokens) <= 0) {
+                continue;
+            }
+            if (atomic_xchg(&rq->paused, 0) && rc->dev_active[di]) {
+                bcmcnet_pdma_dev_rx_queue_resume(&dev->pdma_dev, qi);
+            }
         }
     }
-    spin_unlock_irqrestore(&rc->lock, flags);
 
     rc->timer.expires = jiffies + HZ / rc->rx_ticks;
     add_timer(&rc->timer);
@@ -622,8 +963,15 @@ ngknet_rl_process(timer_context_t data)
 void
 ngknet_rx_rate_limit_init(struct ngknet_dev *devs)
 {
+    int di, qi;
+
     sal_memset(&rl_ctrl, 0, sizeof(rl_ctrl));
     rl_ctrl.rx_ticks = NGKNET_EXTRA_RATE_LIMIT_DEFAULT_RX_TICK;
+    for (di = 0; di < NUM_PDMA_DEV_MAX; di++) {
+        for (qi = 0; qi < NUM_Q_MAX; qi++) {
+            rl_ctrl.queue[di][qi].rate = -1;
+        }
+    }
     setup_timer(&rl_ctrl.timer, ngknet_rl_process, (timer_context_t)&rl_ctrl);
     spin_lock_init(&rl_ctrl.lock);
     rl_ctrl.devs = devs;
@@ -661,36 +1009,106 @@ void
 ngknet_rx_rate_limit_stop(struct ngknet_dev *dev)
 {
     unsigned long flags;
+    int qi;
 
     spin_lock_irqsave(&rl_ctrl.lock, flags);
     rl_ctrl.dev_active[dev->dev_info.dev_no] = 0;
     spin_unlock_irqrestore(&rl_ctrl.lock, flags);
+
+    /* The queues are brought up again along with the device */
+    for (qi = 0; qi < NUM_Q_MAX; qi++) {
+        atomic_set(&rl_ctrl.queue[dev->dev_info.dev_no][qi].paused, 0);
+    }
 }
 
 void
-ngknet_rx_rate_limit(struct ngknet_dev *dev, int limit)
+ngknet_rx_rate_limit(struct ngknet_dev *dev, int queue, int limit)
 {
+    struct ngknet_rl_queue *rq;
+    int dev_no = dev->dev_info.dev_no;
+    bool over = false;
+
+    if (queue < 0 || queue >= NUM_Q_MAX) {
+        return;
+    }
+    rq = &rl_ctrl.queue[dev_no][queue];
+    rq->rx_pkts++;
+
+    if (rq->rate >= 0 && atomic_dec_return(&rq->tokens) < 0) {
+        over = true;
+    }
+    if (limit >= 0 && atomic_dec_return(&rl_ctrl.rx_tokens) < 0 &&
+        !rq->protect) {
+        over = true;
+    }
+    if (!over) {
+        return;
+    }
+
+    rq->rx_overruns++;
+    if (!atomic_xchg(&rq->paused, 1)) {
+        rq->suspends++;
+        bcmcnet_pdma_dev_rx_queue_suspend(&dev->pdma_dev, queue);
+    }
+}
+
+int
+ngknet_rx_queue_rate_limit_num(void)
+{
+    return rl_ctrl.queues_limited;
+}
+
+int
+ngknet_rx_queue_rate_limit_set(int dev_no, int queue, int rate, int burst,
+                               int protect)
+{
+    struct ngknet_rl_queue *rq;
     unsigned long flags;
 
-    /* To support lower rate, we should use smaller tick (larger interval). */
-    if (limit < 1000) {
-        rl_ctrl.rx_ticks = (limit + 99) / 100;
-    } else {
-        rl_ctrl.rx_ticks = NGKNET_EXTRA_RATE_LIMIT_DEFAULT_RX_TICK;
+    if (dev_no < 0 || dev_no >= NUM_PDMA_DEV_MAX ||
+        queue < 0 || queue >= NUM_Q_MAX) {
+        return SHR_E_PARAM;
+    }
+    if (rate < 0) {
+        rate = -1;
+    }
+    if (burst <= 0) {
+        burst = rate / NGKNET_EXTRA_RATE_LIMIT_DEFAULT_RX_TICK;
+    }
+    if (burst <= 0) {
+        burst = 1;
     }
 
     spin_lock_irqsave(&rl_ctrl.lock, flags);
-    if ((++rl_ctrl.rx_pkts + rl_ctrl.rx_overruns > limit / rl_ctrl.rx_ticks) &&
-        !rl_ctrl.dev_paused[dev->dev_info.dev_no] &&
-        rl_ctrl.dev_active[dev->dev_info.dev_no]) {
-        rl_ctrl.dev_paused[dev->dev_info.dev_no] = 1;
-        rl_ctrl.rx_overruns = 0;
-        bcmcnet_pdma_dev_rx_suspend(&dev->pdma_dev);
-    }
-    if (rl_ctrl.dev_paused[dev->dev_info.dev_no]) {
-        rl_ctrl.rx_overruns++;
+
+    rq = &rl_ctrl.queue[dev_no][queue];
+    if (rq->rate < 0 && rate >= 0) {
+        rl_ctrl.queues_limited++;
+    } else if (rq->rate >= 0 && rate < 0) {
+        rl_ctrl.queues_limited--;
     }
+    rq->rate = rate;
+    rq->burst = burst;
+    rq->protect = protect ? 1 : 0;
+    atomic_set(&rq->tokens, burst);
+
     spin_unlock_irqrestore(&rl_ctrl.lock, flags);
+
+    return SHR_E_NONE;
+}
+
+int
+ngknet_rx_queue_rate_limit_get(int dev_no, int queue,
+                               struct ngknet_rl_queue *rlq)
+{
+    if (dev_no < 0 || dev_no >= NUM_PDMA_DEV_MAX ||
+        queue < 0 || queue >= NUM_Q_MAX) {
+        return SHR_E_PARAM;
+    }
+
+    *rlq = rl_ctrl.queue[dev_no][queue];
+
+    return SHR_E_NONE;
 }
 
 void
@@ -35,14 +35,47 @@ struct filt_ctrl {
     /*! Device number */
     int dev_no;
 
-    /*! Number of hits */
-    uint64_t hits;
+    /*! Number of hits, per CPU */
+    uint64_t __percpu *hits;
 
     /*! Filter description */
     ngknet_filter_t filt;
 
     /*! Filter callback */
     ngknet_filter_cb_f filter_cb;
+
+    /*! RCU head for deferred free */
+    struct rcu_head rcu;
+};
+
+/*!
+ * \brief Filter index entry.
+ */
+struct filt_entry {
+    /*! Filter control */
+    struct filt_ctrl *fc;
+
+    /*! Number of match words */
+    int wsize;
+};
+
+/*!
+ * \brief Filter index.
+ *
+ * This is a read-only snapshot of the filter list in match order. It is
+ * rebuilt whenever the list changes and published with RCU, so the Rx path
+ * walks it without taking the device lock. A retired index and the filters
+ * removed with it are freed after an RCU grace period.
+ */
+struct filt_index {
+    /*! RCU head for deferred free */
+    struct rcu_head rcu;
+
+    /*! Number of filters */
+    int num;
+
+    /*! Filters in match order */
+    struct filt_entry ent[];
 };
 
 /*!
@@ -105,6 +138,42 @@ ngknet_filter_get(struct ngknet_dev *dev, int id, ngknet_filter_t *filter);
 extern int
 ngknet_filter_get_next(struct ngknet_dev *dev, ngknet_filter_t *filter);
 
+/*!
+ * \brief Get filter hits.
+ *
+ * \param [in] dev Device structure point.
+ * \param [in] id Filter ID.
+ * \param [out] hits Number of hits summed over all CPUs.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
+ */
+extern int
+ngknet_filter_hits_get(struct ngknet_dev *dev, int id, uint64_t *hits);
+
+/*!
+ * \brief Benchmark filter matching.
+ *
+ * Run synthetic packets through the filter index of the device the given
+ * number of times. The packets are built to match the installed filters in
+ * turn. Only the matching is timed, no filter action is taken and no hits
+ * are counted.
+ *
+ * \param [in] dev Device structure point.
+ * \param [in] chan_id Rx channel to match against, unless the filter
+ *                     matches a channel of its own.
+ * \param [in] loops Number of lookups.
+ * \param [out] filters Number of filters in the index.
+ * \param [out] matches Number of lookups that found a filter.
+ * \param [out] ns Total lookup time in nanoseconds.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
+ */
+extern int
+ngknet_filter_bench(struct ngknet_dev *dev, int chan_id, int loops,
+                    int *filters, int *matches, uint64_t *ns);
+
 /*!
  * \brief Filter packet.
  *
@@ -117,43 +186,78 @@ ngknet_filter_get_next(struct ngknet_dev *dev, ngknet_filter_t *filter);
 extern int
 ngknet_rx_pkt_filter(struct ngknet_dev *dev, struct sk_buff *skb);
 
+/*!
+ * \brief Rx queue rate limit control.
+ *
+ * Token bucket of a single Rx queue. The tokens are consumed in the Rx path
+ * and refilled by the rate limit timer, both without locking.
+ */
+struct ngknet_rl_queue {
+    /*! Rate in packets per second, -1 for no limit */
+    int rate;
+
+    /*! Burst size in packets */
+    int burst;
+
+    /*! Protected queue, not suspended by the aggregate limit */
+    int protect;
+
+    /*! Available tokens */
+    atomic_t tokens;
+
+    /*! Queue suspended due to no Rx credit */
+    atomic_t paused;
+
+    /*! Rx packets */
+    uint64_t rx_pkts;
+
+    /*! Rx packets over the limit */
+    uint64_t rx_overruns;
+
+    /*! Number of times the queue was suspended */
+    uint64_t suspends;
+};
+
 /*!
  * \brief Rx rate limit control.
  *
  * This contains all the control information for Rx rate limit such as
- * the number of Rx packets, status related to Rx rate limit, etc.
+ * the token buckets, status related to Rx rate limit, etc.
  *
- * The rate limit is kernel-oriented, i.e. all the Rx packets from any
- * device/channel will be accounted for. Once the received packets reach
- * the limit value in an 1-Sec interval, the driver API XXXX_rx_suspend()
- * will be called to suspend Rx. The 1-Sec basis timer will call the driver
- * API XXXX_rx_resume() to resume Rx and reset rate-related status/counters
- * at the begin of the next 1-Sec interval.
+ * The rate limit is hierarchical. Every Rx queue of every device may have
+ * its own rate and burst size, and all the Rx packets from any device or
+ * queue are also accounted for by an aggregate bucket. A queue that runs out
+ * of credit in its own bucket, or in the aggregate bucket unless the queue is
+ * protected, is suspended with bcmcnet_pdma_dev_rx_queue_suspend(). The other
+ * queues keep receiving. Protected queues still consume aggregate credit, so
+ * they are served ahead of the unprotected ones. The basis timer refills the
+ * buckets every tick and resumes the queues that have credit again.
  *
  * The NGKNET module parameter 'rx_rate_limit' is used to decide the maximum
- * Rx rate. Disable Rx rate limit if set 0. It can be set when inserting
- * NGKNET module or modified using its SYSFS attributions.
+ * aggregate Rx rate. Disable the aggregate limit if set -1. It can be set
+ * when inserting NGKNET module or modified using its PROCFS attributions.
+ * The per-queue limits are set through PROCFS 'queue_rate_limit'.
  */
 struct ngknet_rl_ctrl {
-    /*! Rx packets */
-    int rx_pkts;
-
-    /*! Rx overruns */
-    int rx_overruns;
+    /*! Aggregate tokens */
+    atomic_t rx_tokens;
 
     /*! Rx ticks */
     int rx_ticks;
 
+    /*! Number of rate limited queues */
+    int queues_limited;
+
     /*! Active devices under rate control */
     int dev_active[NUM_PDMA_DEV_MAX];
 
-    /*! Paused devices due to no Rx credit */
-    int dev_paused[NUM_PDMA_DEV_MAX];
+    /*! Rx queues */
+    struct ngknet_rl_queue queue[NUM_PDMA_DEV_MAX][NUM_Q_MAX];
 
     /*! Rate limit timer */
     struct timer_list timer;
 
-    /*! Rate limit lock */
+    /*! Rate limit lock for configuration */
     spinlock_t lock;
 
     /*! Devices */
@@ -203,9 +307,47 @@ ngknet_rx_rate_limit_stop(struct ngknet_dev *dev);
  * \brief Limit Rx rate.
  *
  * \param [in] dev Device structure point.
+ * \param [in] queue Rx queue number.
+ * \param [in] limit Aggregate Rx rate limit, -1 for no limit.
  */
 extern void
-ngknet_rx_rate_limit(struct ngknet_dev *dev, int limit);
+ngknet_rx_rate_limit(struct ngknet_dev *dev, int queue, int limit);
+
+/*!
+ * \brief Get the number of rate limited Rx queues.
+ */
+extern int
+ngknet_rx_queue_rate_limit_num(void);
+
+/*!
+ * \brief Set Rx queue rate limit.
+ *
+ * \param [in] dev_no Device number.
+ * \param [in] queue Rx queue number.
+ * \param [in] rate Rate in packets per second, -1 for no limit.
+ * \param [in] burst Burst size in packets, 0 for one tick of the rate.
+ * \param [in] protect Protect the queue from the aggregate limit.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
+ */
+extern int
+ngknet_rx_queue_rate_limit_set(int dev_no, int queue, int rate, int burst,
+                               int protect);
+
+/*!
+ * \brief Get Rx queue rate limit.
+ *
+ * \param [in] dev_no Device number.
+ * \param [in] queue Rx queue number.
+ * \param [out] rlq Rate limit configuration and counters of the queue.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
+ */
+extern int
+ngknet_rx_queue_rate_limit_get(int dev_no, int queue,
+                               struct ngknet_rl_queue *rlq);
 
 /*!
  * \brief Schedule Tx queue.
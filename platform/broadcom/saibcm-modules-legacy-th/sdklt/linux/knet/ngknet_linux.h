@@ -179,6 +179,37 @@ kal_dma_unmap_page_attrs(struct device *dev, dma_addr_t addr,
 }
 #endif /* KERNEL_VERSION(4,10,0) */
 
+/* Batched delivery with netif_receive_skb_list is available from Linux 4.19 */
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4,19,0))
+#define NGKNET_RX_LIST 1
+#else
+#define NGKNET_RX_LIST 0
+#endif
+
+/* Tx burst hint from the stack for deferred DMA kick-off */
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,2,0))
+#define kal_xmit_more(skb) netdev_xmit_more()
+#elif (LINUX_VERSION_CODE >= KERNEL_VERSION(3,18,0))
+#define kal_xmit_more(skb) ((skb)->xmit_more)
+#else
+#define kal_xmit_more(skb) 0
+#endif
+
+/*
+ * Page pool with SKB recycling is usable from Linux 5.15. Older kernels
+ * keep the driver managed page flipping.
+ */
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,15,0)) && IS_ENABLED(CONFIG_PAGE_POOL)
+#define NGKNET_PAGE_POOL 1
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6,6,0))
+#include <net/page_pool/helpers.h>
+#else
+#include <net/page_pool.h>
+#endif
+#else
+#define NGKNET_PAGE_POOL 0
+#endif
+
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3,17,0)
 static inline s64
 kal_time_usecs(void)
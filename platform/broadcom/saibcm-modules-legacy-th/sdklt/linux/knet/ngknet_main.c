@@ -88,6 +88,7 @@
 #include <lkm/ngknet_ioctl.h>
 #include <bcmcnet/bcmcnet_core.h>
 #include "ngknet_main.h"
+#include "ngknet_buff.h"
 #include "ngknet_extra.h"
 #include "ngknet_procfs.h"
 #include "ngknet_callback.h"
@@ -175,6 +176,13 @@ MODULE_PARM_DESC(rx_batching,
 "Enable Rx batch fill mode (default 0 for single fill mode)");
 /*! \endcond */
 
+/*! \cond */
+static int rx_refill_batch = 16;
+MODULE_PARAM(rx_refill_batch, int, 0);
+MODULE_PARM_DESC(rx_refill_batch,
+"Rx descriptors re-armed per DMA halt update in single fill mode (default 16)");
+/*! \endcond */
+
 /*! \cond */
 static int page_buffer_mode = 0;
 MODULE_PARAM(page_buffer_mode, int, 0);
@@ -182,6 +190,20 @@ MODULE_PARM_DESC(page_buffer_mode,
 "Enable SKB page buffer mode (default 0 for legacy SKB mode)");
 /*! \endcond */
 
+/*! \cond */
+static int rx_page_pool = 1;
+MODULE_PARAM(rx_page_pool, int, 0);
+MODULE_PARM_DESC(rx_page_pool,
+"Serve page mode Rx buffers from a kernel page pool (default 1)");
+/*! \endcond */
+
+/*! \cond */
+static int rx_copybreak = 256;
+MODULE_PARAM(rx_copybreak, int, 0);
+MODULE_PARM_DESC(rx_copybreak,
+"Copy Rx packets up to this size into a new SKB and reuse the buffer (default 256, 0 to disable)");
+/*! \endcond */
+
 typedef int (*drv_ops_attach)(struct pdma_dev *dev);
 
 struct bcmcnet_drv_ops {
@@ -218,10 +240,14 @@ struct ngknet_intr_handle {
     struct intr_handle *hdl;
     int napi_resched;
     int napi_pending;
+    struct list_head rx_list;
 };
 
 static struct ngknet_intr_handle priv_hdl[NUM_PDMA_DEV_MAX][NUM_Q_MAX];
 
+/* NAPI handle being polled on this CPU, NULL outside ngknet_poll */
+static DEFINE_PER_CPU(struct ngknet_intr_handle *, rx_poll_kih);
+
 /*!
  * Dump packet content for debug
  */
@@ -467,6 +493,56 @@ ngknet_netif_ok(struct net_device *ndev)
     return (netif_carrier_ok(ndev) && netif_running(ndev));
 }
 
+/*!
+ * \brief Hand a packet over to the network stack.
+ *
+ * Inside the NAPI poll, packets go through GRO if the interface has it
+ * enabled, otherwise they are collected and passed up as one list when
+ * the poll is done. Anything else is received directly.
+ *
+ * \param [in] ndev Network device structure point.
+ * \param [in] skb Rx packet SKB.
+ */
+static void
+ngknet_rx_deliver(struct net_device *ndev, struct sk_buff *skb)
+{
+    struct ngknet_private *priv = netdev_priv(ndev);
+    struct ngknet_intr_handle *kih = this_cpu_read(rx_poll_kih);
+
+    if (kih) {
+        /* RCPU encapsulated packets can not be aggregated */
+        if (ndev->features & NETIF_F_GRO &&
+            !(priv->netif.flags & NGKNET_NETIF_F_RCPU_ENCAP)) {
+            napi_gro_receive(&kih->napi, skb);
+            return;
+        }
+#if NGKNET_RX_LIST
+        if (priv->rx_flags & NGKNET_RX_F_LIST) {
+            list_add_tail(&skb->list, &kih->rx_list);
+            return;
+        }
+#endif
+    }
+
+    netif_receive_skb(skb);
+}
+
+/*!
+ * \brief Pass up the packets batched during a NAPI poll.
+ *
+ * \param [in] kih NAPI handle.
+ */
+static void
+ngknet_rx_list_flush(struct ngknet_intr_handle *kih)
+{
+#if NGKNET_RX_LIST
+    if (!list_empty(&kih->rx_list)) {
+        netif_receive_skb_list(&kih->rx_list);
+        INIT_LIST_HEAD(&kih->rx_list);
+    }
+#endif
+}
+
 /*!
  * \brief Network interface Rx function.
  *
@@ -485,6 +561,7 @@ ngknet_netif_recv(struct net_device *ndev, struct sk_buff *skb)
     struct ngknet_dev *dev = priv->bkn_dev;
     struct pkt_hdr *pkh = (struct pkt_hdr *)skb->data;
     uint16_t proto;
+    int queue;
     int rv;
 
     /* Handle one incoming packet */
@@ -518,20 +595,21 @@ ngknet_netif_recv(struct net_device *ndev, struct sk_buff *skb)
         skb->protocol = proto;
     }
 
-    skb_record_rx_queue(skb, pkh->queue_id);
+    queue = pkh->queue_id;
+    skb_record_rx_queue(skb, queue);
 
     /* Update accounting */
     priv->stats.rx_packets++;
     priv->stats.rx_bytes += skb->len;
 
-    netif_receive_skb(skb);
+    ngknet_rx_deliver(ndev, skb);
 
     /* Rate limit */
-    if (rx_rate_limit >= 0) {
+    if (rx_rate_limit >= 0 || ngknet_rx_queue_rate_limit_num()) {
         if (!ngknet_rx_rate_limit_started()) {
             ngknet_rx_rate_limit_start(dev);
         }
-        ngknet_rx_rate_limit(dev, rx_rate_limit);
+        ngknet_rx_rate_limit(dev, queue, rx_rate_limit);
     }
 
     return SHR_E_NONE;
@@ -1060,6 +1138,7 @@ ngknet_poll(struct napi_struct *napi, int budget)
 
     kih->napi_pending = 0;
 
+    __this_cpu_write(rx_poll_kih, kih);
     if (pdev->flags & PDMA_GROUP_INTR) {
         work_done = bcmcnet_group_poll(pdev, hdl->group, budget);
     } else {
@@ -1068,6 +1147,8 @@ ngknet_poll(struct napi_struct *napi, int budget)
         }
         work_done = bcmcnet_queue_poll(pdev, hdl, budget);
     }
+    __this_cpu_write(rx_poll_kih, NULL);
+    ngknet_rx_list_flush(kih);
 
     if (work_done < budget) {
         kih->napi_resched = 0;
@@ -1312,7 +1393,7 @@ ngknet_enet_open(struct net_device *ndev)
         }
 
         /* Start rate limit */
-        if (rx_rate_limit >= 0) {
+        if (rx_rate_limit >= 0 || ngknet_rx_queue_rate_limit_num()) {
             ngknet_rx_rate_limit_start(dev);
         }
 
@@ -1381,7 +1462,7 @@ ngknet_enet_stop(struct net_device *ndev)
 
     if (priv->netif.id <= 0) {
         /* Stop rate limit */
-        if (rx_rate_limit >= 0) {
+        if (ngknet_rx_rate_limit_started()) {
             ngknet_rx_rate_limit_stop(dev);
         }
 
@@ -1412,6 +1493,24 @@ ngknet_enet_stop(struct net_device *ndev)
     return 0;
 }
 
+/*!
+ * Kick off all Tx DMA queues with deferred descriptors
+ *
+ * xmit_more is reported per netdev queue while deferral happens per DMA
+ * queue, so the end of a burst must flush every deferred DMA queue.
+ */
+static void
+ngknet_tx_defer_flush(struct ngknet_dev *dev)
+{
+    int qi;
+
+    for_each_set_bit(qi, dev->tx_defer, NUM_Q_MAX) {
+        if (test_and_clear_bit(qi, dev->tx_defer)) {
+            bcmcnet_pdma_tx_queue_kick(&dev->pdma_dev, qi);
+        }
+    }
+}
+
 /*!
  * Start transmission
  */
@@ -1422,7 +1521,9 @@ ngknet_start_xmit(struct sk_buff *skb, struct net_device *ndev)
     struct ngknet_dev *dev = priv->bkn_dev;
     struct pdma_dev *pdev = &dev->pdma_dev;
     struct sk_buff *bskb = skb;
+    struct pkt_hdr *pkh;
     uint32_t len = skb->len;
+    bool more;
     int queue;
     int rv;
 
@@ -1434,6 +1535,9 @@ ngknet_start_xmit(struct sk_buff *skb, struct net_device *ndev)
     /* Do not transmit on base device */
     if (priv->netif.id <= 0) {
         priv->stats.tx_dropped++;
+        if (!kal_xmit_more(skb)) {
+            ngknet_tx_defer_flush(dev);
+        }
         dev_kfree_skb_any(skb);
         return NETDEV_TX_OK;
     }
@@ -1444,11 +1548,15 @@ ngknet_start_xmit(struct sk_buff *skb, struct net_device *ndev)
     }
 
     queue = skb->queue_mapping;
+    more = kal_xmit_more(skb);
 
     /* Handle one outgoing packet */
     rv = ngknet_tx_frame_process(ndev, &skb);
     if (SHR_FAILURE(rv)) {
         priv->stats.tx_dropped++;
+        if (!more) {
+            ngknet_tx_defer_flush(dev);
+        }
         if (skb) {
             dev_kfree_skb_any(skb);
         }
@@ -1471,8 +1579,23 @@ ngknet_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 
     skb_tx_timestamp(skb);
 
+    /* Let the DMA defer its kick-off while the stack has more to send */
+    pkh = (struct pkt_hdr *)skb->data;
+    if (more) {
+        pkh->attrs |= PDMA_TX_MORE_PKT;
+    } else {
+        pkh->attrs &= ~PDMA_TX_MORE_PKT;
+    }
+
     rv = pdev->pkt_xmit(pdev, queue, skb);
 
+    /* Track deferred DMA queues and flush them all once the burst ends */
+    if (more && rv == SHR_E_NONE) {
+        set_bit(queue, dev->tx_defer);
+    } else {
+        ngknet_tx_defer_flush(dev);
+    }
+
     if (rv == SHR_E_BUSY) {
         DBG_WARN(("Tx suspend: DMA device is busy and temporarily "
                   "unavailable.\n"));
@@ -1739,6 +1862,52 @@ ngknet_set_link_ksettings(struct net_device *ndev,
 }
 #endif
 
+#if NGKNET_RX_LIST
+/* Private flags in NGKNET_RX_F_XXX bit order */
+static const char ngknet_priv_flags[][ETH_GSTRING_LEN] = {
+    "rx-list",
+};
+
+static int
+ngknet_get_sset_count(struct net_device *ndev, int sset)
+{
+    if (sset == ETH_SS_PRIV_FLAGS) {
+        return ARRAY_SIZE(ngknet_priv_flags);
+    }
+
+    return -EOPNOTSUPP;
+}
+
+static void
+ngknet_get_strings(struct net_device *ndev, uint32_t sset, uint8_t *data)
+{
+    if (sset == ETH_SS_PRIV_FLAGS) {
+        memcpy(data, ngknet_priv_flags, sizeof(ngknet_priv_flags));
+    }
+}
+
+static uint32_t
+ngknet_get_priv_flags(struct net_device *ndev)
+{
+    struct ngknet_private *priv = netdev_priv(ndev);
+
+    return priv->rx_flags;
+}
+
+static int
+ngknet_set_priv_flags(struct net_device *ndev, uint32_t flags)
+{
+    struct ngknet_private *priv = netdev_priv(ndev);
+
+    if (flags & ~((1U << ARRAY_SIZE(ngknet_priv_flags)) - 1)) {
+        return -EINVAL;
+    }
+    priv->rx_flags = flags;
+
+    return 0;
+}
+#endif
+
 static const struct ethtool_ops ngknet_ethtool_ops = {
     .get_drvinfo        = ngknet_get_drvinfo,
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,5,0))
@@ -1748,6 +1917,12 @@ static const struct ethtool_ops ngknet_ethtool_ops = {
     .get_link_ksettings = ngknet_get_link_ksettings,
     .set_link_ksettings = ngknet_set_link_ksettings,
 #endif
+#if NGKNET_RX_LIST
+    .get_sset_count     = ngknet_get_sset_count,
+    .get_strings        = ngknet_get_strings,
+    .get_priv_flags     = ngknet_get_priv_flags,
+    .set_priv_flags     = ngknet_set_priv_flags,
+#endif
 };
 
 /*!
@@ -1833,6 +2008,9 @@ ngknet_ndev_init(ngknet_netif_t *netif, struct net_device **nd)
                      NETIF_F_HIGHDMA |
                      NETIF_F_HW_VLAN_CTAG_RX;
 
+    /* GRO is toggled with the generic feature, list receive by private flag */
+    ((struct ngknet_private *)netdev_priv(ndev))->rx_flags = NGKNET_RX_F_LIST;
+
     /* Register the kernel network device */
     rv = register_netdev(ndev);
     if (rv < 0) {
@@ -1884,6 +2062,7 @@ ngknet_pdev_init(struct ngknet_dev *dev)
     pdev->ctrl.dev = pdev;
     pdev->ctrl.hw_addr = dev->base_addr;
     pdev->ctrl.rx_buf_size = rx_buffer_size;
+    pdev->ctrl.rx_refill_batch = rx_refill_batch > 0 ? rx_refill_batch : 1;
 
     /* Hook callbacks */
     pdev->dev_read32 = ngknet_dev_read32;
@@ -2009,6 +2188,7 @@ ngknet_dev_probe(int dn, ngknet_netif_t *netif)
     rv = ngknet_ndev_init(netif, &ndev);
     if (SHR_FAILURE(rv)) {
         bcmcnet_pdma_dev_cleanup(pdev);
+        ngknet_rx_buf_pool_cleanup(pdev);
         return rv;
     }
     dev->net_dev = ndev;
@@ -2038,6 +2218,7 @@ ngknet_dev_probe(int dn, ngknet_netif_t *netif)
             hdl = &pdev->ctrl.grp[gi].intr_hdl[qi];
             priv_hdl[hdl->unit][hdl->chan].hdl = hdl;
             hdl->priv = &priv_hdl[hdl->unit][hdl->chan];
+            INIT_LIST_HEAD(&priv_hdl[hdl->unit][hdl->chan].rx_list);
             kal_netif_napi_add(ndev, (struct napi_struct *)hdl->priv,
                                ngknet_poll, pdev->ctrl.budget);
             if (pdev->flags & PDMA_GROUP_INTR) {
@@ -2173,6 +2354,7 @@ ngknet_dev_remove(int dn)
 
     /* Clean up PDMA device */
     bcmcnet_pdma_dev_cleanup(pdev);
+    ngknet_rx_buf_pool_cleanup(pdev);
 
     /* Detach PDMA driver */
     rv = drv_ops[pdev->dev_type]->drv_detach(pdev);
@@ -2469,6 +2651,18 @@ ngknet_page_buffer_mode_get(void)
     return page_buffer_mode;
 }
 
+int
+ngknet_rx_page_pool_get(void)
+{
+    return rx_page_pool;
+}
+
+int
+ngknet_rx_copybreak_get(void)
+{
+    return rx_copybreak;
+}
+
 /*!
  * Generic module functions
  */
@@ -2714,7 +2908,7 @@ ngknet_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
         break;
     case NGKNET_DEV_SUSPEND:
         DBG_CMD(("NGKNET_DEV_SUSPEND\n"));
-        if (rx_rate_limit >= 0) {
+        if (ngknet_rx_rate_limit_started()) {
             ngknet_rx_rate_limit_stop(dev);
         }
         if (ioc.iarg[0]) {
@@ -2728,7 +2922,7 @@ ngknet_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
     case NGKNET_DEV_RESUME:
         DBG_CMD(("NGKNET_DEV_RESUME\n"));
         ioc.rc = bcmcnet_pdma_dev_resume(pdev);
-        if (rx_rate_limit >= 0) {
+        if (rx_rate_limit >= 0 || ngknet_rx_queue_rate_limit_num()) {
             ngknet_rx_rate_limit_start(dev);
         }
         break;
@@ -3033,6 +3227,9 @@ ngknet_exit_module(void)
         ngknet_dev_remove(idx);
     }
 
+    /* Wait for the filters retired under RCU */
+    rcu_barrier();
+
     unregister_chrdev(NGKNET_MODULE_MAJOR, NGKNET_MODULE_NAME);
 }
 
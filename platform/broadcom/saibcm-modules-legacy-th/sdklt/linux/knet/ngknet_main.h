@@ -66,6 +66,23 @@ typedef void (*ngknet_pkt_recv_f)(struct net_device *ndev, struct sk_buff *skb);
 #define SAI_FIXUP           1
 #define KNET_SVTAG_HOTFIX   1
 
+/*!
+ * \brief Rx buffer statistics.
+ */
+struct ngknet_rxb_stats {
+    /*! Number of newly allocated buffers */
+    uint64_t allocs;
+
+    /*! Number of buffer DMA mappings */
+    uint64_t maps;
+
+    /*! Number of buffers reused without reallocation */
+    uint64_t reuses;
+
+    /*! Number of packets copied by copy-break */
+    uint64_t copies;
+};
+
 /*!
  * Device description
  */
@@ -100,6 +117,9 @@ struct ngknet_dev {
     /*! Filter control, 0 is reserved */
     void *fc[NUM_FILTER_MAX + 1];
 
+    /*! Filter index for Rx path, RCU protected */
+    struct filt_index __rcu *filt_idx;
+
     /*! Callback control */
     struct ngknet_callback_ctrl *cbc;
 
@@ -139,6 +159,18 @@ struct ngknet_dev {
     /*! NGKNET work queue for link process */
     struct workqueue_struct *link_wq;
 
+    /*! Rx page pools for new buffers, indexed by channel */
+    void *rx_pool[NUM_Q_MAX];
+
+    /*! Rx page pools backing the ring buffers, indexed by channel */
+    void *rx_ring_pool[NUM_Q_MAX];
+
+    /*! Tx DMA queues holding descriptors deferred by PDMA_TX_MORE_PKT */
+    DECLARE_BITMAP(tx_defer, NUM_Q_MAX);
+
+    /*! Rx buffer statistics, indexed by channel */
+    struct ngknet_rxb_stats rxb_stats[NUM_Q_MAX];
+
     /*! Flags */
     int flags;
     /*! NGKNET device is active */
@@ -179,6 +211,11 @@ struct ngknet_private {
     /*! HW timestamp Tx type */
     int hwts_tx_type;
 
+    /*! Rx delivery flags, set through ethtool private flags */
+    uint32_t rx_flags;
+    /*! Batch Rx packets of a NAPI poll into one list receive */
+#define NGKNET_RX_F_LIST        (1 << 0)
+
 #if NGKNET_ETHTOOL_LINK_SETTINGS
     /* Link settings */
     struct ethtool_link_settings link_settings;
@@ -278,5 +315,21 @@ ngknet_rx_rate_limit_set(int rate_limit);
 extern int
 ngknet_page_buffer_mode_get(void);
 
+/*!
+ * \brief Get Rx page pool mode.
+ *
+ * \retval Non-zero if page mode Rx buffers come from a page pool.
+ */
+extern int
+ngknet_rx_page_pool_get(void);
+
+/*!
+ * \brief Get Rx copy-break threshold.
+ *
+ * \retval Largest packet size copied into a new SKB, 0 if disabled.
+ */
+extern int
+ngknet_rx_copybreak_get(void);
+
 #endif /* NGKNET_MAIN_H */
 
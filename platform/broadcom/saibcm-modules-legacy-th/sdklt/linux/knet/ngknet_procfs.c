@@ -188,6 +188,7 @@ proc_filter_info_show(struct seq_file *m, void *v)
     struct ngknet_dev *dev;
     ngknet_filter_t filt = {0};
     int di, dn = 0, fn = 0;
+    uint64_t hits;
     int rv;
 
     for (di = 0; di < NUM_PDMA_DEV_MAX; di++) {
@@ -230,7 +231,10 @@ proc_filter_info_show(struct seq_file *m, void *v)
             proc_data_show(m, filt.mask.b, filt.oob_data_size + filt.pkt_data_size);
             seq_printf(m, "user_data:      ");
             proc_data_show(m, filt.user_data, NGKNET_FILTER_USER_DATA);
-            seq_printf(m, "hits:           %llu\n", ((struct filt_ctrl *)dev->fc[filt.id])->hits);
+            if (SHR_FAILURE(ngknet_filter_hits_get(dev, filt.id, &hits))) {
+                hits = 0;
+            }
+            seq_printf(m, "hits:           %llu\n", (unsigned long long)hits);
         } while (filt.next);
     }
 
@@ -264,6 +268,93 @@ static struct proc_ops proc_filter_info_fops = {
     .proc_release =     proc_filter_info_release,
 };
 
+static int filter_bench_loops;
+static int filter_bench_chan;
+
+static int
+proc_filter_bench_show(struct seq_file *m, void *v)
+{
+    struct ngknet_dev *dev;
+    uint64_t ns;
+    int di, dn = 0, filters, matches;
+    int rv;
+
+    if (filter_bench_loops <= 0) {
+        seq_printf(m, "%s\n", "Write \"<loops> [<chan>]\" to run benchmark");
+        return 0;
+    }
+
+    for (di = 0; di < NUM_PDMA_DEV_MAX; di++) {
+        dev = &ngknet_devices[di];
+        if (!(dev->flags & NGKNET_DEV_ACTIVE)) {
+            continue;
+        }
+        dn++;
+
+        rv = ngknet_filter_bench(dev, filter_bench_chan, filter_bench_loops,
+                                 &filters, &matches, &ns);
+        if (SHR_FAILURE(rv)) {
+            printk("ngknet: benchmark device%d filters failed\n", di);
+            break;
+        }
+
+        seq_printf(m, "dev_no:         %d\n",   di);
+        seq_printf(m, "chan:           %d\n",   filter_bench_chan);
+        seq_printf(m, "filters:        %d\n",   filters);
+        seq_printf(m, "lookups:        %d\n",   filter_bench_loops);
+        seq_printf(m, "matches:        %d\n",   matches);
+        seq_printf(m, "ns_per_lookup:  %llu\n",
+                   (unsigned long long)div_u64(ns, filter_bench_loops));
+    }
+
+    if (!dn) {
+        seq_printf(m, "%s\n", "No active device");
+    }
+
+    return 0;
+}
+
+static int
+proc_filter_bench_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, proc_filter_bench_show, NULL);
+}
+
+static ssize_t
+proc_filter_bench_write(struct file *file, const char *buf,
+                        size_t count, loff_t *loff)
+{
+    char bench_str[24] = {0};
+    char *ptr;
+
+    if (copy_from_user(bench_str, buf,
+                       min(count, sizeof(bench_str) - 1))) {
+        return -EFAULT;
+    }
+    filter_bench_loops = simple_strtol(bench_str, &ptr, 10);
+    filter_bench_chan = simple_strtol(ptr, NULL, 10);
+    if (filter_bench_loops > 10000000) {
+        filter_bench_loops = 10000000;
+    }
+
+    return count;
+}
+
+static int
+proc_filter_bench_release(struct inode *inode, struct file *file)
+{
+    return single_release(inode, file);
+}
+
+static struct proc_ops proc_filter_bench_fops = {
+    PROC_OWNER(THIS_MODULE)
+    .proc_open =        proc_filter_bench_open,
+    .proc_read =        seq_read,
+    .proc_write =       proc_filter_bench_write,
+    .proc_lseek =       seq_lseek,
+    .proc_release =     proc_filter_bench_release,
+};
+
 static int
 proc_netif_info_show(struct seq_file *m, void *v)
 {
@@ -361,6 +452,7 @@ proc_pkt_stats_show(struct seq_file *m, void *v)
 {
     struct ngknet_dev *dev;
     struct bcmcnet_dev_stats *stats;
+    struct ngknet_rxb_stats rxbs;
     int di, qi, ai = 0;
     int rv;
 
@@ -390,6 +482,44 @@ proc_pkt_stats_show(struct seq_file *m, void *v)
         seq_printf(m, "rx_data_errors: %llu\n", (unsigned long long)stats->rxqs.data_errors);
         seq_printf(m, "rx_cell_errors: %llu\n", (unsigned long long)stats->rxqs.cell_errors);
         seq_printf(m, "rx_nomems:      %llu\n", (unsigned long long)stats->rxqs.nomems);
+        seq_printf(m, "rx_doorbells:   %llu\n", (unsigned long long)stats->rxqs.doorbells);
+        sal_memset(&rxbs, 0, sizeof(rxbs));
+        for (qi = 0; qi < NUM_Q_MAX; qi++) {
+            rxbs.allocs += dev->rxb_stats[qi].allocs;
+            rxbs.maps += dev->rxb_stats[qi].maps;
+            rxbs.reuses += dev->rxb_stats[qi].reuses;
+            rxbs.copies += dev->rxb_stats[qi].copies;
+        }
+        seq_printf(m, "rx_buf_allocs:  %llu\n", (unsigned long long)rxbs.allocs);
+        seq_printf(m, "rx_buf_maps:    %llu\n", (unsigned long long)rxbs.maps);
+        seq_printf(m, "rx_buf_reuses:  %llu\n", (unsigned long long)rxbs.reuses);
+        seq_printf(m, "rx_buf_copies:  %llu\n", (unsigned long long)rxbs.copies);
+        if (stats->rxqs.packets) {
+            /* Buffers not taken from the allocator, per received packet */
+            seq_printf(m, "rx_buf_recycle: %llu%%\n",
+                       (unsigned long long)div64_u64(rxbs.reuses * 100,
+                                                     stats->rxqs.packets));
+        }
+#if NGKNET_PAGE_POOL && defined(CONFIG_PAGE_POOL_STATS)
+        for (qi = 0; qi < NUM_Q_MAX; qi++) {
+            struct page_pool_stats pps;
+
+            if (!dev->rx_pool[qi]) {
+                continue;
+            }
+            sal_memset(&pps, 0, sizeof(pps));
+            page_pool_get_stats((struct page_pool *)dev->rx_pool[qi], &pps);
+            seq_printf(m, "rx_pool_fast[%d]:    %llu\n", qi,
+                       (unsigned long long)(pps.alloc_stats.fast +
+                                            pps.alloc_stats.refill));
+            seq_printf(m, "rx_pool_slow[%d]:    %llu\n", qi,
+                       (unsigned long long)(pps.alloc_stats.slow +
+                                            pps.alloc_stats.slow_high_order));
+            seq_printf(m, "rx_pool_recycle[%d]: %llu\n", qi,
+                       (unsigned long long)(pps.recycle_stats.cached +
+                                            pps.recycle_stats.ring));
+        }
+#endif
         seq_printf(m, "tx_packets:     %llu\n", (unsigned long long)stats->txqs.packets);
         seq_printf(m, "tx_bytes:       %llu\n", (unsigned long long)stats->txqs.bytes);
         for (qi = 0; qi < dev->pdma_dev.ctrl.nb_txq; qi++) {
@@ -399,6 +529,7 @@ proc_pkt_stats_show(struct seq_file *m, void *v)
         seq_printf(m, "tx_dropped:     %llu\n", (unsigned long long)stats->txqs.dropped);
         seq_printf(m, "tx_errors:      %llu\n", (unsigned long long)stats->txqs.errors);
         seq_printf(m, "tx_xoffs:       %llu\n", (unsigned long long)stats->txqs.xoffs);
+        seq_printf(m, "tx_doorbells:   %llu\n", (unsigned long long)stats->txqs.doorbells);
         seq_printf(m, "interrupts:     %llu\n", (unsigned long long)stats->intrs);
     }
 
@@ -479,6 +610,100 @@ static struct proc_ops proc_rate_limit_fops = {
     .proc_release =     proc_rate_limit_release,
 };
 
+static int
+proc_queue_rate_limit_show(struct seq_file *m, void *v)
+{
+    struct ngknet_rl_queue rlq;
+    int di, qi, qn = 0;
+
+    seq_printf(m, "%-6s %-6s %-10s %-8s %-8s %-20s %-20s %-10s\n",
+               "dev_no", "queue", "rate", "burst", "protect",
+               "rx_pkts", "rx_overruns", "suspends");
+
+    for (di = 0; di < NUM_PDMA_DEV_MAX; di++) {
+        for (qi = 0; qi < NUM_Q_MAX; qi++) {
+            if (SHR_FAILURE(ngknet_rx_queue_rate_limit_get(di, qi, &rlq))) {
+                continue;
+            }
+            if (rlq.rate < 0 && !rlq.protect && !rlq.rx_pkts) {
+                continue;
+            }
+            qn++;
+            seq_printf(m, "%-6d %-6d %-10d %-8d %-8d %-20llu %-20llu %-10llu\n",
+                       di, qi, rlq.rate, rlq.burst, rlq.protect,
+                       (unsigned long long)rlq.rx_pkts,
+                       (unsigned long long)rlq.rx_overruns,
+                       (unsigned long long)rlq.suspends);
+        }
+    }
+
+    seq_printf(m, "--------------------------------\n");
+    seq_printf(m, "Total %d queues, aggregate limit: %d pps\n",
+               qn, ngknet_rx_rate_limit_get());
+
+    return 0;
+}
+
+static int
+proc_queue_rate_limit_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, proc_queue_rate_limit_show, NULL);
+}
+
+/*
+ * Write "<dev_no> <queue> <rate> [<burst> [<protect>]]", rate -1 for no limit.
+ */
+static ssize_t
+proc_queue_rate_limit_write(struct file *file, const char *buf,
+                            size_t count, loff_t *loff)
+{
+    char limit_str[64] = {0};
+    int val[5] = {0, 0, -1, 0, 0};
+    char *ptr = limit_str;
+    int idx, rv;
+
+    if (copy_from_user(limit_str, buf,
+                       min(count, sizeof(limit_str) - 1))) {
+        return -EFAULT;
+    }
+    for (idx = 0; idx < 5; idx++) {
+        while (*ptr == ' ' || *ptr == '\t') {
+            ptr++;
+        }
+        if (*ptr == '\0' || *ptr == '\n') {
+            break;
+        }
+        val[idx] = simple_strtol(ptr, &ptr, 10);
+    }
+    if (idx < 3) {
+        return -EINVAL;
+    }
+
+    rv = ngknet_rx_queue_rate_limit_set(val[0], val[1], val[2], val[3], val[4]);
+    if (SHR_FAILURE(rv)) {
+        return -EINVAL;
+    }
+    printk("Rx rate limit of device%d queue%d set to: %d pps\n",
+           val[0], val[1], val[2]);
+
+    return count;
+}
+
+static int
+proc_queue_rate_limit_release(struct inode *inode, struct file *file)
+{
+    return single_release(inode, file);
+}
+
+static struct proc_ops proc_queue_rate_limit_fops = {
+    PROC_OWNER(THIS_MODULE)
+    .proc_open =        proc_queue_rate_limit_open,
+    .proc_read =        seq_read,
+    .proc_write =       proc_queue_rate_limit_write,
+    .proc_lseek =       seq_lseek,
+    .proc_release =     proc_queue_rate_limit_release,
+};
+
 static int
 proc_reg_status_show(struct seq_file *m, void *v)
 {
@@ -612,6 +837,12 @@ ngknet_procfs_init(void)
         return -1;
     }
 
+    PROC_CREATE(entry, "filter_bench", 0644, proc_root, &proc_filter_bench_fops);
+    if (entry == NULL) {
+        printk(KERN_ERR "ngknet: proc_create failed\n");
+        return -1;
+    }
+
     PROC_CREATE(entry, "netif_info", 0444, proc_root, &proc_netif_info_fops);
     if (entry == NULL) {
         printk(KERN_ERR "ngknet: proc_create failed\n");
@@ -630,6 +861,12 @@ ngknet_procfs_init(void)
         return -1;
     }
 
+    PROC_CREATE(entry, "queue_rate_limit", 0666, proc_root, &proc_queue_rate_limit_fops);
+    if (entry == NULL) {
+        printk(KERN_ERR "ngknet: proc_create failed\n");
+        return -1;
+    }
+
     PROC_CREATE(entry, "reg_status", 0444, proc_root, &proc_reg_status_fops);
     if (entry == NULL) {
         printk(KERN_ERR "ngknet: proc_create failed\n");
@@ -651,9 +888,11 @@ ngknet_procfs_cleanup(void)
     remove_proc_entry("debug_level", proc_root);
     remove_proc_entry("device_info", proc_root);
     remove_proc_entry("filter_info", proc_root);
+    remove_proc_entry("filter_bench", proc_root);
     remove_proc_entry("netif_info", proc_root);
     remove_proc_entry("pkt_stats", proc_root);
     remove_proc_entry("rate_limit", proc_root);
+    remove_proc_entry("queue_rate_limit", proc_root);
     remove_proc_entry("reg_status", proc_root);
     remove_proc_entry("ring_status", proc_root);
 
@@ -94,10 +94,38 @@ typedef enum bcmlrd_variant_e {
 } bcmlrd_variant_t;
 #endif /* !KPMD */
 
+/*
+ * Compiled Rx PMD field access.
+ *
+ * When a device is initialized, each PMD field the callback uses is
+ * probed through the bcmpkt getter one bit at a time to find the word,
+ * shift and mask it occupies. Fields which are a contiguous bit range
+ * within one word are then read with a single load on the Rx path, while
+ * anything else keeps using the getter.
+ */
+typedef struct pmd_fld_op_s {
+    int fid;
+    bool direct;
+    uint8_t word;
+    uint8_t shift;
+    uint32_t mask;
+} pmd_fld_op_t;
+
+/* How the incoming tag status is derived for a device */
+#define TAG_MODE_NONE       0
+#define TAG_MODE_TAG_TYPE   1
+#define TAG_MODE_MATCH_ID   2
+#define TAG_MODE_ARC_ID     3
+
+/* Random PMD patterns used to check a compiled field against its getter */
+#define PMD_FLD_CHECK_ROUNDS 64
+
 typedef struct ngknetcb_dev_s {
     bool initialized;
     bcmdrd_dev_type_t dev_type;
     bcmlrd_variant_t var_type;
+    int tag_mode;
+    pmd_fld_op_t fld[2];
 } ngknetcb_dev_t;
 
 static ngknetcb_dev_t cb_dev[NUM_PDMA_DEV_MAX];
@@ -224,6 +252,130 @@ strip_vlan_tag(struct sk_buff *skb)
     }
 }
 
+static inline int
+pmd_fld_get(ngknetcb_dev_t *cdev, pmd_fld_op_t *op, uint32_t *rxpmd,
+            uint32_t *val)
+{
+    if (op->direct) {
+        *val = (rxpmd[op->word] >> op->shift) & op->mask;
+        return SHR_E_NONE;
+    }
+
+    return bcmpkt_rxpmd_field_get(cdev->dev_type, rxpmd, op->fid, val);
+}
+
+/* Check a compiled field against its getter on random PMD contents */
+static bool
+pmd_fld_check(ngknetcb_dev_t *cdev, pmd_fld_op_t *op, int pmd_words)
+{
+    uint32_t pmd[BCMPKT_RXPMD_SIZE_WORDS];
+    uint32_t seed = 0x9e3779b9, val;
+    int round, idx;
+
+    for (round = 0; round < PMD_FLD_CHECK_ROUNDS; round++) {
+        for (idx = 0; idx < pmd_words; idx++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            pmd[idx] = seed;
+        }
+        if (SHR_FAILURE(bcmpkt_rxpmd_field_get(cdev->dev_type, pmd,
+                                               op->fid, &val))) {
+            return false;
+        }
+        if (val != ((pmd[op->word] >> op->shift) & op->mask)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void
+pmd_fld_compile(ngknetcb_dev_t *cdev, int fid, pmd_fld_op_t *op,
+                int pmd_words)
+{
+    uint32_t pmd[BCMPKT_RXPMD_SIZE_WORDS];
+    uint32_t val;
+    int bit, lo = -1, hi = -1;
+
+    op->fid = fid;
+    op->direct = false;
+
+    memset(pmd, 0, sizeof(pmd));
+    if (SHR_FAILURE(bcmpkt_rxpmd_field_get(cdev->dev_type, pmd, fid, &val)) ||
+        val != 0) {
+        return;
+    }
+
+    /* Find which PMD bits feed which value bits */
+    for (bit = 0; bit < pmd_words * 32; bit++) {
+        pmd[bit / 32] = 1U << (bit % 32);
+        bcmpkt_rxpmd_field_get(cdev->dev_type, pmd, fid, &val);
+        pmd[bit / 32] = 0;
+        if (val == 0) {
+            continue;
+        }
+        if (lo < 0) {
+            if (val != 1) {
+                return;
+            }
+            lo = bit;
+        } else if (bit != hi + 1 || val != 1U << (bit - lo)) {
+            return;
+        }
+        hi = bit;
+    }
+    if (lo < 0 || lo / 32 != hi / 32) {
+        return;
+    }
+
+    op->word = lo / 32;
+    op->shift = lo % 32;
+    op->mask = (hi - lo == 31) ? 0xffffffff : (1U << (hi - lo + 1)) - 1;
+    op->direct = pmd_fld_check(cdev, op, pmd_words);
+}
+
+/* Select how tag status is derived and compile the fields it needs */
+static void
+pmd_prog_compile(ngknetcb_dev_t *cdev)
+{
+    bcmpkt_rxpmd_fid_support_t support;
+    uint32_t len = 0;
+    int pmd_words;
+
+    cdev->tag_mode = TAG_MODE_NONE;
+    memset(cdev->fld, 0, sizeof(cdev->fld));
+    if (SHR_FAILURE(bcmpkt_rxpmd_fid_support_get(cdev->dev_type, &support)) ||
+        SHR_FAILURE(bcmpkt_rxpmd_len_get(cdev->dev_type, &len))) {
+        return;
+    }
+    pmd_words = len / 4;
+    if (pmd_words > BCMPKT_RXPMD_SIZE_WORDS) {
+        pmd_words = BCMPKT_RXPMD_SIZE_WORDS;
+    }
+
+    if (BCMPKT_RXPMD_FID_SUPPORT_GET(support, BCMPKT_RXPMD_ING_TAG_TYPE)) {
+        cdev->tag_mode = TAG_MODE_TAG_TYPE;
+        pmd_fld_compile(cdev, BCMPKT_RXPMD_ING_TAG_TYPE, &cdev->fld[0],
+                        pmd_words);
+    } else if (BCMPKT_RXPMD_FID_SUPPORT_GET(support, BCMPKT_RXPMD_MATCH_ID_LO) &&
+               BCMPKT_RXPMD_FID_SUPPORT_GET(support, BCMPKT_RXPMD_MATCH_ID_HI)) {
+        cdev->tag_mode = TAG_MODE_MATCH_ID;
+        pmd_fld_compile(cdev, BCMPKT_RXPMD_MATCH_ID_LO, &cdev->fld[0],
+                        pmd_words);
+        pmd_fld_compile(cdev, BCMPKT_RXPMD_MATCH_ID_HI, &cdev->fld[1],
+                        pmd_words);
+    } else if (BCMPKT_RXPMD_FID_SUPPORT_GET(support, BCMPKT_RXPMD_ARC_ID_LO) &&
+               BCMPKT_RXPMD_FID_SUPPORT_GET(support, BCMPKT_RXPMD_ARC_ID_HI)) {
+        cdev->tag_mode = TAG_MODE_ARC_ID;
+        pmd_fld_compile(cdev, BCMPKT_RXPMD_ARC_ID_LO, &cdev->fld[0],
+                        pmd_words);
+        pmd_fld_compile(cdev, BCMPKT_RXPMD_ARC_ID_HI, &cdev->fld[1],
+                        pmd_words);
+    }
+}
+
 /*
  * The function get_tag_status() returns the tag status.
  * 0  = Untagged
@@ -233,9 +385,10 @@ strip_vlan_tag(struct sk_buff *skb)
  * -1 = Unsupported type
  */
 static int
-get_tag_status(uint32_t dev_type, uint32_t variant, void *rxpmd)
+get_tag_status(ngknetcb_dev_t *cdev, void *rxpmd)
 {
     int rv;
+    uint32_t variant = cdev->var_type;
     const char *tag_type[4] = {
         "Untagged",
         "Inner Tagged",
@@ -243,14 +396,10 @@ get_tag_status(uint32_t dev_type, uint32_t variant, void *rxpmd)
         "Double Tagged"
     };
     int tag_status = -1;
-    bcmpkt_rxpmd_fid_support_t support;
     uint32_t val = 0;
 
-    bcmpkt_rxpmd_fid_support_get(dev_type, &support);
-
-    if (BCMPKT_RXPMD_FID_SUPPORT_GET(support, BCMPKT_RXPMD_ING_TAG_TYPE)) {
-        rv = bcmpkt_rxpmd_field_get(dev_type, (uint32_t *)rxpmd,
-                                    BCMPKT_RXPMD_ING_TAG_TYPE, &val);
+    if (cdev->tag_mode == TAG_MODE_TAG_TYPE) {
+        rv = pmd_fld_get(cdev, &cdev->fld[0], rxpmd, &val);
         /* Tomahawk4 family */
 
         /*
@@ -277,16 +426,15 @@ get_tag_status(uint32_t dev_type, uint32_t variant, void *rxpmd)
                 tag_status = 0;
             }
         }
-    } else if (BCMPKT_RXPMD_FID_SUPPORT_GET(support, BCMPKT_RXPMD_MATCH_ID_LO) &&
-               BCMPKT_RXPMD_FID_SUPPORT_GET(support, BCMPKT_RXPMD_MATCH_ID_HI)) {
+    } else if (cdev->tag_mode == TAG_MODE_MATCH_ID) {
         /* Trident4 family. */
         uint32_t match_id_data[2];
         bool itag = false, otag = false;
-        
-        bcmpkt_rxpmd_field_get(dev_type, rxpmd, BCMPKT_RXPMD_MATCH_ID_LO,
-                               &match_id_data[0]);
-        bcmpkt_rxpmd_field_get(dev_type, rxpmd, BCMPKT_RXPMD_MATCH_ID_HI,
-                               &match_id_data[1]);
+
+        if (SHR_FAILURE(pmd_fld_get(cdev, &cdev->fld[0], rxpmd, &match_id_data[0])) ||
+            SHR_FAILURE(pmd_fld_get(cdev, &cdev->fld[1], rxpmd, &match_id_data[1]))) {
+            goto exit;
+        }
         rv = bcmpkt_rxpmd_match_id_present(variant, match_id_data, 2,
                                            match_id.ingress_pkt_outer_l2_hdr_itag);
         if (SHR_SUCCESS(rv)) {
@@ -306,16 +454,15 @@ get_tag_status(uint32_t dev_type, uint32_t variant, void *rxpmd)
         } else {
             tag_status = 0;
         }
-    } else if (BCMPKT_RXPMD_FID_SUPPORT_GET(support, BCMPKT_RXPMD_ARC_ID_LO) &&
-               BCMPKT_RXPMD_FID_SUPPORT_GET(support, BCMPKT_RXPMD_ARC_ID_HI)){
+    } else if (cdev->tag_mode == TAG_MODE_ARC_ID) {
         /* Trident5 Family*/
         uint32_t match_id_data[2];
         bool itag = false, otag = false;
 
-        bcmpkt_rxpmd_field_get(dev_type, rxpmd, BCMPKT_RXPMD_ARC_ID_LO,
-                               &match_id_data[0]);
-        bcmpkt_rxpmd_field_get(dev_type, rxpmd, BCMPKT_RXPMD_ARC_ID_HI,
-                               &match_id_data[1]);
+        if (SHR_FAILURE(pmd_fld_get(cdev, &cdev->fld[0], rxpmd, &match_id_data[0])) ||
+            SHR_FAILURE(pmd_fld_get(cdev, &cdev->fld[1], rxpmd, &match_id_data[1]))) {
+            goto exit;
+        }
         rv = bcmpkt_rxpmd_match_id_from_arc_id_present(variant, match_id_data, 2,
                                            match_id.ingress_pkt_outer_l2_hdr_itag);
         if (SHR_SUCCESS(rv)) {
@@ -336,6 +483,8 @@ get_tag_status(uint32_t dev_type, uint32_t variant, void *rxpmd)
             tag_status = 0;
         }
     }
+
+exit:
 #ifdef KNET_CB_DEBUG
     if (debug & NGKNET_CB_DBG_LVL_VERB) {
         if (tag_status != -1) {
@@ -447,8 +596,7 @@ strip_tag_rx_cb(struct sk_buff *skb)
             dev_type = cb_dev[unit].dev_type;
             var_type = cb_dev[unit].var_type;
             if (FILTER_TAG_ORIGINAL == cbd->filt->user_data[0]) {
-                tag_status = get_tag_status(dev_type, var_type,
-                        (void *)rxpmd);
+                tag_status = get_tag_status(&cb_dev[unit], (void *)rxpmd);
                 if (tag_status < 0) {
                     strip_stats.skipped++;
                     goto _strip_tag_rx_cb_exit;
@@ -681,6 +829,21 @@ init_cb(ngknet_dev_info_t *dinfo)
         printk("dev_type: %d\n", cb_dev[unit].dev_type);
         printk("variant: %d\n", cb_dev[unit].var_type);
     }
+#endif /* KNET_CB_DEBUG */
+    pmd_prog_compile(&cb_dev[unit]);
+#ifdef KNET_CB_DEBUG
+    if (debug & 1) {
+        int idx;
+
+        printk("tag mode: %d\n", cb_dev[unit].tag_mode);
+        for (idx = 0; idx < 2; idx++) {
+            pmd_fld_op_t *op = &cb_dev[unit].fld[idx];
+            if (op->direct) {
+                printk("  fid %d: word %d shift %d mask 0x%x\n",
+                       op->fid, op->word, op->shift, op->mask);
+            }
+        }
+    }
 #endif /* KNET_CB_DEBUG */
     cb_dev[unit].initialized = true;
 #ifdef KPMD
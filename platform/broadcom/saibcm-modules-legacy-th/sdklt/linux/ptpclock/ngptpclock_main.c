@@ -79,6 +79,12 @@ module_param(fw_core, int, 0);
 MODULE_PARM_DESC(fw_core,
         "Firmware core (default 0)");
 
+/* Must exceed the time keep period, so reads do not fall back to firmware between refreshes */
+static int gettime_max_age = 2500;
+module_param(gettime_max_age, int, 0);
+MODULE_PARM_DESC(gettime_max_age,
+        "Max age in ms of the time pair used to extrapolate PHC reads, 0 to always query firmware (default 2500)");
+
 static int pci_cos;
 
 /* Debug levels */
@@ -105,6 +111,10 @@ static int pci_cos;
 #define DMA_ALLOC_COHERENT(d,s,h)       dma_alloc_coherent(d,s,h,GFP_ATOMIC|GFP_DMA32)
 #define DMA_FREE_COHERENT(d,s,a,h)      dma_free_coherent(d,s,a,h)
 
+/* Baseline bounds for measuring the time pair rate */
+#define NGPTPCLOCK_TP_RATE_MIN_NS       (4ULL * NSEC_PER_SEC)
+#define NGPTPCLOCK_TP_RATE_MAX_NS       (64ULL * NSEC_PER_SEC)
+
 /* Type length in bytes */
 #define NGPTPCLOCK_PACKLEN_U8     1
 #define NGPTPCLOCK_PACKLEN_U16    2
@@ -413,6 +423,16 @@ struct ngptpclock_ptp_priv {
     int timekeep_status;
     u32 mirror_encap_bmp;
     struct delayed_work time_keep;
+    seqlock_t tp_lock;          /* Protects the published time pair. */
+    u32 tp_gen;                 /* Bumped whenever the time pair is invalidated. */
+    int tp_valid;
+    u64 tp_ptptime;             /* PTP time of the last firmware read. */
+    u64 tp_systime;             /* Host raw time of the last firmware read. */
+    s64 tp_rate;                /* PTP clock rate relative to host in ppb. */
+    u64 tp_anchor_ptptime;      /* Start of the rate measurement baseline. */
+    u64 tp_anchor_systime;
+    atomic64_t tp_cached_reads;
+    atomic64_t tp_fw_reads;
     ngptpclock_port_stats_t *port_stats;
     ngptpclock_init_info_t ngptpclock_init_info;
     ngptpclock_bs_info_t ngptpclock_bs_info[2];
@@ -720,59 +740,137 @@ ngptpclock_cmd_go(u32 cmd, void *data0, void *data1)
 
 
 /**
- * ngptpclock_ptp_adjfreq
+ * ngptpclock_ptp_time_pair_invalidate
  *
- * @ptp: pointer to ptp_clock_info structure
- * @ppb: frequency correction value
+ * Description: this function drops the published time pair so that the
+ * next PHC read goes to firmware. It must be called before any operation
+ * which steps the clock, so that no reader extrapolates across the step,
+ * and again once the operation completes to discard pairs read from
+ * firmware while it was pending.
+ */
+static void ngptpclock_ptp_time_pair_invalidate(void)
+{
+    write_seqlock(&ptp_priv->tp_lock);
+    ptp_priv->tp_valid = 0;
+    ptp_priv->tp_gen++;
+    write_sequnlock(&ptp_priv->tp_lock);
+}
+
+/**
+ * ngptpclock_ptp_time_pair_rebase
  *
- * Description: this function will set the frequency correction
+ * @systime: host raw time at which the frequency correction took effect
+ * @dppb: change of the frequency correction in ppb
+ *
+ * Description: this function moves the time pair to the point at which
+ * the frequency correction changed and applies the change to the rate,
+ * so that PHC reads stay extrapolated across the adjustment. The rate
+ * measurement baseline is kept: its anchor is moved back by the time
+ * the change would have added since the anchor, as if the new correction
+ * had been in effect all along. The next measurement then yields the
+ * rate under the new correction, including the natural offset between
+ * the host and PTP clocks, even when the servo adjusts every second.
  */
-static int ngptpclock_ptp_adjfreq(struct ptp_clock_info *ptp, s32 ppb)
+static void ngptpclock_ptp_time_pair_rebase(u64 systime, s64 dppb)
 {
-    int ret = -1;
+    s64 age, span;
 
-    ret = ngptpclock_cmd_go(NGPTPCLOCK_FREQCOR, &ppb, NULL);
-    DBG_VERB(("ptp_adjfreq: applying freq correction: %x; rv:%d\n", ppb, ret));
+    write_seqlock(&ptp_priv->tp_lock);
 
-    return ret;
+    if (ptp_priv->tp_valid) {
+        age = systime - ptp_priv->tp_systime;
+        ptp_priv->tp_ptptime += age + div_s64(age * ptp_priv->tp_rate, NSEC_PER_SEC);
+        ptp_priv->tp_systime = systime;
+        /* In us, the baseline times any s32 correction fits in 64 bits */
+        span = div_s64(systime - ptp_priv->tp_anchor_systime, NSEC_PER_USEC);
+        ptp_priv->tp_anchor_ptptime -= div_s64(span * dppb, USEC_PER_SEC);
+    }
+    ptp_priv->tp_rate += dppb;
+
+    /* Reads overlapping the adjustment mix both rates, drop them */
+    ptp_priv->tp_gen++;
+
+    write_sequnlock(&ptp_priv->tp_lock);
 }
 
 /**
- * ngptpclock_ptp_adjtime
+ * ngptpclock_ptp_time_pair_publish
  *
- * @ptp: pointer to ptp_clock_info structure
- * @delta: desired change in nanoseconds
+ * @ptptime: PTP time read from firmware
+ * @systime: host raw time of the read
+ * @gen: time pair generation sampled before the read
  *
- * Description: this function will shift/adjust the hardware clock time.
+ * Description: this function publishes a new time pair and updates the
+ * rate of the PTP clock relative to the host clock. The rate is measured
+ * over a baseline of several seconds to average out the firmware command
+ * latency. Frequency corrections are applied to the rate as they are
+ * made and folded into the baseline, see ngptpclock_ptp_time_pair_rebase().
  */
-static int ngptpclock_ptp_adjtime(struct ptp_clock_info *ptp, s64 delta)
+static void ngptpclock_ptp_time_pair_publish(u64 ptptime, u64 systime, u32 gen)
 {
-    int ret = -1;
+    s64 dptp, dsys, drift;
+    int anchor = 0;
 
-    ret = ngptpclock_cmd_go(NGPTPCLOCK_ADJTIME, (void *)&delta, NULL);
-    DBG_VERB(("ptp_adjtime: adjtime: 0x%llx; rv:%d\n", delta, ret));
+    write_seqlock(&ptp_priv->tp_lock);
 
-    return ret;
+    /* Clock was stepped or retuned while firmware was being queried */
+    if (gen != ptp_priv->tp_gen) {
+        write_sequnlock(&ptp_priv->tp_lock);
+        return;
+    }
+
+    if (!ptp_priv->tp_valid) {
+        anchor = 1;
+    } else {
+        dptp = ptptime - ptp_priv->tp_anchor_ptptime;
+        dsys = systime - ptp_priv->tp_anchor_systime;
+        drift = dptp - dsys;
+        if (dsys <= 0 || (u64)dsys > NGPTPCLOCK_TP_RATE_MAX_NS) {
+            anchor = 1;
+        } else if (drift > (dsys >> 10) || -drift > (dsys >> 10)) {
+            /* Unexpected step, restart the measurement */
+            DBG_WARN(("ptp_time_pair: drift %lld ns over %lld ns\n", drift, dsys));
+            anchor = 1;
+        } else if ((u64)dsys >= NGPTPCLOCK_TP_RATE_MIN_NS) {
+            ptp_priv->tp_rate = div64_s64(drift * NSEC_PER_SEC, dsys);
+        }
+    }
+
+    if (anchor) {
+        ptp_priv->tp_anchor_ptptime = ptptime;
+        ptp_priv->tp_anchor_systime = systime;
+    }
+    ptp_priv->tp_ptptime = ptptime;
+    ptp_priv->tp_systime = systime;
+    ptp_priv->tp_valid = 1;
+
+    write_sequnlock(&ptp_priv->tp_lock);
 }
 
 /**
- * ngptpclock_ptp_gettime
+ * ngptpclock_ptp_time_pair_update
  *
- * @ptp: pointer to ptp_clock_info structure
- * @ts: pointer to hold time/result
+ * @ptptime: pointer to hold the PTP time
  *
- * Description: this function will read the current time from the
- * hardware clock and store it in @ts.
+ * Description: this function reads the current time from firmware,
+ * refreshes the time pair in shared memory and publishes it for
+ * lock-free PHC reads.
  */
-static int ngptpclock_ptp_gettime(struct ptp_clock_info *ptp, struct timespec64 *ts)
+static int ngptpclock_ptp_time_pair_update(u64 *ptptime)
 {
     int ret = -1;
     s64 reftime = 0;
     s64 refctr = 0;
     static u64 prv_reftime = 0, prv_refctr = 0;
     u64 diff_reftime = 0, diff_refctr = 0;
+    u64 pre, post;
+    u32 gen;
 
+    gen = READ_ONCE(ptp_priv->tp_gen);
+    pre = ktime_get_raw_ns();
     ret = ngptpclock_cmd_go(NGPTPCLOCK_GETTIME, (void *)&reftime, (void *)&refctr);
+    post = ktime_get_raw_ns();
+    atomic64_inc(&ptp_priv->tp_fw_reads);
     if (ret == 0) {
         DBG_VERB(("ptp_gettime: gettime: 0x%llx refctr:0x%llx\n", reftime, refctr));
 
@@ -797,11 +895,161 @@ static int ngptpclock_ptp_gettime(struct ptp_clock_info *ptp, struct timespec64
         prv_reftime = reftime;
         prv_refctr = refctr;
 
-        *ts = ns_to_timespec64(reftime);
+        /* Firmware sampled the clock somewhere within the command window */
+        ngptpclock_ptp_time_pair_publish(reftime, pre + ((post - pre) >> 1), gen);
+
+        *ptptime = reftime;
+    }
+    return ret;
+}
+
+/**
+ * ngptpclock_ptp_time_pair_extrapolate
+ *
+ * @ptptime: pointer to hold the PTP time
+ *
+ * Description: this function derives the current PTP time from the
+ * published time pair and the host clock without querying firmware.
+ * It fails if no time pair is available or it is older than
+ * gettime_max_age.
+ */
+static int ngptpclock_ptp_time_pair_extrapolate(u64 *ptptime)
+{
+    unsigned int seq;
+    int valid;
+    u64 base, systime, age;
+    s64 rate;
+
+    if (gettime_max_age <= 0) {
+        return -1;
+    }
+
+    do {
+        seq = read_seqbegin(&ptp_priv->tp_lock);
+        valid = ptp_priv->tp_valid;
+        base = ptp_priv->tp_ptptime;
+        systime = ptp_priv->tp_systime;
+        rate = ptp_priv->tp_rate;
+    } while (read_seqretry(&ptp_priv->tp_lock, seq));
+
+    if (!valid) {
+        return -1;
+    }
+
+    age = ktime_get_raw_ns() - systime;
+    if ((s64)age < 0 || age > (u64)gettime_max_age * NSEC_PER_MSEC) {
+        return -1;
+    }
+
+    *ptptime = base + age + div_s64((s64)age * rate, NSEC_PER_SEC);
+    atomic64_inc(&ptp_priv->tp_cached_reads);
+
+    return 0;
+}
+
+/**
+ * ngptpclock_ptp_adjfreq
+ *
+ * @ptp: pointer to ptp_clock_info structure
+ * @ppb: frequency correction value
+ *
+ * Description: this function will set the frequency correction
+ */
+static int ngptpclock_ptp_adjfreq(struct ptp_clock_info *ptp, s32 ppb)
+{
+    int ret = -1;
+    s64 dppb;
+    u64 pre, post;
+
+    /* Firmware shared memory is only set up once the SDK has started it */
+    if (ptp_priv->shared_addr == NULL) {
+        return ret;
     }
+
+    dppb = (s64)ppb - ptp_priv->shared_addr->freqcorr;
+    pre = ktime_get_raw_ns();
+    ret = ngptpclock_cmd_go(NGPTPCLOCK_FREQCOR, &ppb, NULL);
+    post = ktime_get_raw_ns();
+    if (ret == 0) {
+        ngptpclock_ptp_time_pair_rebase(pre + ((post - pre) >> 1), dppb);
+    } else {
+        ngptpclock_ptp_time_pair_invalidate();
+    }
+    DBG_VERB(("ptp_adjfreq: applying freq correction: %x; rv:%d\n", ppb, ret));
+
     return ret;
 }
 
+/**
+ * ngptpclock_ptp_adjtime
+ *
+ * @ptp: pointer to ptp_clock_info structure
+ * @delta: desired change in nanoseconds
+ *
+ * Description: this function will shift/adjust the hardware clock time.
+ */
+static int ngptpclock_ptp_adjtime(struct ptp_clock_info *ptp, s64 delta)
+{
+    int ret = -1;
+
+    ngptpclock_ptp_time_pair_invalidate();
+    ret = ngptpclock_cmd_go(NGPTPCLOCK_ADJTIME, (void *)&delta, NULL);
+    ngptpclock_ptp_time_pair_invalidate();
+    DBG_VERB(("ptp_adjtime: adjtime: 0x%llx; rv:%d\n", delta, ret));
+
+    return ret;
+}
+
+/**
+ * ngptpclock_ptp_gettime
+ *
+ * @ptp: pointer to ptp_clock_info structure
+ * @ts: pointer to hold time/result
+ *
+ * Description: this function will read the current time from the
+ * hardware clock and store it in @ts. The time is extrapolated from
+ * the published time pair when it is fresh, otherwise it is read
+ * from firmware.
+ */
+static int ngptpclock_ptp_gettime(struct ptp_clock_info *ptp, struct timespec64 *ts)
+{
+    int ret = -1;
+    u64 ptptime = 0;
+
+    ret = ngptpclock_ptp_time_pair_extrapolate(&ptptime);
+    if (ret < 0) {
+        ret = ngptpclock_ptp_time_pair_update(&ptptime);
+    }
+    if (ret == 0) {
+        *ts = ns_to_timespec64(ptptime);
+    }
+    return ret;
+}
+
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,0,0))
+/**
+ * ngptpclock_ptp_gettimex
+ *
+ * @ptp: pointer to ptp_clock_info structure
+ * @ts: pointer to hold time/result
+ * @sts: pointer to hold the system timestamps around the read
+ *
+ * Description: this function will read the current time from the
+ * hardware clock along with the system time before and after the read.
+ */
+static int ngptpclock_ptp_gettimex(struct ptp_clock_info *ptp, struct timespec64 *ts,
+                                   struct ptp_system_timestamp *sts)
+{
+    int ret = -1;
+
+    ptp_read_system_prets(sts);
+    ret = ngptpclock_ptp_gettime(ptp, ts);
+    ptp_read_system_postts(sts);
+
+    return ret;
+}
+#endif
+
 
 /**
  * ngptpclock_ptp_settime
@@ -821,7 +1069,9 @@ static int ngptpclock_ptp_settime(struct ptp_clock_info *ptp,
     phaseadj = 0;
     reftime = timespec64_to_ns(ts);
 
+    ngptpclock_ptp_time_pair_invalidate();
     ret = ngptpclock_cmd_go(NGPTPCLOCK_SETTIME, (void *)&reftime, (void *)&phaseadj);
+    ngptpclock_ptp_time_pair_invalidate();
     DBG_VERB(("ptp_settime: settime: 0x%llx; rv:%d\n", reftime, ret));
 
     return ret;
@@ -957,6 +1207,9 @@ static struct ptp_clock_info ngptpclock_ptp_caps = {
     .adjfreq = ngptpclock_ptp_adjfreq,
     .adjtime = ngptpclock_ptp_adjtime,
     .gettime64 = ngptpclock_ptp_gettime,
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,0,0))
+    .gettimex64 = ngptpclock_ptp_gettimex,
+#endif
     .settime64 = ngptpclock_ptp_settime,
     .enable = ngptpclock_ptp_enable,
 };
@@ -1800,10 +2053,10 @@ ngptpclock_ptp_time_keep(struct work_struct *work)
     struct delayed_work *dwork = to_delayed_work(work);
     struct ngptpclock_ptp_priv *priv =
                         container_of(dwork, struct ngptpclock_ptp_priv, time_keep);
-    struct timespec64 ts;
+    u64 ptptime;
 
-    /* Call bcm_ptp_gettime function to keep the ref_time_64 and ref_counter_48 in sync */
-    ngptpclock_ptp_gettime(&(priv->ptp_caps), &ts);
+    /* Read firmware time to keep the ref_time_64 and ref_counter_48 in sync */
+    ngptpclock_ptp_time_pair_update(&ptptime);
     schedule_delayed_work(&priv->time_keep, HZ);
 }
 
@@ -1921,7 +2174,9 @@ ngptpclock_ptp_init(struct ptp_clock_info *ptp)
 {
     int ret = -1;
 
+    ngptpclock_ptp_time_pair_invalidate();
     ret = ngptpclock_cmd_go(NGPTPCLOCK_INIT, NULL, NULL);
+    ngptpclock_ptp_time_pair_invalidate();
     DBG_VERB(("ptp_init: NGPTPCLOCK_INIT; rv:%d\n", ret));
     if (ret < 0) goto err_exit;
     ptp_sleep(1);
@@ -1937,7 +2192,9 @@ ngptpclock_ptp_cleanup(struct ptp_clock_info *ptp)
 
     ngptpclock_ptp_time_keep_cleanup();
 
+    ngptpclock_ptp_time_pair_invalidate();
     ret = ngptpclock_cmd_go(NGPTPCLOCK_CLEANUP, NULL, NULL);
+    ngptpclock_ptp_time_pair_invalidate();
     DBG_VERB(("ptp_cleanup: rv:%d\n", ret));
 
     return ret;
@@ -2230,6 +2487,12 @@ ngptpclock_proc_debug_show(struct seq_file *m, void *v)
 {
     seq_printf(m, "Configuration:\n");
     seq_printf(m, "  debug:          0x%x\n", debug);
+    seq_printf(m, "  gettime_max_age: %d ms\n", gettime_max_age);
+    seq_printf(m, "Time pair:\n");
+    seq_printf(m, "  valid:          %d\n", ptp_priv->tp_valid);
+    seq_printf(m, "  rate:           %lld ppb\n", ptp_priv->tp_rate);
+    seq_printf(m, "  cached reads:   %lld\n", (s64)atomic64_read(&ptp_priv->tp_cached_reads));
+    seq_printf(m, "  firmware reads: %lld\n", (s64)atomic64_read(&ptp_priv->tp_fw_reads));
     return 0;
 }
 
@@ -2921,6 +3184,7 @@ ngptpclock_ptp_register(void)
     ptp_priv->ptp_caps = ngptpclock_ptp_caps;
 
     mutex_init(&(ptp_priv->ptp_lock));
+    seqlock_init(&(ptp_priv->tp_lock));
 
     /* Register ptp clock driver with ngptpclock_ptp_caps */
     ptp_priv->ptp_clock = ptp_clock_register(&ptp_priv->ptp_caps, NULL);
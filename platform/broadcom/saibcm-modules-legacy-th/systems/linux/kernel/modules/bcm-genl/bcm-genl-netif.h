@@ -32,6 +32,9 @@
 
 #include <linux/netdevice.h>
 
+/* ports below this are resolved through a port-indexed table */
+#define BCMGENL_NETIF_PORT_MAX 1024
+
 /* generic netlink data per interface */
 typedef struct {
     struct net_device *dev;
@@ -53,6 +53,11 @@
 #include <linux/sched.h>
 #include <linux/netdevice.h>
 #include <net/net_namespace.h>
+#include <linux/percpu.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
 #include "bcm-genl-psample.h"
 #include "bcm-genl-dev.h"
 #include "bcm-genl-netif.h"
@@ -86,6 +91,35 @@ LKM_MOD_PARAM(psample_qlen, "i", int, 0);
 MODULE_PARM_DESC(psample_qlen,
 "psample queue length (default 1024 buffers)");
 
+#define PSAMPLE_QLEN_MAX_DFLT 8192
+static int psample_qlen_max = PSAMPLE_QLEN_MAX_DFLT;
+LKM_MOD_PARAM(psample_qlen_max, "i", int, 0);
+MODULE_PARM_DESC(psample_qlen_max,
+"psample queue length the queue may grow to under bursts (default 8192 buffers)");
+
+#define PSAMPLE_BUDGET_DFLT 64
+static int psample_budget = PSAMPLE_BUDGET_DFLT;
+LKM_MOD_PARAM(psample_budget, "i", int, 0);
+MODULE_PARM_DESC(psample_budget,
+"psample pkts delivered per batch before yielding (default 64)");
+
+static int psample_cpu = -1;
+LKM_MOD_PARAM(psample_cpu, "i", int, 0);
+MODULE_PARM_DESC(psample_cpu,
+"CPU to bind the psample delivery thread to (default -1 for any)");
+
+#define PSAMPLE_RING_LEN_DFLT 128
+static int psample_ring_len = PSAMPLE_RING_LEN_DFLT;
+LKM_MOD_PARAM(psample_ring_len, "i", int, 0);
+MODULE_PARM_DESC(psample_ring_len,
+"psample preallocated buffers per CPU, 0 to disable (default 128 buffers)");
+
+#define PSAMPLE_BUF_SIZE_DFLT 256
+static int psample_buf_size = PSAMPLE_BUF_SIZE_DFLT;
+LKM_MOD_PARAM(psample_buf_size, "i", int, 0);
+MODULE_PARM_DESC(psample_buf_size,
+"psample preallocated buffer size (default 256 bytes)");
+
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,13,0))
 static inline void
 bcmgenl_sample_packet(struct psample_group *group, struct sk_buff *skb,
@@ -134,10 +168,14 @@ typedef struct psample_stats_s {
     unsigned long pkts_f_tag_stripped;
     unsigned long pkts_f_dst_mc;
     unsigned long pkts_f_dst_cpu;
+    unsigned long pkts_f_ring;
+    unsigned long pkts_f_alloc;
+    unsigned long bytes_f_copied;
     unsigned long pkts_c_qlen_cur;
     unsigned long pkts_c_qlen_hi;
     unsigned long pkts_d_qlen_max;
     unsigned long pkts_d_no_mem;
+    unsigned long pkts_d_ring_full;
     unsigned long pkts_d_no_group;
     unsigned long pkts_d_sampling_disabled;
     unsigned long pkts_d_not_ready;
@@ -167,15 +205,91 @@ typedef struct psample_pkt_s {
     struct psample_group *group;
     psample_meta_t meta;
     struct sk_buff *skb;
+    u64 stamp;
 } psample_pkt_t;
 
+/*
+ * Delivery to psample runs in a dedicated thread, so sampling accuracy does
+ * not depend on the latency of the system workqueue. The thread takes the
+ * whole pending list in one lock acquisition and yields every
+ * psample_budget pkts. The queue limit starts at psample_qlen and doubles,
+ * up to psample_qlen_max, when pkts are dropped while the thread is keeping
+ * up; it halves again once the queue has been idle for a second. Tail drops
+ * are only counted by the filter callbacks, the queue limit is adjusted by
+ * the thread alone.
+ */
 typedef struct psample_work_s {
     struct list_head pkt_list;
-    struct work_struct wq;
+    struct task_struct *task;
     spinlock_t lock;
+    int qlen_limit;
+    unsigned long last_batch;
+    unsigned long last_grow;
+    atomic_long_t drops;
 } psample_work_t;
 static psample_work_t g_psample_work;
 
+/* Histograms, bucket i counts values in [2^(i-1), 2^i) */
+#define PSAMPLE_HIST_BUCKETS 16
+typedef struct psample_hist_s {
+    unsigned long latency_us[PSAMPLE_HIST_BUCKETS];
+    unsigned long batch_pkts[PSAMPLE_HIST_BUCKETS];
+    unsigned long batch_drops[PSAMPLE_HIST_BUCKETS];
+} psample_hist_t;
+static psample_hist_t g_psample_hist;
+
+static inline void
+psample_hist_add(unsigned long *hist, unsigned long val)
+{
+    int idx = val ? fls64(val) : 0;
+
+    if (idx >= PSAMPLE_HIST_BUCKETS) {
+        idx = PSAMPLE_HIST_BUCKETS - 1;
+    }
+    hist[idx]++;
+}
+
+static inline u64
+psample_now(void)
+{
+    return ktime_to_ns(ktime_get());
+}
+
+static inline void
+psample_wakeup(void)
+{
+    if (g_psample_work.task) {
+        wake_up_process(g_psample_work.task);
+    }
+}
+
+/*
+ * Preallocated sample buffers.
+ *
+ * Each CPU has a ring of fixed size buffers that the filter callback fills
+ * with the truncated sample, without allocating anything in softirq. The
+ * ring has a single producer, the callback on its CPU, and a single
+ * consumer, the delivery thread. Samples that do not fit a buffer take the
+ * allocating pkt_list path.
+ */
+typedef struct psample_slot_s {
+    struct psample_group *group;
+    psample_meta_t meta;
+    u64 stamp;
+    int orig_size;
+    int len;
+    uint8_t *data;
+} psample_slot_t;
+
+typedef struct psample_ring_s {
+    unsigned int head;
+    unsigned int tail;
+    unsigned int mask;
+    psample_slot_t *slots;
+    uint8_t *bufs;
+} psample_ring_t;
+static psample_ring_t __percpu *g_psample_rings;
+
 static struct psample_group *
 psample_group_get_from_list(uint32_t grp_num)
 {
@@ -289,7 +403,9 @@ psample_meta_get(int dev_no, kcom_filter_t *kf, void *pkt_meta,
     srcport = psample_meta_srcport_get(dev_no, pkt_meta);
     dstport = psample_meta_dstport_get(dev_no, pkt_meta, &mcast);
     if ((srcport == -1) || (dstport == -1)) {
-        gprintk("%s: invalid srcport %d or dstport %d\n", __func__, srcport, dstport);
+        if (net_ratelimit()) {
+            gprintk("%s: invalid srcport %d or dstport %d\n", __func__, srcport, dstport);
+        }
         return -1;
     }
 
@@ -342,44 +458,244 @@ psample_meta_get(int dev_no, kcom_filter_t *kf, void *pkt_meta,
     return 0;
 }
 
+/*
+ * Copy a sample, without the VLAN tag if strip_tag is set, up to len bytes.
+ */
 static void
-psample_task(struct work_struct *work)
+psample_pkt_copy(uint8_t *dst, uint8_t *pkt, int len, bool strip_tag)
 {
-    psample_work_t *psample_work = container_of(work, psample_work_t, wq);
-    unsigned long flags;
+    if (strip_tag && len > 12) {
+        memcpy(dst, pkt, 12);
+        memcpy(dst + 12, pkt + 16, len - 12);
+    } else {
+        memcpy(dst, pkt, len);
+    }
+}
+
+/*
+ * psample reports skb->len as the original packet size but copies at most
+ * trunc_size bytes, so the bytes of a sample that were never copied are
+ * covered with the zero page rather than allocated.
+ */
+static int
+psample_skb_pad(struct sk_buff *skb, int pad)
+{
+    int frag, chunk;
+
+    for (frag = 0; pad > 0; frag++) {
+        if (frag >= MAX_SKB_FRAGS) {
+            return -1;
+        }
+        chunk = min_t(int, pad, PAGE_SIZE);
+        get_page(ZERO_PAGE(0));
+        skb_add_rx_frag(skb, frag, ZERO_PAGE(0), 0, chunk, chunk);
+        pad -= chunk;
+    }
+
+    return 0;
+}
+
+static struct sk_buff *
+psample_slot_skb(psample_slot_t *slot)
+{
+    struct sk_buff *skb;
+
+    if ((skb = dev_alloc_skb(slot->len)) == NULL) {
+        return NULL;
+    }
+    memcpy(skb_put(skb, slot->len), slot->data, slot->len);
+    if (psample_skb_pad(skb, slot->orig_size - slot->len) < 0) {
+        dev_kfree_skb_any(skb);
+        return NULL;
+    }
+
+    return skb;
+}
+
+static int
+psample_ring_drain(psample_ring_t *ring, int budget)
+{
+    psample_slot_t *slot;
+    struct sk_buff *skb;
+    unsigned int head, tail;
+    int done = 0;
+
+    tail = ring->tail;
+    head = smp_load_acquire(&ring->head);
+    while (tail != head && done < budget) {
+        slot = &ring->slots[tail & ring->mask];
+
+        PSAMPLE_CB_DBG_PRINT("%s: group 0x%x, trunc_size %d, src_ifdx 0x%x, dst_ifdx 0x%x, sample_rate %d\n",
+                __func__, slot->group->group_num,
+                slot->meta.trunc_size, slot->meta.src_ifindex,
+                slot->meta.dst_ifindex, slot->meta.sample_rate);
+
+        skb = psample_slot_skb(slot);
+        if (skb) {
+            bcmgenl_sample_packet(slot->group,
+                                  skb,
+                                  slot->meta.trunc_size,
+                                  slot->meta.src_ifindex,
+                                  slot->meta.dst_ifindex,
+                                  slot->meta.sample_rate);
+            g_psample_stats.pkts_f_psample_mod++;
+            consume_skb(skb);
+        } else {
+            g_psample_stats.pkts_d_no_mem++;
+        }
+        psample_hist_add(g_psample_hist.latency_us,
+                         div_u64(psample_now() - slot->stamp, NSEC_PER_USEC));
+        done++;
+
+        /* hand the slot back to the producer */
+        tail++;
+        smp_store_release(&ring->tail, tail);
+        if (tail == head) {
+            head = smp_load_acquire(&ring->head);
+        }
+    }
+
+    return done;
+}
+
+static bool
+psample_pending(void)
+{
+    psample_ring_t *ring;
+    int cpu;
+
+    if (!list_empty(&g_psample_work.pkt_list)) {
+        return true;
+    }
+    if (g_psample_rings) {
+        for_each_possible_cpu(cpu) {
+            ring = per_cpu_ptr(g_psample_rings, cpu);
+            if (READ_ONCE(ring->tail) != smp_load_acquire(&ring->head)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/*
+ * Deliver everything pending in batches of psample_budget pkts.
+ */
+static void
+psample_deliver(void)
+{
+    LIST_HEAD(batch);
+    unsigned long flags, drops;
     struct list_head *list_ptr, *list_next;
     psample_pkt_t *pkt;
+    int budget = psample_budget > 0 ? psample_budget : PSAMPLE_BUDGET_DFLT;
+    int cpu, done, total = 0;
+    bool more;
+    unsigned long start = jiffies;
+
+    /* take the whole pending list at once */
+    spin_lock_irqsave(&g_psample_work.lock, flags);
+    list_splice_init(&g_psample_work.pkt_list, &batch);
+    g_psample_stats.pkts_c_qlen_cur = 0;
+    spin_unlock_irqrestore(&g_psample_work.lock, flags);
 
-    spin_lock_irqsave(&psample_work->lock, flags);
-    list_for_each_safe(list_ptr, list_next, &psample_work->pkt_list) {
-        /* dequeue pkt from list */
+    done = 0;
+    list_for_each_safe(list_ptr, list_next, &batch) {
         pkt = list_entry(list_ptr, psample_pkt_t, list);
         list_del(list_ptr);
-        g_psample_stats.pkts_c_qlen_cur--;
-        spin_unlock_irqrestore(&psample_work->lock, flags);
-
-        /* send to psample */
-        if (pkt) {
-            PSAMPLE_CB_DBG_PRINT("%s: group 0x%x, trunc_size %d, src_ifdx 0x%x, dst_ifdx 0x%x, sample_rate %d\n",
-                    __func__, pkt->group->group_num,
-                    pkt->meta.trunc_size, pkt->meta.src_ifindex,
-                    pkt->meta.dst_ifindex, pkt->meta.sample_rate);
-
-            bcmgenl_sample_packet(pkt->group,
-                                  pkt->skb,
-                                  pkt->meta.trunc_size,
-                                  pkt->meta.src_ifindex,
-                                  pkt->meta.dst_ifindex,
-                                  pkt->meta.sample_rate);
 
-            g_psample_stats.pkts_f_psample_mod++;
+        PSAMPLE_CB_DBG_PRINT("%s: group 0x%x, trunc_size %d, src_ifdx 0x%x, dst_ifdx 0x%x, sample_rate %d\n",
+                __func__, pkt->group->group_num,
+                pkt->meta.trunc_size, pkt->meta.src_ifindex,
+                pkt->meta.dst_ifindex, pkt->meta.sample_rate);
+
+        bcmgenl_sample_packet(pkt->group,
+                              pkt->skb,
+                              pkt->meta.trunc_size,
+                              pkt->meta.src_ifindex,
+                              pkt->meta.dst_ifindex,
+                              pkt->meta.sample_rate);
+
+        g_psample_stats.pkts_f_psample_mod++;
+        psample_hist_add(g_psample_hist.latency_us,
+                         div_u64(psample_now() - pkt->stamp, NSEC_PER_USEC));
+
+        consume_skb(pkt->skb);
+        kfree(pkt);
 
-            dev_kfree_skb_any(pkt->skb);
-            kfree(pkt);
+        if (++done >= budget) {
+            total += done;
+            done = 0;
+            cond_resched();
         }
-        spin_lock_irqsave(&psample_work->lock, flags);
     }
-    spin_unlock_irqrestore(&psample_work->lock, flags);
+    total += done;
+
+    if (g_psample_rings) {
+        do {
+            more = false;
+            for_each_possible_cpu(cpu) {
+                done = psample_ring_drain(per_cpu_ptr(g_psample_rings, cpu),
+                                          budget);
+                total += done;
+                more |= (done == budget);
+            }
+            cond_resched();
+        } while (more && !kthread_should_stop());
+    }
+
+    drops = atomic_long_xchg(&g_psample_work.drops, 0);
+
+    spin_lock_irqsave(&g_psample_work.lock, flags);
+    /*
+     * Grow the queue if pkts were dropped although this batch started right
+     * after the previous one, i.e. the thread is keeping up with a burst.
+     */
+    if (drops && g_psample_work.qlen_limit < psample_qlen_max &&
+        time_before(start, g_psample_work.last_batch + HZ / 10)) {
+        WRITE_ONCE(g_psample_work.qlen_limit,
+                   min(g_psample_work.qlen_limit * 2, psample_qlen_max));
+        g_psample_work.last_grow = jiffies;
+    } else if (g_psample_work.qlen_limit > psample_qlen &&
+        list_empty(&g_psample_work.pkt_list) &&
+        time_after(jiffies, g_psample_work.last_grow + HZ)) {
+        /* give back queue depth after an idle second */
+        WRITE_ONCE(g_psample_work.qlen_limit,
+                   max(g_psample_work.qlen_limit / 2, psample_qlen));
+        g_psample_work.last_grow = jiffies;
+    }
+    g_psample_work.last_batch = jiffies;
+    spin_unlock_irqrestore(&g_psample_work.lock, flags);
+
+    psample_hist_add(g_psample_hist.batch_pkts, total);
+    psample_hist_add(g_psample_hist.batch_drops, drops);
+}
+
+static int
+psample_thread(void *data)
+{
+    while (!kthread_should_stop()) {
+        set_current_state(TASK_INTERRUPTIBLE);
+        if (!psample_pending()) {
+            schedule();
+            continue;
+        }
+        __set_current_state(TASK_RUNNING);
+        psample_deliver();
+    }
+    __set_current_state(TASK_RUNNING);
+
+    return 0;
+}
+
+/*
+ * Account a tail drop. Called from the filter callback on any CPU, so it
+ * must not take the queue lock; psample_deliver() picks the count up.
+ */
+static void
+psample_drop(void)
+{
+    atomic_long_inc(&g_psample_work.drops);
 }
 
 static int
@@ -400,16 +716,20 @@ psample_filter_cb(uint8_t *pkt, int size, int dev_no, void *pkt_meta,
     /* get psample group info. psample genetlink group ID passed in kf->dest_id */
     group = psample_group_get_from_list(kf->dest_id);
     if (!group) {
-        gprintk("%s: Could not find psample genetlink group %d\n", __func__, kf->cb_user_data);
         g_psample_stats.pkts_d_no_group++;
+        if (net_ratelimit()) {
+            gprintk("%s: Could not find psample genetlink group %d\n", __func__, kf->cb_user_data);
+        }
         goto PSAMPLE_FILTER_CB_PKT_HANDLED;
     }
 
     /* get psample metadata */
     rv = psample_meta_get(dev_no, kf, pkt_meta, &meta);
     if (rv < 0) {
-        gprintk("%s: Could not parse pkt metadata\n", __func__);
         g_psample_stats.pkts_d_metadata++;
+        if (net_ratelimit()) {
+            gprintk("%s: Could not parse pkt metadata\n", __func__);
+        }
         goto PSAMPLE_FILTER_CB_PKT_HANDLED;
     }
 
@@ -440,39 +760,96 @@ psample_filter_cb(uint8_t *pkt, int size, int dev_no, void *pkt_meta,
         unsigned long flags;
         psample_pkt_t *psample_pkt;
         struct sk_buff *skb;
+        psample_ring_t *ring;
+        psample_slot_t *slot;
+        unsigned int head, used;
+        int copy_size;
+
+        /* only the truncated part is forwarded, so only that is copied */
+        copy_size = size;
+        if (meta.trunc_size > 0 && meta.trunc_size < size) {
+            copy_size = meta.trunc_size;
+        }
+        if (strip_tag) {
+            g_psample_stats.pkts_f_tag_stripped++;
+        }
+
+        if (g_psample_rings && meta.trunc_size > 0 &&
+            copy_size <= psample_buf_size) {
+            local_irq_save(flags);
+            ring = this_cpu_ptr(g_psample_rings);
+            head = ring->head;
+            used = head - smp_load_acquire(&ring->tail);
+            if (used > ring->mask) {
+                local_irq_restore(flags);
+                g_psample_stats.pkts_d_ring_full++;
+                psample_drop();
+                if (net_ratelimit()) {
+                    gprintk("%s: tail drop due to full sample ring\n", __func__);
+                }
+                goto PSAMPLE_FILTER_CB_PKT_HANDLED;
+            }
+            slot = &ring->slots[head & ring->mask];
+            slot->group = group;
+            slot->meta = meta;
+            slot->stamp = psample_now();
+            slot->orig_size = size;
+            slot->len = copy_size;
+            psample_pkt_copy(slot->data, pkt, copy_size, strip_tag);
+            smp_store_release(&ring->head, head + 1);
+            local_irq_restore(flags);
+
+            g_psample_stats.pkts_f_ring++;
+            g_psample_stats.bytes_f_copied += copy_size;
+            if (used + 1 > g_psample_stats.pkts_c_qlen_hi) {
+                g_psample_stats.pkts_c_qlen_hi = used + 1;
+            }
+            psample_wakeup();
+            goto PSAMPLE_FILTER_CB_PKT_HANDLED;
+        }
 
-        if (g_psample_stats.pkts_c_qlen_cur >= psample_qlen) {
-            gprintk("%s: tail drop due to max qlen %d reached\n", __func__, psample_qlen);
+        if (g_psample_stats.pkts_c_qlen_cur >= READ_ONCE(g_psample_work.qlen_limit)) {
             g_psample_stats.pkts_d_qlen_max++;
+            psample_drop();
+            if (net_ratelimit()) {
+                gprintk("%s: tail drop due to max qlen %d reached\n", __func__,
+                        READ_ONCE(g_psample_work.qlen_limit));
+            }
             goto PSAMPLE_FILTER_CB_PKT_HANDLED;
         }
 
         if ((psample_pkt = kmalloc(sizeof(psample_pkt_t), GFP_ATOMIC)) == NULL) {
-            gprintk("%s: failed to alloc psample mem for pkt\n", __func__);
             g_psample_stats.pkts_d_no_mem++;
+            if (net_ratelimit()) {
+                gprintk("%s: failed to alloc psample mem for pkt\n", __func__);
+            }
             goto PSAMPLE_FILTER_CB_PKT_HANDLED;
         }
         memcpy(&psample_pkt->meta, &meta, sizeof(psample_meta_t));
         psample_pkt->group = group;
 
-        if ((skb = dev_alloc_skb(size)) == NULL) {
-            gprintk("%s: failed to alloc psample mem for pkt skb\n", __func__);
+        if ((skb = dev_alloc_skb(copy_size)) == NULL) {
             g_psample_stats.pkts_d_no_mem++;
             kfree(psample_pkt);
+            if (net_ratelimit()) {
+                gprintk("%s: failed to alloc psample mem for pkt skb\n", __func__);
+            }
             goto PSAMPLE_FILTER_CB_PKT_HANDLED;
         }
 
         /* setup skb to point to pkt */
-        if (strip_tag) {
-            memcpy(skb->data, pkt, 12);
-            memcpy(skb->data + 12, pkt + 16, size - 12);
-            g_psample_stats.pkts_f_tag_stripped++;
-        } else {
-            memcpy(skb->data, pkt, size);
+        psample_pkt_copy(skb->data, pkt, copy_size, strip_tag);
+        skb_put(skb, copy_size);
+        if (psample_skb_pad(skb, size - copy_size) < 0) {
+            g_psample_stats.pkts_d_no_mem++;
+            dev_kfree_skb_any(skb);
+            kfree(psample_pkt);
+            goto PSAMPLE_FILTER_CB_PKT_HANDLED;
         }
-        skb_put(skb, size);
-        skb->len = size;
         psample_pkt->skb = skb;
+        psample_pkt->stamp = psample_now();
+        g_psample_stats.pkts_f_alloc++;
+        g_psample_stats.bytes_f_copied += copy_size;
 
         spin_lock_irqsave(&g_psample_work.lock, flags);
         list_add_tail(&psample_pkt->list, &g_psample_work.pkt_list);
@@ -482,8 +859,8 @@ psample_filter_cb(uint8_t *pkt, int size, int dev_no, void *pkt_meta,
             g_psample_stats.pkts_c_qlen_hi = g_psample_stats.pkts_c_qlen_cur;
         }
 
-        schedule_work(&g_psample_work.wq);
         spin_unlock_irqrestore(&g_psample_work.lock, flags);
+        psample_wakeup();
     } else {
         g_psample_stats.pkts_d_sampling_disabled++;
     }
@@ -694,6 +1071,8 @@ psample_proc_debug_show(struct seq_file *m, void *v)
     seq_printf(m, "  debug:           0x%x\n", debug);
     seq_printf(m, "  netif_count:     %d\n",   bcmgenl_netif_num_get());
     seq_printf(m, "  queue length:    %d\n",   psample_qlen);
+    seq_printf(m, "  ring length:     %d\n",   g_psample_rings ? psample_ring_len : 0);
+    seq_printf(m, "  buffer size:     %d\n",   psample_buf_size);
 
     return 0;
 }
@@ -749,9 +1128,27 @@ struct proc_ops psample_proc_debug_file_ops = {
     .proc_release =    single_release,
 };
 
+static unsigned long
+psample_ring_qlen(void)
+{
+    psample_ring_t *ring;
+    unsigned long qlen = 0;
+    int cpu;
+
+    if (g_psample_rings) {
+        for_each_possible_cpu(cpu) {
+            ring = per_cpu_ptr(g_psample_rings, cpu);
+            qlen += READ_ONCE(ring->head) - READ_ONCE(ring->tail);
+        }
+    }
+    return qlen;
+}
+
 static int
 psample_proc_stats_show(struct seq_file *m, void *v)
 {
+    int idx;
+
     seq_printf(m, "BCM KNET %s Callback Stats\n", PSAMPLE_GENL_NAME);
     seq_printf(m, "  pkts filter psample cb         %10lu\n", g_psample_stats.pkts_f_psample_cb);
     seq_printf(m, "  pkts sent to psample module    %10lu\n", g_psample_stats.pkts_f_psample_mod);
@@ -761,10 +1158,15 @@ psample_proc_stats_show(struct seq_file *m, void *v)
     seq_printf(m, "  pkts with vlan tag stripped    %10lu\n", g_psample_stats.pkts_f_tag_stripped);
     seq_printf(m, "  pkts with mc destination       %10lu\n", g_psample_stats.pkts_f_dst_mc);
     seq_printf(m, "  pkts with cpu destination      %10lu\n", g_psample_stats.pkts_f_dst_cpu);
+    seq_printf(m, "  pkts queued in sample ring     %10lu\n", g_psample_stats.pkts_f_ring);
+    seq_printf(m, "  pkts queued with allocation    %10lu\n", g_psample_stats.pkts_f_alloc);
+    seq_printf(m, "  bytes copied for samples       %10lu\n", g_psample_stats.bytes_f_copied);
     seq_printf(m, "  pkts current queue length      %10lu\n", g_psample_stats.pkts_c_qlen_cur);
+    seq_printf(m, "  pkts current ring length       %10lu\n", psample_ring_qlen());
     seq_printf(m, "  pkts high queue length         %10lu\n", g_psample_stats.pkts_c_qlen_hi);
     seq_printf(m, "  pkts drop max queue length     %10lu\n", g_psample_stats.pkts_d_qlen_max);
     seq_printf(m, "  pkts drop no memory            %10lu\n", g_psample_stats.pkts_d_no_mem);
+    seq_printf(m, "  pkts drop sample ring full     %10lu\n", g_psample_stats.pkts_d_ring_full);
     seq_printf(m, "  pkts drop no psample group     %10lu\n", g_psample_stats.pkts_d_no_group);
     seq_printf(m, "  pkts drop sampling disabled    %10lu\n", g_psample_stats.pkts_d_sampling_disabled);
     seq_printf(m, "  pkts drop psample not ready    %10lu\n", g_psample_stats.pkts_d_not_ready);
@@ -773,6 +1175,14 @@ psample_proc_stats_show(struct seq_file *m, void *v)
     seq_printf(m, "  pkts with invalid dst port     %10lu\n", g_psample_stats.pkts_d_meta_dstport);
     seq_printf(m, "  pkts with invalid orig pkt sz  %10lu\n", g_psample_stats.pkts_d_invalid_size);
     seq_printf(m, "  pkts with psample only reason  %10lu\n", g_psample_stats.pkts_d_psample_only);
+    seq_printf(m, "  queue length limit             %10d\n", g_psample_work.qlen_limit);
+    seq_printf(m, "  %-8s %12s %12s %12s\n", "bucket", "latency(us)", "batch pkts", "batch drops");
+    for (idx = 0; idx < PSAMPLE_HIST_BUCKETS; idx++) {
+        seq_printf(m, "  <%-7lu %12lu %12lu %12lu\n", 1UL << idx,
+                   g_psample_hist.latency_us[idx],
+                   g_psample_hist.batch_pkts[idx],
+                   g_psample_hist.batch_drops[idx]);
+    }
     return 0;
 }
 
@@ -799,6 +1209,7 @@ psample_proc_stats_write(struct file *file, const char *buf,
     qlen_cur = g_psample_stats.pkts_c_qlen_cur;
     memset(&g_psample_stats, 0, sizeof(psample_stats_t));
     g_psample_stats.pkts_c_qlen_cur = qlen_cur;
+    memset(&g_psample_hist, 0, sizeof(psample_hist_t));
     spin_unlock_irqrestore(&g_psample_work.lock, flags);
 
     return count;
@@ -872,13 +1283,70 @@ psample_proc_cleanup(void)
     return 0;
 }
 
+static void
+psample_ring_free(void)
+{
+    psample_ring_t *ring;
+    int cpu;
+
+    if (!g_psample_rings) {
+        return;
+    }
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(g_psample_rings, cpu);
+        vfree(ring->slots);
+        vfree(ring->bufs);
+    }
+    free_percpu(g_psample_rings);
+    g_psample_rings = NULL;
+}
+
+static int
+psample_ring_alloc(void)
+{
+    psample_ring_t *ring;
+    unsigned int len, idx;
+    int cpu;
+
+    if (psample_ring_len <= 0 || psample_buf_size <= 0) {
+        return 0;
+    }
+    len = roundup_pow_of_two(psample_ring_len);
+
+    g_psample_rings = alloc_percpu(psample_ring_t);
+    if (!g_psample_rings) {
+        return -1;
+    }
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(g_psample_rings, cpu);
+        ring->head = 0;
+        ring->tail = 0;
+        ring->mask = len - 1;
+        ring->slots = vzalloc(len * sizeof(psample_slot_t));
+        ring->bufs = vzalloc(len * psample_buf_size);
+        if (!ring->slots || !ring->bufs) {
+            psample_ring_free();
+            return -1;
+        }
+        for (idx = 0; idx < len; idx++) {
+            ring->slots[idx].data = ring->bufs + idx * psample_buf_size;
+        }
+    }
+
+    return 0;
+}
+
 static int
 psample_cleanup(void)
 {
     psample_pkt_t *pkt;
     psample_group_data_t *grp;
 
-    cancel_work_sync(&g_psample_work.wq);
+    if (g_psample_work.task) {
+        kthread_stop(g_psample_work.task);
+        g_psample_work.task = NULL;
+    }
+    psample_ring_free();
 
     while (!list_empty(&g_psample_work.pkt_list)) {
         pkt = list_entry(g_psample_work.pkt_list.next, psample_pkt_t, list);
@@ -912,13 +1380,35 @@ psample_init(void)
     /* setup psample work queue */
     spin_lock_init(&g_psample_work.lock);
     INIT_LIST_HEAD(&g_psample_work.pkt_list);
-    INIT_WORK(&g_psample_work.wq, psample_task);
+    g_psample_work.qlen_limit = psample_qlen;
+    if (psample_qlen_max < psample_qlen) {
+        psample_qlen_max = psample_qlen;
+    }
+
+    /* setup preallocated sample buffers, fall back to allocating per pkt */
+    if (psample_ring_alloc() < 0) {
+        gprintk("%s: failed to alloc psample sample rings\n", __func__);
+    }
+
+    /* start the delivery thread */
+    g_psample_work.task = kthread_create(psample_thread, NULL, "bcmgenl_psample");
+    if (IS_ERR(g_psample_work.task)) {
+        gprintk("%s: failed to create psample thread\n", __func__);
+        g_psample_work.task = NULL;
+        psample_cleanup();
+        return -1;
+    }
+    if (psample_cpu >= 0 && psample_cpu < nr_cpu_ids && cpu_online(psample_cpu)) {
+        kthread_bind(g_psample_work.task, psample_cpu);
+    }
+    wake_up_process(g_psample_work.task);
 
     /* get net namespace */
     g_psample_info.netns = get_net_ns_by_pid(current->pid);
     if (!g_psample_info.netns) {
         gprintk("%s: Could not get network namespace for pid %d\n",
                 __func__, current->pid);
+        psample_cleanup();
         return -1;
     }
     PSAMPLE_CB_DBG_PRINT("%s: current->pid %d, netns 0x%p, sample_size %d\n",
@@ -930,19 +1420,28 @@ psample_init(void)
 
 int bcmgenl_psample_cleanup(void)
 {
+    /* stop the callback before its buffers go away */
+    bkn_filter_cb_unregister(psample_filter_cb);
     psample_cleanup();
     psample_proc_cleanup();
-    bkn_filter_cb_unregister(psample_filter_cb);
     return 0;
 }
 
 int
 bcmgenl_psample_init(char *procfs_path)
 {
-    bkn_filter_cb_register_by_name(psample_filter_cb, PSAMPLE_GENL_NAME);
+    int rv;
+
     bcmgenl_netif_default_sample_set(PSAMPLE_RATE_DFLT, PSAMPLE_SIZE_DFLT);
     psample_proc_init(procfs_path);
-    return psample_init();
+    rv = psample_init();
+    if (rv < 0) {
+        psample_proc_cleanup();
+        return rv;
+    }
+    /* register the callback once the queues it feeds are set up */
+    bkn_filter_cb_register_by_name(psample_filter_cb, PSAMPLE_GENL_NAME);
+    return 0;
 }
 
 #else
@@ -222,12 +222,20 @@ _cleanup(void)
 static int
 _init(void)
 {
+    int rv;
+
     bcmgenl_proc_init();
 
     bcmgenl_dev_init();
     bcmgenl_netif_init();
 
-    bcmgenl_psample_init(BCMGENL_PROCFS_PATH);
+    rv = bcmgenl_psample_init(BCMGENL_PROCFS_PATH);
+    if (rv < 0) {
+        bcmgenl_netif_cleanup();
+        bcmgenl_dev_cleanup();
+        bcmgenl_proc_cleanup();
+        return rv;
+    }
 #ifdef BUILD_GENL_PACKET
     bcmgenl_packet_init(BCMGENL_PROCFS_PATH);
 #endif
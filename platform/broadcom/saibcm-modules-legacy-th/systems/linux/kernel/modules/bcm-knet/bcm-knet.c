@@ -80,6 +80,12 @@
 #include <linux/seq_file.h>
 #include <linux/if_vlan.h>
 #include <linux/nsproxy.h>
+#include <linux/jhash.h>
+#include <linux/vmalloc.h>
+#include <linux/mutex.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,11,0)
+#include <linux/sched/clock.h>
+#endif
 
 
 MODULE_AUTHOR("Broadcom Corporation");
@@ -111,6 +117,21 @@ LKM_MOD_PARAM(rx_sync_retry, "i", int, 0);
 MODULE_PARM_DESC(rx_sync_retry,
 "Retries if chain is incomplete on interrupt (default 10)");
 
+static int rx_filter_compile = 1;
+LKM_MOD_PARAM(rx_filter_compile, "i", int, 0);
+MODULE_PARM_DESC(rx_filter_compile,
+"Classify Rx packets with the compiled filter table instead of a list walk (default 1)");
+
+static int tx_queues = 0;
+LKM_MOD_PARAM(tx_queues, "i", int, 0);
+MODULE_PARM_DESC(tx_queues,
+"Number of Tx queues per KNET network interface (default 0 for one per CPU)");
+
+static int rx_telemetry = 1;
+LKM_MOD_PARAM(rx_telemetry, "i", int, 0);
+MODULE_PARM_DESC(rx_telemetry,
+"Collect per filter Rx latency and drop statistics (default 1)");
+
 static char *base_dev_name = NULL;
 LKM_MOD_PARAM(base_dev_name, "s", charp, 0);
 MODULE_PARM_DESC(base_dev_name,
@@ -319,6 +340,13 @@ static int napi_weight = 0;
 #define DMA_BIT_MASK(n) (((n) == 64) ? ~0ULL : ((1ULL<<(n))-1))
 #endif
 
+#if (LINUX_VERSION_CODE < KERNEL_VERSION(2,6,27))
+#define alloc_etherdev_mq(_size, _txqs) alloc_etherdev(_size)
+#define netif_tx_start_all_queues(_dev) netif_start_queue(_dev)
+#define netif_tx_stop_all_queues(_dev) netif_stop_queue(_dev)
+#define netif_tx_wake_all_queues(_dev) netif_wake_queue(_dev)
+#endif
+
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(4,7,0))
 #define NETDEV_UPDATE_TRANS_START_TIME(dev) dev->trans_start = jiffies
 #else
@@ -626,6 +654,9 @@ typedef struct bkn_dcb_chain_s {
 } bkn_dcb_chain_t;
 
 #define MAX_TX_DCBS 64
+#define MAX_TX_QUEUES 16
+/* Largest DCB built on the stack in bkn_tx */
+#define TX_DCB_WSIZE_MAX 32
 #define MAX_RX_DCBS 64
 
 #define NUM_DMA_CHAN 16
@@ -648,6 +679,10 @@ typedef struct bkn_switch_info_s {
     struct net_device **ndevs;  /* Indexed array of ndev_list */
     int ndev_max;               /* Size of indexed array */
     struct list_head rxpf_list; /* Associated Rx packet filters */
+    struct bkn_rxpf_cls_s *rxpf_cls; /* rxpf_list compiled for classification */
+    unsigned long rxpf_check_pkts;      /* Classifier self-check: packets replayed */
+    unsigned long rxpf_check_matched;   /* Packets both matchers sent to a filter */
+    unsigned long rxpf_check_mismatch;  /* Packets the matchers disagreed on */
     volatile void *base_addr;   /* Base address for PCI register access */
     struct BKN_DMA_DEV *dma_dev;    /* Required for DMA memory control */
     struct pci_dev *pdev;       /* Required for DMA memory control */
@@ -718,6 +753,8 @@ typedef struct bkn_switch_info_s {
         int dirty;              /* Index of next Tx DCB to complete */
         int api_active;         /* BCM Tx API is in progress */
         int suspends;           /* Calls to netif_stop_queue (debug only) */
+        int stopped;            /* Netif Tx queues are stopped */
+        int reserved;           /* Tx DCBs reserved by unlocked bkn_tx */
         struct list_head api_dcb_list; /* Tx DCB chains from BCM Tx API */
         bkn_dcb_chain_t *api_dcb_chain; /* Current Tx DCB chain */
         bkn_dcb_chain_t *api_dcb_chain_end; /* Tx DCB chain end */
@@ -1079,14 +1116,87 @@ typedef struct bkn_priv_s {
     int ref_count;
 } bkn_priv_t;
 
+/*
+ * Rx telemetry.
+ * Every filter owns a set of per CPU counters, so the Rx path can update
+ * them without atomics or cache line bouncing. Latency is the time from
+ * picking up a completed DCB until the packet is handed to its destination,
+ * kept as a log2 histogram starting at 256 ns. Drops are counted by cause.
+ */
+#define BKN_RXT_LAT_BUCKETS     16
+#define BKN_RXT_LAT_SHIFT       8
+
+#define BKN_RXT_DROP_PKT_ERR    0   /* Fragment or DCB error */
+#define BKN_RXT_DROP_NO_LINK    1   /* Software link down */
+#define BKN_RXT_DROP_NO_SKB     2   /* skb allocation failed */
+#define BKN_RXT_DROP_CALLBACK   3   /* Consumed by call-back */
+#define BKN_RXT_DROP_UNKN_NETIF 4   /* Unknown net interface ID */
+#define BKN_RXT_DROP_UNKN_DEST  5   /* Unknown destination type */
+#define BKN_RXT_DROP_MAX        6
+
+static char *bkn_rxt_drop_names[BKN_RXT_DROP_MAX] = {
+    "pkt_err", "no_link", "no_skb", "callback", "unkn_netif", "unkn_dest"
+};
+
+typedef struct bkn_rxt_stats_s {
+    uint64_t lat[BKN_RXT_LAT_BUCKETS];
+    uint64_t drops[BKN_RXT_DROP_MAX];
+} bkn_rxt_stats_t;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,37)
+#define bkn_rxt_clock()         local_clock()
+#else
+#define bkn_rxt_clock()         sched_clock()
+#endif
+
 typedef struct bkn_filter_s {
     struct list_head list;
     int dev_no;
     unsigned long hits;
     kcom_filter_t kf;
     knet_filter_cb_f cb;
+    bkn_rxt_stats_t *rxt;       /* Per CPU Rx telemetry */
 } bkn_filter_t;
 
+/*
+ * Compiled Rx filter classifier.
+ * Filters with the same match layout (OOB/packet data offsets, sizes and mask)
+ * form a shape. The filters of a shape are hashed on their match data, so a
+ * packet costs one key extraction and one bucket walk per shape instead of a
+ * copy and compare per filter. Entries remember the position of their filter
+ * in rxpf_list and candidates are resolved in that order, so the first match
+ * still wins exactly as in the list walk.
+ */
+#define BKN_RXPF_BUCKETS_MAX    64
+
+typedef struct bkn_rxpf_entry_s {
+    struct bkn_rxpf_entry_s *next;  /* Next entry in bucket, ascending rank */
+    int rank;                   /* Position of filter in rxpf_list */
+    int shape;
+    uint32_t hash;
+    bkn_filter_t *filter;
+} bkn_rxpf_entry_t;
+
+typedef struct bkn_rxpf_shape_s {
+    int oob_data_offset;
+    int oob_data_size;
+    int pkt_data_offset;
+    int pkt_data_size;
+    int wsize;
+    uint32_t *mask;             /* Mask of the first filter, shared by all */
+    int nfilters;
+    uint32_t hmask;             /* Number of buckets - 1 */
+    bkn_rxpf_entry_t **bucket;
+} bkn_rxpf_shape_t;
+
+typedef struct bkn_rxpf_cls_s {
+    int nshapes;
+    int nentries;
+    bkn_rxpf_shape_t *shapes;
+    bkn_rxpf_entry_t *entries;
+    bkn_rxpf_entry_t **buckets;
+} bkn_rxpf_cls_t;
+
 
 /*
  * Multiple instance support in KNET
@@ -3073,9 +3183,289 @@ device_is_sand(bkn_switch_info_t *sinfo)
     return (is_dpp | is_dnx);
 }
 
+/* Check the Rx channel a filter is bound to through its priority */
+static inline int
+bkn_filter_chan_match(bkn_switch_info_t *sinfo, kcom_filter_t *kf, int chan)
+{
+    if (device_is_dnx(sinfo))
+    {
+        /*
+         * Mutliple RX channels are enabled on JR2 and above devices
+         * Bind between priority 0 and RX channel 0 is not checked, then all enabled RX channels can receive packets.
+         */
+        if (kf->priority && (kf->priority < (num_rx_prio * sinfo->rx_chans))) {
+            if (kf->priority < (num_rx_prio * chan) ||
+                kf->priority >= (num_rx_prio * (chan + 1))) {
+                return 0;
+            }
+        }
+    }
+    else {
+        if (kf->priority < (num_rx_prio * sinfo->rx_chans)) {
+            if (kf->priority < (num_rx_prio * chan) ||
+                kf->priority >= (num_rx_prio * (chan + 1))) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static void
+bkn_rxpf_cls_free(bkn_rxpf_cls_t *cls)
+{
+    if (cls == NULL) {
+        return;
+    }
+    kfree(cls->buckets);
+    kfree(cls->entries);
+    kfree(cls->shapes);
+    kfree(cls);
+}
+
+static int
+bkn_rxpf_same_shape(bkn_rxpf_shape_t *shape, kcom_filter_t *kf)
+{
+    if (shape->oob_data_offset != kf->oob_data_offset ||
+        shape->oob_data_size != kf->oob_data_size ||
+        shape->pkt_data_offset != kf->pkt_data_offset ||
+        shape->pkt_data_size != kf->pkt_data_size) {
+        return 0;
+    }
+    return memcmp(shape->mask, kf->mask.w, shape->wsize * sizeof(uint32_t)) == 0;
+}
+
+/*
+ * Compile rxpf_list. Called with sinfo->lock held, since the result points
+ * into the filters on the list. Returns NULL if the list is empty or memory
+ * is short, the Rx path then walks the list.
+ */
+static bkn_rxpf_cls_t *
+bkn_rxpf_cls_build(bkn_switch_info_t *sinfo)
+{
+    struct list_head *list;
+    bkn_filter_t *filter;
+    bkn_rxpf_cls_t *cls;
+    bkn_rxpf_shape_t *shape;
+    bkn_rxpf_entry_t *entry;
+    int idx, sdx, nfilters, nbuckets;
+
+    nfilters = 0;
+    list_for_each(list, &sinfo->rxpf_list) {
+        nfilters++;
+    }
+    if (nfilters == 0) {
+        return NULL;
+    }
+
+    cls = kzalloc(sizeof(*cls), GFP_ATOMIC);
+    if (cls == NULL) {
+        return NULL;
+    }
+    cls->entries = kcalloc(nfilters, sizeof(*cls->entries), GFP_ATOMIC);
+    cls->shapes = kcalloc(nfilters, sizeof(*cls->shapes), GFP_ATOMIC);
+    if (cls->entries == NULL || cls->shapes == NULL) {
+        bkn_rxpf_cls_free(cls);
+        return NULL;
+    }
+
+    /* Group the filters into shapes, in list order */
+    idx = 0;
+    list_for_each(list, &sinfo->rxpf_list) {
+        filter = (bkn_filter_t *)list;
+        for (sdx = 0; sdx < cls->nshapes; sdx++) {
+            if (bkn_rxpf_same_shape(&cls->shapes[sdx], &filter->kf)) {
+                break;
+            }
+        }
+        shape = &cls->shapes[sdx];
+        if (sdx == cls->nshapes) {
+            shape->oob_data_offset = filter->kf.oob_data_offset;
+            shape->oob_data_size = filter->kf.oob_data_size;
+            shape->pkt_data_offset = filter->kf.pkt_data_offset;
+            shape->pkt_data_size = filter->kf.pkt_data_size;
+            shape->wsize = BYTES2WORDS(shape->oob_data_size + shape->pkt_data_size);
+            shape->mask = filter->kf.mask.w;
+            cls->nshapes++;
+        }
+        shape->nfilters++;
+        entry = &cls->entries[idx];
+        entry->rank = idx;
+        entry->shape = sdx;
+        entry->filter = filter;
+        entry->hash = jhash2(filter->kf.data.w, shape->wsize, 0);
+        idx++;
+    }
+    cls->nentries = idx;
+
+    /* Size the hash of every shape to its number of filters */
+    nbuckets = 0;
+    for (sdx = 0; sdx < cls->nshapes; sdx++) {
+        shape = &cls->shapes[sdx];
+        shape->hmask = 1;
+        while (shape->hmask < shape->nfilters &&
+               shape->hmask < BKN_RXPF_BUCKETS_MAX) {
+            shape->hmask <<= 1;
+        }
+        nbuckets += shape->hmask;
+        shape->hmask--;
+    }
+    cls->buckets = kcalloc(nbuckets, sizeof(*cls->buckets), GFP_ATOMIC);
+    if (cls->buckets == NULL) {
+        bkn_rxpf_cls_free(cls);
+        return NULL;
+    }
+    nbuckets = 0;
+    for (sdx = 0; sdx < cls->nshapes; sdx++) {
+        shape = &cls->shapes[sdx];
+        shape->bucket = &cls->buckets[nbuckets];
+        nbuckets += shape->hmask + 1;
+    }
+
+    /* Push in reverse list order so every bucket ends up in ascending rank */
+    for (idx = cls->nentries - 1; idx >= 0; idx--) {
+        entry = &cls->entries[idx];
+        shape = &cls->shapes[entry->shape];
+        entry->next = shape->bucket[entry->hash & shape->hmask];
+        shape->bucket[entry->hash & shape->hmask] = entry;
+    }
+
+    DBG_VERB(("Compiled %d Rx filters into %d shapes.\n",
+              cls->nentries, cls->nshapes));
+    return cls;
+}
+
+/*
+ * Recompile after rxpf_list changed. Called with sinfo->lock held; the
+ * returned previous table must be freed with bkn_rxpf_cls_free() once the
+ * lock is dropped.
+ */
+static bkn_rxpf_cls_t *
+bkn_rxpf_cls_update(bkn_switch_info_t *sinfo)
+{
+    bkn_rxpf_cls_t *old = sinfo->rxpf_cls;
+
+    sinfo->rxpf_cls = rx_filter_compile ? bkn_rxpf_cls_build(sinfo) : NULL;
+    if (rx_filter_compile && sinfo->rxpf_cls == NULL &&
+        !list_empty(&sinfo->rxpf_list)) {
+        DBG_WARN(("Rx filter compile failed, using list walk.\n"));
+    }
+    return old;
+}
+
+/*
+ * Masked match key of a shape, straight from the OOB and packet data. The
+ * words are laid out as the filter data: OOB bytes followed by packet bytes.
+ */
+static inline void
+bkn_rxpf_key(bkn_rxpf_shape_t *shape, uint8_t *oob, uint8_t *pkt, uint32_t *key)
+{
+    int idx, bdx, off, size;
+    union {
+        uint32_t w;
+        uint8_t b[4];
+    } u;
+
+    size = shape->oob_data_size + shape->pkt_data_size;
+    for (idx = 0; idx < shape->wsize; idx++) {
+        if (shape->mask[idx] == 0) {
+            key[idx] = 0;
+            continue;
+        }
+        off = idx * 4;
+        if (off + 4 <= shape->oob_data_size) {
+            memcpy(&u.w, &oob[shape->oob_data_offset + off], 4);
+        } else if (off >= shape->oob_data_size && off + 4 <= size) {
+            memcpy(&u.w, &pkt[shape->pkt_data_offset + off - shape->oob_data_size], 4);
+        } else {
+            /* Word straddles OOB and packet data, or the end of the data */
+            u.w = 0;
+            for (bdx = 0; bdx < 4 && off + bdx < size; bdx++) {
+                if (off + bdx < shape->oob_data_size) {
+                    u.b[bdx] = oob[shape->oob_data_offset + off + bdx];
+                } else {
+                    u.b[bdx] = pkt[shape->pkt_data_offset + off + bdx -
+                                   shape->oob_data_size];
+                }
+            }
+        }
+        key[idx] = u.w & shape->mask[idx];
+    }
+}
+
 static bkn_filter_t *
-bkn_match_rx_pkt(bkn_switch_info_t *sinfo, uint8_t *pkt, int pktlen,
-                 void *meta, int chan, bkn_filter_t *cbf)
+bkn_rxpf_cls_match(bkn_switch_info_t *sinfo, bkn_rxpf_cls_t *cls,
+                   uint8_t *pkt, int pktlen, void *meta, int chan,
+                   bkn_filter_t *cbf)
+{
+    uint32_t key[KCOM_FILTER_WORDS_MAX];
+    bkn_rxpf_shape_t *shape;
+    bkn_rxpf_entry_t *entry, *best;
+    bkn_filter_t *filter;
+    kcom_filter_t *kf;
+    knet_filter_cb_f filter_cb;
+    uint32_t hash;
+    int sdx, after;
+
+    after = -1;
+    while (1) {
+        /* Lowest ranked filter after 'after' that matches */
+        best = NULL;
+        for (sdx = 0; sdx < cls->nshapes; sdx++) {
+            shape = &cls->shapes[sdx];
+            if (shape->pkt_data_offset + shape->pkt_data_size > pktlen) {
+                continue;
+            }
+            bkn_rxpf_key(shape, (uint8_t *)meta, pkt, key);
+            hash = jhash2(key, shape->wsize, 0);
+            for (entry = shape->bucket[hash & shape->hmask]; entry;
+                 entry = entry->next) {
+                if (best && entry->rank >= best->rank) {
+                    break;
+                }
+                if (entry->rank <= after || entry->hash != hash) {
+                    continue;
+                }
+                kf = &entry->filter->kf;
+                if (memcmp(kf->data.w, key, shape->wsize * sizeof(uint32_t)) ||
+                    !bkn_filter_chan_match(sinfo, kf, chan)) {
+                    continue;
+                }
+                best = entry;
+                break;
+            }
+        }
+        if (best == NULL) {
+            return NULL;
+        }
+
+        filter = best->filter;
+        kf = &filter->kf;
+        if (kf->dest_type != KCOM_DEST_T_CB) {
+            filter->hits++;
+            return filter;
+        }
+        /* Check for custom filters */
+        filter_cb = filter->cb ? filter->cb : knet_filter_cb;
+        if (filter_cb != NULL && cbf != NULL) {
+            memset(cbf, 0, sizeof(*cbf));
+            memcpy(&cbf->kf, kf, sizeof(cbf->kf));
+            cbf->rxt = filter->rxt;
+            if (filter_cb(pkt, pktlen, sinfo->dev_no,
+                          meta, chan, &cbf->kf)) {
+                filter->hits++;
+                return cbf;
+            }
+        } else {
+            DBG_FLTR(("Match, but not filter callback\n"));
+        }
+        after = best->rank;
+    }
+}
+
+static bkn_filter_t *
+bkn_rxpf_list_match(bkn_switch_info_t *sinfo, uint8_t *pkt, int pktlen,
+                    void *meta, int chan, bkn_filter_t *cbf)
 {
     struct list_head *list;
     bkn_filter_t *filter;
@@ -3113,30 +3503,7 @@ bkn_match_rx_pkt(bkn_switch_info_t *sinfo, uint8_t *pkt, int pktlen,
             }
         }
 
-        match = 1;
-        if (match) {
-            if (device_is_dnx(sinfo))
-            {
-                /*
-                 * Mutliple RX channels are enabled on JR2 and above devices
-                 * Bind between priority 0 and RX channel 0 is not checked, then all enabled RX channels can receive packets.
-                 */
-                if (kf->priority && (kf->priority < (num_rx_prio * sinfo->rx_chans))) {
-                    if (kf->priority < (num_rx_prio * chan) ||
-                        kf->priority >= (num_rx_prio * (chan + 1))) {
-                        match = 0;
-                    }
-                }
-            }
-            else {
-                if (kf->priority < (num_rx_prio * sinfo->rx_chans)) {
-                    if (kf->priority < (num_rx_prio * chan) ||
-                        kf->priority >= (num_rx_prio * (chan + 1))) {
-                        match = 0;
-                    }
-                }
-            }
-        }
+        match = bkn_filter_chan_match(sinfo, kf, chan);
         if (match) {
             for (idx = 0; idx < wsize; idx++) {
                 scratch.data.w[idx] &= kf->mask.w[idx];
@@ -3153,6 +3520,7 @@ bkn_match_rx_pkt(bkn_switch_info_t *sinfo, uint8_t *pkt, int pktlen,
                 if (filter_cb != NULL && cbf != NULL) {
                     memset(cbf, 0, sizeof(*cbf));
                     memcpy(&cbf->kf, kf, sizeof(cbf->kf));
+                    cbf->rxt = filter->rxt;
                     if (filter_cb(pkt, pktlen, sinfo->dev_no,
                                   meta, chan, &cbf->kf)) {
                         filter->hits++;
@@ -3171,6 +3539,249 @@ bkn_match_rx_pkt(bkn_switch_info_t *sinfo, uint8_t *pkt, int pktlen,
     return NULL;
 }
 
+static bkn_filter_t *
+bkn_match_rx_pkt(bkn_switch_info_t *sinfo, uint8_t *pkt, int pktlen,
+                 void *meta, int chan, bkn_filter_t *cbf)
+{
+    /* The list walk is kept for the per filter debug output */
+    if (sinfo->rxpf_cls && !(debug & (DBG_LVL_VERB | DBG_LVL_DUNE))) {
+        return bkn_rxpf_cls_match(sinfo, sinfo->rxpf_cls, pkt, pktlen,
+                                  meta, chan, cbf);
+    }
+    return bkn_rxpf_list_match(sinfo, pkt, pktlen, meta, chan, cbf);
+}
+
+/*
+ * Rx filter classifier self-check.
+ * Generated packets are replayed through both the compiled classifier and
+ * the list walk, and every packet on which they pick a different filter is
+ * counted and logged. Each round fills the match data of all filters with
+ * random bytes, then plants the data of every filter under its mask, once
+ * as is and once with a masked bit flipped. Callbacks of callback filters
+ * are not invoked and filter hit counters are left untouched.
+ */
+#define BKN_RXPF_CHECK_ROUNDS_MAX   10000
+#define BKN_RXPF_CHECK_BUF_SIZE     (0x10000 + KCOM_FILTER_BYTES_MAX)
+#define BKN_RXPF_CHECK_LOG_MAX      8
+
+static inline uint32_t
+bkn_rxpf_check_rand(uint32_t *seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+static inline uint8_t *
+bkn_rxpf_check_byte(kcom_filter_t *kf, uint8_t *oob, uint8_t *pkt, int idx)
+{
+    if (idx < kf->oob_data_size) {
+        return &oob[kf->oob_data_offset + idx];
+    }
+    return &pkt[kf->pkt_data_offset + idx - kf->oob_data_size];
+}
+
+static void
+bkn_rxpf_check_pkt(bkn_switch_info_t *sinfo, bkn_rxpf_cls_t *cls,
+                   uint8_t *pkt, int pktlen, uint8_t *oob, int chan)
+{
+    bkn_filter_t *cls_hit, *list_hit;
+
+    /* Without a callback buffer neither matcher runs filter callbacks */
+    cls_hit = bkn_rxpf_cls_match(sinfo, cls, pkt, pktlen, oob, chan, NULL);
+    if (cls_hit) {
+        cls_hit->hits--;
+    }
+    list_hit = bkn_rxpf_list_match(sinfo, pkt, pktlen, oob, chan, NULL);
+    if (list_hit) {
+        list_hit->hits--;
+    }
+
+    sinfo->rxpf_check_pkts++;
+    if (cls_hit != list_hit) {
+        if (sinfo->rxpf_check_mismatch++ < BKN_RXPF_CHECK_LOG_MAX) {
+            gprintk("Rx filter check: classifier hit filter %d, list walk "
+                    "hit filter %d (chan %d, pktlen %d)\n",
+                    cls_hit ? cls_hit->kf.id : 0,
+                    list_hit ? list_hit->kf.id : 0, chan, pktlen);
+        }
+    } else if (cls_hit) {
+        sinfo->rxpf_check_matched++;
+    }
+}
+
+static int
+bkn_rxpf_check(bkn_switch_info_t *sinfo, int rounds, uint32_t seed)
+{
+    struct list_head *list;
+    kcom_filter_t *kf;
+    bkn_rxpf_cls_t *cls, *own;
+    uint8_t *buf, *oob, *pkt, *byte;
+    uint8_t save[KCOM_FILTER_BYTES_MAX];
+    unsigned long flags;
+    int round, idx, size, pktlen, pktlen_max, chan, bit;
+
+    buf = vzalloc(2 * BKN_RXPF_CHECK_BUF_SIZE);
+    if (buf == NULL) {
+        return -ENOMEM;
+    }
+    oob = buf;
+    pkt = buf + BKN_RXPF_CHECK_BUF_SIZE;
+    if (seed == 0) {
+        seed = 0x9e3779b9;
+    }
+
+    spin_lock_irqsave(&sinfo->lock, flags);
+    sinfo->rxpf_check_pkts = 0;
+    sinfo->rxpf_check_matched = 0;
+    sinfo->rxpf_check_mismatch = 0;
+    spin_unlock_irqrestore(&sinfo->lock, flags);
+
+    for (round = 0; round < rounds; round++) {
+        /* The table points into the filters, so it is only used locked */
+        spin_lock_irqsave(&sinfo->lock, flags);
+        own = NULL;
+        cls = sinfo->rxpf_cls;
+        if (cls == NULL) {
+            own = cls = bkn_rxpf_cls_build(sinfo);
+        }
+        if (cls == NULL) {
+            spin_unlock_irqrestore(&sinfo->lock, flags);
+            break;
+        }
+
+        pktlen_max = 0;
+        list_for_each(list, &sinfo->rxpf_list) {
+            kf = &((bkn_filter_t *)list)->kf;
+            size = kf->oob_data_size + kf->pkt_data_size;
+            for (idx = 0; idx < size; idx++) {
+                byte = bkn_rxpf_check_byte(kf, oob, pkt, idx);
+                *byte = bkn_rxpf_check_rand(&seed);
+            }
+            pktlen_max = max_t(int, pktlen_max,
+                               kf->pkt_data_offset + kf->pkt_data_size);
+        }
+        chan = sinfo->rx_chans ? bkn_rxpf_check_rand(&seed) % sinfo->rx_chans : 0;
+        bkn_rxpf_check_pkt(sinfo, cls, pkt, pktlen_max, oob, chan);
+
+        list_for_each(list, &sinfo->rxpf_list) {
+            kf = &((bkn_filter_t *)list)->kf;
+            size = kf->oob_data_size + kf->pkt_data_size;
+            for (idx = 0; idx < size; idx++) {
+                byte = bkn_rxpf_check_byte(kf, oob, pkt, idx);
+                save[idx] = *byte;
+                *byte = (*byte & ~kf->mask.b[idx]) |
+                        (kf->data.b[idx] & kf->mask.b[idx]);
+            }
+            pktlen = kf->pkt_data_offset + kf->pkt_data_size +
+                     (bkn_rxpf_check_rand(&seed) & 0x3f);
+            chan = sinfo->rx_chans ? bkn_rxpf_check_rand(&seed) % sinfo->rx_chans : 0;
+            bkn_rxpf_check_pkt(sinfo, cls, pkt, pktlen, oob, chan);
+
+            /* Near miss, flip one masked bit */
+            for (idx = 0; idx < size; idx++) {
+                if (kf->mask.b[idx]) {
+                    bit = ffs(kf->mask.b[idx]) - 1;
+                    byte = bkn_rxpf_check_byte(kf, oob, pkt, idx);
+                    *byte ^= 1 << bit;
+                    bkn_rxpf_check_pkt(sinfo, cls, pkt, pktlen, oob, chan);
+                    break;
+                }
+            }
+
+            for (idx = 0; idx < size; idx++) {
+                byte = bkn_rxpf_check_byte(kf, oob, pkt, idx);
+                *byte = save[idx];
+            }
+        }
+        spin_unlock_irqrestore(&sinfo->lock, flags);
+
+        bkn_rxpf_cls_free(own);
+        cond_resched();
+    }
+
+    vfree(buf);
+
+    gprintk("Rx filter check: %d rounds, %lu packets, %lu matched, "
+            "%lu mismatches\n", round, sinfo->rxpf_check_pkts,
+            sinfo->rxpf_check_matched, sinfo->rxpf_check_mismatch);
+
+    return 0;
+}
+
+/*
+ * Rx telemetry updates. The Rx path runs with the device lock held, so the
+ * local CPU counters can be updated without further protection.
+ */
+static inline uint64_t
+bkn_rxt_start(void)
+{
+    return rx_telemetry ? bkn_rxt_clock() : 0;
+}
+
+static inline void
+bkn_rxt_done(bkn_filter_t *filter, uint64_t t0)
+{
+    bkn_rxt_stats_t *rxt;
+    uint64_t ns;
+    int bkt;
+
+    if (!t0 || filter == NULL || filter->rxt == NULL) {
+        return;
+    }
+    ns = bkn_rxt_clock() - t0;
+    bkt = fls64(ns >> BKN_RXT_LAT_SHIFT);
+    if (bkt >= BKN_RXT_LAT_BUCKETS) {
+        bkt = BKN_RXT_LAT_BUCKETS - 1;
+    }
+    rxt = per_cpu_ptr(filter->rxt, smp_processor_id());
+    rxt->lat[bkt]++;
+}
+
+static inline void
+bkn_rxt_drop(bkn_filter_t *filter, int cause)
+{
+    if (!rx_telemetry || filter == NULL || filter->rxt == NULL) {
+        return;
+    }
+    per_cpu_ptr(filter->rxt, smp_processor_id())->drops[cause]++;
+}
+
+static void
+bkn_rxt_sum(bkn_filter_t *filter, bkn_rxt_stats_t *sum)
+{
+    bkn_rxt_stats_t *rxt;
+    int cpu, idx;
+
+    memset(sum, 0, sizeof(*sum));
+    if (filter->rxt == NULL) {
+        return;
+    }
+    for_each_possible_cpu(cpu) {
+        rxt = per_cpu_ptr(filter->rxt, cpu);
+        for (idx = 0; idx < BKN_RXT_LAT_BUCKETS; idx++) {
+            sum->lat[idx] += rxt->lat[idx];
+        }
+        for (idx = 0; idx < BKN_RXT_DROP_MAX; idx++) {
+            sum->drops[idx] += rxt->drops[idx];
+        }
+    }
+}
+
+static void
+bkn_rxt_clear(bkn_filter_t *filter)
+{
+    int cpu;
+
+    if (filter->rxt == NULL) {
+        return;
+    }
+    for_each_possible_cpu(cpu) {
+        memset(per_cpu_ptr(filter->rxt, cpu), 0, sizeof(bkn_rxt_stats_t));
+    }
+}
+
 static bool
 bkn_netif_ok(struct net_device *dev)
 {
@@ -4260,6 +4871,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
     uint32_t *dcb, *meta, *match_data;
     uint8_t *pkt;
     uint64_t pkt_dma;
+    uint64_t t0;
     int drop_api;
     int ethertype;
     int pktlen, pkt_hdr_size = 0;
@@ -4308,6 +4920,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
         } else {
             pkt_dma = dcb[0];
         }
+        t0 = bkn_rxt_start();
         pkt = (uint8_t *)kernel_bde->p2l(sinfo->dev_no, (sal_paddr_t)pkt_dma);
         pktlen = dcb[sinfo->dcb_wsize-1] & SOC_DCB_KNET_COUNT_MASK;
         bkn_dump_pkt(pkt, pktlen, XGS_DMA_RX_CHAN);
@@ -4407,6 +5020,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                 /* Fragment or error */
                 if (filter && filter->kf.mask.w[err_woff] == 0) {
                     /* Drop unless DCB status is part of filter */
+                    bkn_rxt_drop(filter, BKN_RXT_DROP_PKT_ERR);
                     filter = NULL;
                 }
             }
@@ -4418,6 +5032,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
             case KCOM_DEST_T_API:
                 DBG_FLTR(("Send to Rx API\n"));
                 sinfo->rx[chan].pkts_f_api++;
+                bkn_rxt_done(filter, t0);
                 drop_api = 0;
                 break;
             case KCOM_DEST_T_NETIF:
@@ -4426,6 +5041,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                     /* Check that software link is up */
                     if (!bkn_netif_ok(priv->dev)) {
                         sinfo->rx[chan].pkts_d_no_link++;
+                        bkn_rxt_drop(filter, BKN_RXT_DROP_NO_LINK);
                         break;
                     }
 
@@ -4437,6 +5053,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                         skb = dev_alloc_skb(pktlen + RCPU_HDR_SIZE + pkt_hdr_size + 2);
                         if (skb == NULL) {
                             sinfo->rx[chan].pkts_d_no_skb++;
+                            bkn_rxt_drop(filter, BKN_RXT_DROP_NO_SKB);
                             break;
                         }
                         skb_reserve(skb, RCPU_HDR_SIZE + pkt_hdr_size);
@@ -4444,6 +5061,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                         skb = dev_alloc_skb(pktlen + RCPU_RX_ENCAP_SIZE + 2);
                         if (skb == NULL) {
                             sinfo->rx[chan].pkts_d_no_skb++;
+                            bkn_rxt_drop(filter, BKN_RXT_DROP_NO_SKB);
                             break;
                         }
                         skb_reserve(skb, RCPU_RX_ENCAP_SIZE);
@@ -4518,6 +5136,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                         if (skb == NULL) {
                             /* Consumed by call-back */
                             sinfo->rx[chan].pkts_d_callback++;
+                            bkn_rxt_drop(filter, BKN_RXT_DROP_CALLBACK);
                             break;
                         }
                     }
@@ -4541,6 +5160,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                         bkn_eth_type_update(skb, ethertype);
                     }
                     DBG_DUNE(("skb protocol 0x%04x\n", skb->protocol));
+                    bkn_rxt_done(filter, t0);
 
                     /*
                      * Disable configuration API while the spinlock is released.
@@ -4567,6 +5187,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                     DBG_FLTR(("Unknown netif %d\n",
                               filter->kf.dest_id));
                     sinfo->rx[chan].pkts_d_unkn_netif++;
+                    bkn_rxt_drop(filter, BKN_RXT_DROP_UNKN_NETIF);
                 }
                 break;
             default:
@@ -4574,6 +5195,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                 DBG_FLTR(("Unknown dest type %d\n",
                           filter->kf.dest_type));
                 sinfo->rx[chan].pkts_d_unkn_dest++;
+                bkn_rxt_drop(filter, BKN_RXT_DROP_UNKN_DEST);
                 break;
             }
         } else {
@@ -4649,6 +5271,7 @@ bkn_skb_rx_netif_process(bkn_switch_info_t *sinfo, int dest_id, int chan,
         if (skb == NULL) {
             /* Consumed by call-back */
             sinfo->rx[chan].pkts_d_callback++;
+            bkn_rxt_drop(filter, BKN_RXT_DROP_CALLBACK);
             priv->stats.rx_dropped++;
             return -1;
         }
@@ -4698,6 +5321,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
     struct sk_buff *mskb = NULL;
     uint32_t *rx_cb_meta;
     int metalen;
+    uint64_t t0;
 
     if (!sinfo->rx[chan].running) {
         /* Rx not ready */
@@ -4727,6 +5351,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
             }
         }
         sinfo->rx[chan].pkts++;
+        t0 = bkn_rxt_start();
         skb = desc->skb;
 
         DBG_DCB_RX(("Rx%d SKB DMA done (%d).\n", chan, sinfo->rx[chan].dirty));
@@ -4874,6 +5499,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                 priv->stats.rx_errors++;
                 if (filter && filter->kf.mask.w[err_woff] == 0) {
                     /* Drop unless DCB status is part of filter */
+                    bkn_rxt_drop(filter, BKN_RXT_DROP_PKT_ERR);
                     filter = NULL;
                 }
             }
@@ -4886,6 +5512,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                 DBG_FLTR(("Send to Rx API\n"));
                 sinfo->rx[chan].pkts_f_api++;
                 bkn_api_rx_copy_from_skb(sinfo, chan, desc, 0);
+                bkn_rxt_done(filter, t0);
                 break;
             case KCOM_DEST_T_NETIF:
                 priv = bkn_netif_lookup(sinfo, filter->kf.dest_id);
@@ -4895,6 +5522,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                     /* Check that software link is up */
                     if (!bkn_netif_ok(priv->dev)) {
                         sinfo->rx[chan].pkts_d_no_link++;
+                        bkn_rxt_drop(filter, BKN_RXT_DROP_NO_LINK);
                         break;
                     }
                     DBG_FLTR(("Send to netif %d (%s)\n",
@@ -4976,6 +5604,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                                 mskb = skb_clone(skb, GFP_ATOMIC);
                                 if (mskb == NULL) {
                                     sinfo->rx[chan].pkts_d_no_skb++;
+                                    bkn_rxt_drop(filter, BKN_RXT_DROP_NO_SKB);
                                 }
                             }
                         }
@@ -5015,6 +5644,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                                 mskb = skb_clone(skb, GFP_ATOMIC);
                                 if (mskb == NULL) {
                                     sinfo->rx[chan].pkts_d_no_skb++;
+                                    bkn_rxt_drop(filter, BKN_RXT_DROP_NO_SKB);
                                 } else {
                                     mpriv->stats.rx_packets++;
                                     mpriv->stats.rx_bytes += mskb->len;
@@ -5052,6 +5682,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
 
                     /* Ensure that we reallocate SKB for this DCB */
                     desc->skb = NULL;
+                    bkn_rxt_done(filter, t0);
                     /*
                      * Disable configuration API while the spinlock
                      * is released.
@@ -5075,6 +5706,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                     DBG_FLTR(("Unknown netif %d\n",
                               filter->kf.dest_id));
                     sinfo->rx[chan].pkts_d_unkn_netif++;
+                    bkn_rxt_drop(filter, BKN_RXT_DROP_UNKN_NETIF);
                 }
                 break;
             default:
@@ -5082,6 +5714,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                 DBG_FLTR(("Unknown dest type %d\n",
                           filter->kf.dest_type));
                 sinfo->rx[chan].pkts_d_unkn_dest++;
+                bkn_rxt_drop(filter, BKN_RXT_DROP_UNKN_DEST);
                 break;
             }
         } else {
@@ -5286,6 +5919,17 @@ bkn_rx_chain_done(bkn_switch_info_t *sinfo, int chan)
     }
 }
 
+/*
+ * Check for an unreserved Tx DCB. One spare DCB is kept for the SKB Tx
+ * ring and one for the API Tx reload DCB in Continuous DMA mode, so a
+ * reserved DCB can always be claimed. Must be called with lock held.
+ */
+static int
+bkn_tx_resrc_avail(bkn_switch_info_t *sinfo)
+{
+    return (sinfo->tx.free - sinfo->tx.reserved) > 2;
+}
+
 static void
 bkn_suspend_tx(bkn_switch_info_t *sinfo)
 {
@@ -5293,13 +5937,14 @@ bkn_suspend_tx(bkn_switch_info_t *sinfo)
     bkn_priv_t *priv = netdev_priv(sinfo->dev);
 
     /* Stop main device */
-    netif_stop_queue(priv->dev);
+    netif_tx_stop_all_queues(priv->dev);
     sinfo->tx.suspends++;
+    sinfo->tx.stopped = 1;
     /* Stop associated virtual devices */
     list_for_each(list, &sinfo->ndev_list) {
         priv = (bkn_priv_t *)list;
         if (priv->dev) {
-            netif_stop_queue(priv->dev);
+            netif_tx_stop_all_queues(priv->dev);
         }
     }
 }
@@ -5310,17 +5955,19 @@ bkn_resume_tx(bkn_switch_info_t *sinfo)
     struct list_head *list;
     bkn_priv_t *priv = netdev_priv(sinfo->dev);
 
-    /* Check main device */
-    if (netif_queue_stopped(priv->dev) && sinfo->tx.free > 1) {
-        netif_wake_queue(priv->dev);
+    /* Only walk the devices once per suspend */
+    if (!sinfo->tx.stopped || !bkn_tx_resrc_avail(sinfo)) {
+        return;
     }
-    /* Check associated virtual devices */
+    sinfo->tx.stopped = 0;
+
+    /* Wake main device */
+    netif_tx_wake_all_queues(priv->dev);
+    /* Wake associated virtual devices */
     list_for_each(list, &sinfo->ndev_list) {
         priv = (bkn_priv_t *)list;
         if (priv->dev) {
-            if (netif_queue_stopped(priv->dev) && sinfo->tx.free > 1) {
-                netif_wake_queue(priv->dev);
-            }
+            netif_tx_wake_all_queues(priv->dev);
         }
     }
 }
@@ -6395,7 +7042,7 @@ bkn_open(struct net_device *dev)
     }
 
     if (!sinfo->basedev_suspended) {
-        netif_start_queue(dev);
+        netif_tx_start_all_queues(dev);
     }
 
     return 0;
@@ -6587,7 +7234,7 @@ bkn_stop(struct net_device *dev)
     bkn_switch_info_t *sinfo = priv->sinfo;
     unsigned long flags;
 
-    netif_stop_queue(dev);
+    netif_tx_stop_all_queues(dev);
 
     /* Check if base device */
     if (priv->id <= 0) {
@@ -6676,6 +7323,49 @@ bkn_hw_tstamp_tx_config(bkn_switch_info_t *sinfo,
     return 0;
 }
 
+/*
+ * Reserve a Tx DCB before the packet is built outside the lock, so the
+ * skb is never modified unless a DCB is guaranteed to be available.
+ */
+static int
+bkn_tx_resrc_ok(bkn_switch_info_t *sinfo)
+{
+    unsigned long flags;
+    int ok;
+
+    spin_lock_irqsave(&sinfo->lock, flags);
+    ok = bkn_tx_resrc_avail(sinfo);
+    if (ok) {
+        sinfo->tx.reserved++;
+    } else {
+        DBG_VERB(("Tx busy: No DMA resources\n"));
+        sinfo->tx.pkts_d_dma_resrc++;
+        bkn_suspend_tx(sinfo);
+    }
+    spin_unlock_irqrestore(&sinfo->lock, flags);
+
+    return ok;
+}
+
+static int
+bkn_tx_drop(bkn_switch_info_t *sinfo, bkn_priv_t *priv,
+            struct sk_buff *skb, uint32_t *cnt)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&sinfo->lock, flags);
+    /* Release the DCB reserved by bkn_tx_resrc_ok */
+    sinfo->tx.reserved--;
+    priv->stats.tx_dropped++;
+    if (cnt) {
+        (*cnt)++;
+    }
+    spin_unlock_irqrestore(&sinfo->lock, flags);
+    dev_kfree_skb_any(skb);
+
+    return 0;
+}
+
 static int
 bkn_tx(struct sk_buff *skb, struct net_device *dev)
 {
@@ -6715,10 +7405,13 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
         return 0;
     }
 
-    spin_lock_irqsave(&sinfo->lock, flags);
-
-    if (sinfo->tx.free > 1) {
-        bkn_desc_info_t *desc = &sinfo->tx.desc[sinfo->tx.cur];
+    /*
+     * Build the packet and its DCB outside the switch lock, so transmitting
+     * CPUs only serialize on claiming the descriptor.
+     */
+    if (bkn_tx_resrc_ok(sinfo)) {
+        bkn_desc_info_t *desc;
+        uint32_t dcb_buf[TX_DCB_WSIZE_MAX];
         uint32_t *dcb, *meta;
 
         pktdata = skb->data;
@@ -6765,20 +7458,12 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
             rcpulen = RCPU_HDR_SIZE;
             if (skb->len < (rcpulen + 14)) {
                 DBG_WARN(("Tx drop: Invalid RCPU encapsulation\n"));
-                priv->stats.tx_dropped++;
-                sinfo->tx.pkts_d_rcpu_encap++;
-                dev_kfree_skb_any(skb);
-                spin_unlock_irqrestore(&sinfo->lock, flags);
-                return 0;
+                return bkn_tx_drop(sinfo, priv, skb, &sinfo->tx.pkts_d_rcpu_encap);
             }
             if (check_rcpu_signature &&
                 PKT_U16_GET(skb->data, 18) != sinfo->rcpu_sig) {
                 DBG_WARN(("Tx drop: Invalid RCPU signature\n"));
-                priv->stats.tx_dropped++;
-                sinfo->tx.pkts_d_rcpu_sig++;
-                dev_kfree_skb_any(skb);
-                spin_unlock_irqrestore(&sinfo->lock, flags);
-                return 0;
+                return bkn_tx_drop(sinfo, priv, skb, &sinfo->tx.pkts_d_rcpu_sig);
             }
 
             if (device_is_sand(sinfo)) {
@@ -6798,20 +7483,12 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
                     break;
                 default:
                     DBG_WARN(("Tx drop: Invalid RCPU meta data\n"));
-                    priv->stats.tx_dropped++;
-                    sinfo->tx.pkts_d_rcpu_meta++;
-                    dev_kfree_skb_any(skb);
-                    spin_unlock_irqrestore(&sinfo->lock, flags);
-                    return 0;
+                    return bkn_tx_drop(sinfo, priv, skb, &sinfo->tx.pkts_d_rcpu_meta);
                 }
                 if (sinfo->cmic_type != 'x') {
                     if (skb->len < (rcpulen + RCPU_TX_META_SIZE + 14)) {
                         DBG_WARN(("Tx drop: Invalid RCPU encapsulation\n"));
-                        priv->stats.tx_dropped++;
-                        sinfo->tx.pkts_d_rcpu_encap++;
-                        dev_kfree_skb_any(skb);
-                        spin_unlock_irqrestore(&sinfo->lock, flags);
-                        return 0;
+                        return bkn_tx_drop(sinfo, priv, skb, &sinfo->tx.pkts_d_rcpu_encap);
                     }
                     rcpulen += RCPU_TX_META_SIZE;
                 }
@@ -6846,11 +7523,7 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
                                                       GFP_ATOMIC);
                             if (new_skb == NULL) {
                                 DBG_WARN(("Tx drop: No SKB memory\n"));
-                                priv->stats.tx_dropped++;
-                                sinfo->tx.pkts_d_no_skb++;
-                                dev_kfree_skb_any(skb);
-                                spin_unlock_irqrestore(&sinfo->lock, flags);
-                                return 0;
+                                return bkn_tx_drop(sinfo, priv, skb, &sinfo->tx.pkts_d_no_skb);
                             }
                             /* Remove rcpulen from buffer. */
                             skb_pull(new_skb, rcpulen);
@@ -6898,11 +7571,7 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
                                               GFP_ATOMIC);
                     if (new_skb == NULL) {
                         DBG_WARN(("Tx drop: No SKB memory\n"));
-                        priv->stats.tx_dropped++;
-                        sinfo->tx.pkts_d_no_skb++;
-                        dev_kfree_skb_any(skb);
-                        spin_unlock_irqrestore(&sinfo->lock, flags);
-                        return 0;
+                        return bkn_tx_drop(sinfo, priv, skb, &sinfo->tx.pkts_d_no_skb);
                     }
                     skb_push(new_skb, hdrlen);
                     bkn_skb_tstamp_copy(new_skb, skb);
@@ -6935,11 +7604,7 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
                                                   GFP_ATOMIC);
                         if (new_skb == NULL) {
                             DBG_WARN(("Tx drop: No SKB memory\n"));
-                            priv->stats.tx_dropped++;
-                            sinfo->tx.pkts_d_no_skb++;
-                            dev_kfree_skb_any(skb);
-                            spin_unlock_irqrestore(&sinfo->lock, flags);
-                            return 0;
+                            return bkn_tx_drop(sinfo, priv, skb, &sinfo->tx.pkts_d_no_skb);
                         }
                         skb_push(new_skb, TAG_SZ);
                         memcpy(new_skb->data, pktdata, hdrlen + 12);
@@ -6974,11 +7639,7 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
             pktlen = (60 + taglen + hdrlen);
             if (SKB_PADTO(skb, pktlen) != 0) {
                 DBG_WARN(("Tx drop: skb_padto failed\n"));
-                priv->stats.tx_dropped++;
-                sinfo->tx.pkts_d_pad_fail++;
-                dev_kfree_skb_any(skb);
-                spin_unlock_irqrestore(&sinfo->lock, flags);
-                return 0;
+                return bkn_tx_drop(sinfo, priv, skb, &sinfo->tx.pkts_d_pad_fail);
             }
             /* skb_padto may update the skb->data pointer */
             pktdata = &skb->data[rcpulen];
@@ -6987,14 +7648,10 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
         if ((pktlen + FCS_SZ) > SOC_DCB_KNET_COUNT_MASK) {
             DBG_WARN(("Tx drop: size of pkt (%d) is out of range(%d)\n",
                      (pktlen + FCS_SZ), SOC_DCB_KNET_COUNT_MASK));
-            sinfo->tx.pkts_d_over_limit++;
-            priv->stats.tx_dropped++;
-            dev_kfree_skb_any(skb);
-            spin_unlock_irqrestore(&sinfo->lock, flags);
-            return 0;
+            return bkn_tx_drop(sinfo, priv, skb, &sinfo->tx.pkts_d_over_limit);
         }
 
-        dcb = desc->dcb_mem;
+        dcb = dcb_buf;
         meta = ((sinfo->cmic_type == 'x') || (sinfo->cmic_type == 'r')) ? (uint32_t *)pktdata : dcb;
         memset(dcb, 0, sinfo->dcb_wsize * sizeof(uint32_t));
         if (priv->flags & KCOM_NETIF_F_RCPU_ENCAP) {
@@ -7155,6 +7812,11 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
             }
         }
 
+        spin_lock_irqsave(&sinfo->lock, flags);
+
+        /* The reserved DCB is claimed (or given up) under this lock */
+        sinfo->tx.reserved--;
+
         /* Optional SKB updates */
         if (knet_tx_cb != NULL) {
             KNET_SKB_CB(skb)->netif_user_data = priv->cb_user_data;
@@ -7232,6 +7894,9 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
         }
 
         /* Prepare for DMA */
+        desc = &sinfo->tx.desc[sinfo->tx.cur];
+        memcpy(desc->dcb_mem, dcb, sinfo->dcb_wsize * sizeof(uint32_t));
+        dcb = desc->dcb_mem;
         desc->skb = skb;
         /*
          * Add FCS bytes
@@ -7290,10 +7955,6 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
         priv->stats.tx_bytes += pktlen;
         sinfo->tx.pkts++;
     } else {
-        DBG_VERB(("Tx busy: No DMA resources\n"));
-        sinfo->tx.pkts_d_dma_resrc++;
-        bkn_suspend_tx(sinfo);
-        spin_unlock_irqrestore(&sinfo->lock, flags);
         return BKN_NETDEV_TX_BUSY;
     }
 
@@ -7744,9 +8405,20 @@ static struct net_device *
 bkn_init_ndev(u8 *mac, char *name)
 {
     struct net_device *dev;
+    int txqs;
+
+    /*
+     * The switch has a single Tx DMA ring, but exposing one queue per CPU
+     * gives each CPU its own qdisc and xmit lock (and XPS mapping), so
+     * the stack no longer serializes all transmitting CPUs on one queue.
+     */
+    txqs = tx_queues > 0 ? tx_queues : num_online_cpus();
+    if (txqs > MAX_TX_QUEUES) {
+        txqs = MAX_TX_QUEUES;
+    }
 
     /* Create Ethernet device */
-    dev = alloc_etherdev(sizeof(bkn_priv_t));
+    dev = alloc_etherdev_mq(sizeof(bkn_priv_t), txqs);
 
     if (dev == NULL) {
         DBG_WARN(("Error allocating Ethernet device.\n"));
@@ -8466,7 +9138,8 @@ bkn_proc_stats_show(struct seq_file *m, void *v)
     struct list_head *list, *flist;
     bkn_switch_info_t *sinfo;
     bkn_filter_t *filter;
-    int chan;
+    bkn_rxt_stats_t rxt;
+    int chan, idx;
     unsigned long flags;
 
     list_for_each(list, &_sinfo_list) {
@@ -8496,6 +9169,30 @@ bkn_proc_stats_show(struct seq_file *m, void *v)
 
             seq_printf(m, "  Filter %d stats:\n", filter->kf.id);
             seq_printf(m, "    Hits      %10lu\n", filter->hits);
+            if (filter->rxt == NULL) {
+                continue;
+            }
+            bkn_rxt_sum(filter, &rxt);
+            for (idx = 0; idx < BKN_RXT_LAT_BUCKETS; idx++) {
+                if (rxt.lat[idx] == 0) {
+                    continue;
+                }
+                if (idx == BKN_RXT_LAT_BUCKETS - 1) {
+                    seq_printf(m, "    Rx lat >=%8lluns %10llu\n",
+                               (1ULL << (BKN_RXT_LAT_SHIFT + idx - 1)),
+                               rxt.lat[idx]);
+                } else {
+                    seq_printf(m, "    Rx lat < %8lluns %10llu\n",
+                               (1ULL << (BKN_RXT_LAT_SHIFT + idx)),
+                               rxt.lat[idx]);
+                }
+            }
+            for (idx = 0; idx < BKN_RXT_DROP_MAX; idx++) {
+                if (rxt.drops[idx]) {
+                    seq_printf(m, "    Rx drop %-10s %10llu\n",
+                               bkn_rxt_drop_names[idx], rxt.drops[idx]);
+                }
+            }
         }
 
         unit++;
@@ -8572,6 +9269,7 @@ bkn_proc_stats_write(struct file *file, const char *buf,
         list_for_each(flist, &sinfo->rxpf_list) {
             filter = (bkn_filter_t *)flist;
             filter->hits = 0;
+            bkn_rxt_clear(filter);
         }
     }
 
@@ -8587,6 +9285,109 @@ struct proc_ops bkn_proc_stats_file_ops = {
     .proc_release =     single_release,
 };
 
+/*
+ * Rx Filter Classifier Check Proc Entry
+ */
+static DEFINE_MUTEX(bkn_rxpf_check_lock);
+
+static int
+bkn_proc_rxpf_check_show(struct seq_file *m, void *v)
+{
+    int unit = 0;
+    struct list_head *list;
+    bkn_switch_info_t *sinfo;
+
+    list_for_each(list, &_sinfo_list) {
+        sinfo = (bkn_switch_info_t *)list;
+
+        seq_printf(m, "Device %d:\n", unit);
+        seq_printf(m, "  Packets replayed       %10lu\n",
+                   sinfo->rxpf_check_pkts);
+        seq_printf(m, "  Packets matched        %10lu\n",
+                   sinfo->rxpf_check_matched);
+        seq_printf(m, "  Mismatches             %10lu\n",
+                   sinfo->rxpf_check_mismatch);
+        unit++;
+    }
+    return 0;
+}
+
+static int bkn_proc_rxpf_check_open(struct inode * inode, struct file * file)
+{
+    return single_open(file, bkn_proc_rxpf_check_show, NULL);
+}
+
+/*
+ * Rx Filter Classifier Check Proc Write Entry
+ *
+ *   Syntax:
+ *   [<unit>:]rounds=<n> [seed=<s>]
+ *
+ *   Where <n> is the number of rounds to replay, at most 10000, and <s>
+ *   seeds the packet generator.
+ *
+ *   Examples:
+ *   rounds=100
+ *   0:rounds=1000 seed=42
+ */
+static ssize_t
+bkn_proc_rxpf_check_write(struct file *file, const char *buf,
+                          size_t count, loff_t *loff)
+{
+    bkn_switch_info_t *sinfo;
+    char debug_str[40];
+    char *ptr;
+    int unit;
+    int rounds;
+    uint32_t seed;
+
+    if (count > sizeof(debug_str) - 1) {
+        count = sizeof(debug_str) - 1;
+    }
+    if (copy_from_user(debug_str, buf, count)) {
+        return -EFAULT;
+    }
+    debug_str[count] = '\0';
+
+    unit = simple_strtol(debug_str, NULL, 10);
+    sinfo = bkn_sinfo_from_unit(unit);
+    if (sinfo == NULL) {
+        gprintk("Warning: unknown unit: %d\n", unit);
+        return count;
+    }
+
+    if ((ptr = strstr(debug_str, "rounds=")) == NULL) {
+        gprintk("Warning: unknown configuration setting\n");
+        return count;
+    }
+    rounds = simple_strtol(ptr + 7, NULL, 0);
+    if (rounds <= 0 || rounds > BKN_RXPF_CHECK_ROUNDS_MAX) {
+        gprintk("Warning: rounds must be 1..%d\n", BKN_RXPF_CHECK_ROUNDS_MAX);
+        return count;
+    }
+    seed = 0;
+    if ((ptr = strstr(debug_str, "seed=")) != NULL) {
+        seed = simple_strtoul(ptr + 5, NULL, 0);
+    }
+
+    mutex_lock(&bkn_rxpf_check_lock);
+    if (bkn_rxpf_check(sinfo, rounds, seed) < 0) {
+        gprintk("Warning: Rx filter check out of memory\n");
+    }
+    mutex_unlock(&bkn_rxpf_check_lock);
+
+    return count;
+}
+
+struct proc_ops bkn_proc_rxpf_check_file_ops = {
+    PROC_OWNER(THIS_MODULE)
+    .proc_open =        bkn_proc_rxpf_check_open,
+    .proc_read =        seq_read,
+    .proc_lseek =       seq_lseek,
+    .proc_write =       bkn_proc_rxpf_check_write,
+    .proc_release =     single_release,
+};
+
 
 /*
  * Device Debug Statistics Proc Entry
@@ -8625,6 +9426,8 @@ bkn_proc_dstats_show(struct seq_file *m, void *v)
                         sinfo->tx.pkts_d_over_limit);
         seq_printf(m, "  Tx suspends         %10u\n",
                         sinfo->tx.suspends);
+        seq_printf(m, "  Tx queues per netif %10u\n",
+                        sinfo->dev->real_num_tx_queues);
         for (chan = 0; chan < sinfo->rx_chans; chan++) {
             seq_printf(m, "  Rx%d filter to api   %10u\n",
                             chan, sinfo->rx[chan].pkts_f_api);
@@ -8991,6 +9794,11 @@ bkn_proc_init(void)
     if (entry == NULL) {
         return -1;
     }
+    PROC_CREATE(entry, "rx_filter_check", 0666, bkn_proc_root,
+                &bkn_proc_rxpf_check_file_ops);
+    if (entry == NULL) {
+        return -1;
+    }
 
     return 0;
 }
@@ -9006,6 +9814,7 @@ bkn_proc_cleanup(void)
     remove_proc_entry("dstats", bkn_proc_root);
     remove_proc_entry("ptp_stats", bkn_proc_root);
     remove_proc_entry("ndev", bkn_proc_root);
+    remove_proc_entry("rx_filter_check", bkn_proc_root);
     return 0;
 }
 
@@ -9408,7 +10217,8 @@ bkn_knet_hw_init(kcom_msg_hw_init_t *kmsg, int len)
     if ((kmsg->cmic_type == 'r' && kmsg->dcb_size < CMICR_DCB_SIZE_MIN) ||
         (kmsg->cmic_type == 'x' && kmsg->dcb_size < CMICX_DCB_SIZE_MIN) ||
         ((kmsg->cmic_type != 'x' && kmsg->cmic_type != 'r') && kmsg->dcb_size < DCB_SIZE_MIN) ||
-        (kmsg->dcb_type != 39 && kmsg->cmic_type == 'x' && kmsg->pkt_hdr_size < CMICX_PKT_HDR_SIZE_MIN)) {
+        (kmsg->dcb_type != 39 && kmsg->cmic_type == 'x' && kmsg->pkt_hdr_size < CMICX_PKT_HDR_SIZE_MIN) ||
+        BYTES2WORDS(kmsg->dcb_size) > TX_DCB_WSIZE_MAX) {
         kmsg->hdr.status = KCOM_E_PARAM;
         return sizeof(kcom_msg_hdr_t);
     }
@@ -10003,6 +10813,7 @@ bkn_knet_filter_create(kcom_msg_filter_create_t *kmsg, int len)
     struct list_head *list;
     bkn_filter_t *filter, *lfilter;
     bkn_filter_cb_t *filter_cb;
+    bkn_rxpf_cls_t *old_cls;
     unsigned long flags;
     int found, id;
     int oob_offset_max;
@@ -10075,6 +10886,8 @@ bkn_knet_filter_create(kcom_msg_filter_create_t *kmsg, int len)
     memset(filter, 0, sizeof(*filter));
     memcpy(&filter->kf, &kmsg->filter, sizeof(filter->kf));
     filter->kf.id = id;
+    /* Filter still works without telemetry if this fails */
+    filter->rxt = alloc_percpu(bkn_rxt_stats_t);
     /* Check for filter-specific callback */
     if (filter->kf.dest_type == KCOM_DEST_T_CB && filter->kf.desc[0] != '\0') {
         list_for_each(list, &filter_cb_list) {
@@ -10101,11 +10914,14 @@ bkn_knet_filter_create(kcom_msg_filter_create_t *kmsg, int len)
     if (!found) {
         list_add_tail(&filter->list, &sinfo->rxpf_list);
     }
+    old_cls = bkn_rxpf_cls_update(sinfo);
 
     kmsg->filter.id = filter->kf.id;
 
     spin_unlock_irqrestore(&sinfo->lock, flags);
 
+    bkn_rxpf_cls_free(old_cls);
+
     DBG_VERB(("Created filter ID %d (%s).\n",
               filter->kf.id, filter->kf.desc));
     if (device_is_sand(sinfo)) {
@@ -10135,6 +10951,7 @@ bkn_knet_filter_destroy(kcom_msg_filter_destroy_t *kmsg, int len)
     bkn_switch_info_t *sinfo;
     bkn_filter_t *filter;
     struct list_head *list;
+    bkn_rxpf_cls_t *old_cls;
     unsigned long flags;
     int found;
 
@@ -10164,10 +10981,13 @@ bkn_knet_filter_destroy(kcom_msg_filter_destroy_t *kmsg, int len)
     }
 
     list_del(&filter->list);
+    old_cls = bkn_rxpf_cls_update(sinfo);
 
     cfg_api_unlock(sinfo, &flags);
 
+    bkn_rxpf_cls_free(old_cls);
     DBG_VERB(("Removing filter ID %d.\n", filter->kf.id));
+    free_percpu(filter->rxt);
     kfree(filter);
 
     return sizeof(kcom_msg_hdr_t);
@@ -10588,10 +11408,13 @@ _cleanup(void)
         sinfo = list_entry(_sinfo_list.next, bkn_switch_info_t, list);
 
         /* Destroy all associated Rx packet filters */
+        bkn_rxpf_cls_free(sinfo->rxpf_cls);
+        sinfo->rxpf_cls = NULL;
         while (!list_empty(&sinfo->rxpf_list)) {
             filter = list_entry(sinfo->rxpf_list.next, bkn_filter_t, list);
             list_del(&filter->list);
             DBG_VERB(("Removing filter ID %d.\n", filter->kf.id));
+            free_percpu(filter->rxt);
             kfree(filter);
         }
 
@@ -150,6 +150,29 @@ static ssize_t wb_get_main_board_curr_value(unsigned int curr_index, char *buf,
     return ret;
 }
 
+/*
+ * wb_get_main_board_curr_value_stat - Used to get the min/max/avg input value of current sensor
+ * over the sampling window, filled the value to buf, the value is integer with mA
+ * @curr_index: start with 1
+ * @stat: WB_SENSOR_STAT_MIN/WB_SENSOR_STAT_MAX/WB_SENSOR_STAT_AVG
+ * @buf: Data receiving buffer
+ * @count: length of buf
+ *
+ * This function returns the length of the filled buffer,
+ * otherwise it returns a negative value on failed.
+ */
+static ssize_t wb_get_main_board_curr_value_stat(unsigned int curr_index, unsigned int stat, char *buf,
+                   size_t count)
+{
+    ssize_t ret;
+
+    check_p(g_drv);
+    check_p(g_drv->get_main_board_curr_value_stat);
+
+    ret = g_drv->get_main_board_curr_value_stat(curr_index, stat, buf, count);
+    return ret;
+}
+
 /*
  * wb_get_main_board_curr_monitor_flag - Used to get the monitor flag of current sensor
  * filled the value to buf, the value is integer with mA
@@ -183,6 +206,7 @@ static struct s3ip_sysfs_curr_sensor_drivers_s drivers = {
     .get_main_board_curr_max = wb_get_main_board_curr_max,
     .get_main_board_curr_min = wb_get_main_board_curr_min,
     .get_main_board_curr_value = wb_get_main_board_curr_value,
+    .get_main_board_curr_value_stat = wb_get_main_board_curr_value_stat,
     .get_main_board_curr_monitor_flag = wb_get_main_board_curr_monitor_flag,
 };
 
@@ -196,6 +196,29 @@ static ssize_t wb_get_main_board_vol_value(unsigned int vol_index, char *buf, si
     return ret;
 }
 
+/*
+ * wb_get_main_board_vol_value_stat - Used to get the min/max/avg input value of voltage sensor
+ * over the sampling window, filled the value to buf, the value is integer with mV
+ * @vol_index: start with 1
+ * @stat: WB_SENSOR_STAT_MIN/WB_SENSOR_STAT_MAX/WB_SENSOR_STAT_AVG
+ * @buf: Data receiving buffer
+ * @count: length of buf
+ *
+ * This function returns the length of the filled buffer,
+ * otherwise it returns a negative value on failed.
+ */
+static ssize_t wb_get_main_board_vol_value_stat(unsigned int vol_index, unsigned int stat, char *buf,
+                   size_t count)
+{
+    ssize_t ret;
+
+    check_p(g_drv);
+    check_p(g_drv->get_main_board_vol_value_stat);
+
+    ret = g_drv->get_main_board_vol_value_stat(vol_index, stat, buf, count);
+    return ret;
+}
+
 /*
  * wb_get_main_board_vol_monitor_flag - Used to get the monitor flag of voltage sensor
  * filled the value to buf, the value is integer with mV
@@ -231,6 +254,7 @@ static struct s3ip_sysfs_vol_sensor_drivers_s drivers = {
     .get_main_board_vol_range = wb_get_main_board_vol_range,
     .get_main_board_vol_nominal_value = wb_get_main_board_vol_nominal_value,
     .get_main_board_vol_value = wb_get_main_board_vol_value,
+    .get_main_board_vol_value_stat = wb_get_main_board_vol_value_stat,
     .get_main_board_vol_monitor_flag = wb_get_main_board_vol_monitor_flag,
 };
 
@@ -25,6 +25,7 @@
 #include <linux/fs.h>
 #include <asm/uaccess.h>
 #include <linux/version.h>
+#include <linux/ktime.h>
 
 #include "wb_module.h"
 #include "dfd_cfg_file.h"
@@ -1118,6 +1119,28 @@ static int drv_get_my_dev_type(void)
     return type;
 }
 
+/* Time a lookup of every configuration item, only run with DBG_VERBOSE debug level */
+static void dfd_ko_cfg_lookup_bench(void)
+{
+    lnode_node_t *lnode;
+    ktime_t start;
+    s64 ns;
+    int miss;
+
+    miss = 0;
+    start = ktime_get();
+    list_for_each_entry(lnode, &(dfd_ko_cfg_list_root.root), lst) {
+        if (lnode_find_node(&dfd_ko_cfg_list_root, lnode->key) == NULL) {
+            miss++;
+        }
+    }
+    ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+    DBG_DEBUG(DBG_VERBOSE, "lookup of %d items took %lld ns (%lld ns/item), miss %d\n",
+        dfd_ko_cfg_list_root.count, ns,
+        dfd_ko_cfg_list_root.count ? div_s64(ns, dfd_ko_cfg_list_root.count) : 0, miss);
+}
+
 static int dfd_ko_cfg_init(void)
 {
     int rv;
@@ -1125,6 +1148,7 @@ static int dfd_ko_cfg_init(void)
     char file_name[32] = {0};
     char fpath[128] = {0};
     kfile_ctrl_t kfile_ctrl;
+    ktime_t start;
 
     /* Initializes the list root node */
     rv = lnode_init_root(&dfd_ko_cfg_list_root);
@@ -1149,6 +1173,7 @@ static int dfd_ko_cfg_init(void)
     }
 
     /* Multiple profiles are supported */
+    start = ktime_get();
     while (kfile_gets(file_name, sizeof(file_name), &kfile_ctrl) > 0) {
         /* Read configuration file */
         dfd_ko_cfg_del_space_lf_cr(file_name);
@@ -1162,6 +1187,18 @@ static int dfd_ko_cfg_init(void)
         }
     }
     kfile_close(&kfile_ctrl);
+    DBG_DEBUG(DBG_VERBOSE, "loaded %d items in %lld us\n", dfd_ko_cfg_list_root.count,
+        ktime_to_us(ktime_sub(ktime_get(), start)));
+    if (g_dfd_dbg_level & DBG_VERBOSE) {
+        dfd_ko_cfg_lookup_bench();
+    }
+
+    /* Invalidation of the cached i2c adapters and file handles */
+    rv = dfd_ko_adapter_init();
+    if (rv < 0) {
+        DBG_DEBUG(DBG_ERROR, "init adapter caches fail, rv=%d\n", rv);
+        return -1;
+    }
 
     /* todo Configure data validity check */
     return 0;
@@ -1185,6 +1222,7 @@ int32_t dfd_dev_cfg_init(void)
 
 void dfd_dev_cfg_exit(void)
 {
+    dfd_ko_adapter_exit();
     lnode_free_list(&dfd_ko_cfg_list_root);
     val_convert_node_lst_free(&dfd_lib_cfg_led_status_decode_conv_lst);
     val_convert_node_lst_free(&dfd_lib_cfg_fan_name_conv_dir_lst);
@@ -26,6 +26,12 @@
 #include <linux/delay.h>
 #include <linux/i2c.h>
 #include <linux/uio.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/hashtable.h>
+#include <linux/stringhash.h>
+#include <linux/notifier.h>
+#include <linux/module.h>
 #include "wb_module.h"
 #include "dfd_cfg_file.h"
 #include "dfd_cfg.h"
@@ -37,6 +43,212 @@ char *g_dfd_i2c_dev_mem_str[DFD_I2C_DEV_MEM_END] = {
     ".addr",
 };
 
+/*
+ * i2c adapters and files used by the sensor/eeprom/cpld reads are looked up once and
+ * kept, instead of an i2c_get_adapter()/filp_open() per access. The cache holds its
+ * own reference and every user takes a temporary one, so an entry can be dropped at
+ * any time. Everything is dropped when an i2c adapter or client goes away.
+ *
+ * A cached adapter only holds a device reference. The owner module is pinned per
+ * access, as i2c_get_adapter() does, so the adapter driver can still be unloaded.
+ */
+static struct i2c_adapter *dfd_ko_i2c_adap_cache[DFD_KO_I2C_BUS_MAX];
+static DEFINE_SPINLOCK(dfd_ko_i2c_adap_lock);
+
+typedef struct dfd_ko_file_node_s {
+    struct hlist_node hnode;
+    struct file *filp;
+    char fpath[DFD_SYSFS_PATH_MAX_LEN];
+} dfd_ko_file_node_t;
+
+static DEFINE_HASHTABLE(dfd_ko_file_cache, DFD_KO_FILE_CACHE_BITS);
+static DEFINE_MUTEX(dfd_ko_file_cache_lock);
+static int dfd_ko_file_cache_num;
+
+/* Get a referenced adapter of bus, release it with i2c_put_adapter() */
+static struct i2c_adapter *dfd_ko_get_i2c_adapter(int bus)
+{
+    struct i2c_adapter *adap, *new_adap;
+
+    if ((bus < 0) || (bus >= DFD_KO_I2C_BUS_MAX)) {
+        return i2c_get_adapter(bus);
+    }
+
+    spin_lock(&dfd_ko_i2c_adap_lock);
+    adap = dfd_ko_i2c_adap_cache[bus];
+    if (adap != NULL) {
+        get_device(&adap->dev);
+    }
+    spin_unlock(&dfd_ko_i2c_adap_lock);
+    if (adap != NULL) {
+        if (!try_module_get(adap->owner)) {
+            /* The adapter driver is being unloaded */
+            put_device(&adap->dev);
+            return NULL;
+        }
+        return adap;
+    }
+
+    new_adap = i2c_get_adapter(bus);
+    if (new_adap == NULL) {
+        return NULL;
+    }
+
+    spin_lock(&dfd_ko_i2c_adap_lock);
+    if (dfd_ko_i2c_adap_cache[bus] == NULL) {
+        /* The cache reference, without pinning the owner module */
+        dfd_ko_i2c_adap_cache[bus] = new_adap;
+        get_device(&new_adap->dev);
+    }
+    spin_unlock(&dfd_ko_i2c_adap_lock);
+
+    return new_adap;
+}
+
+static void dfd_ko_i2c_adapter_cache_flush(void)
+{
+    struct i2c_adapter *adap;
+    int bus;
+
+    for (bus = 0; bus < DFD_KO_I2C_BUS_MAX; bus++) {
+        spin_lock(&dfd_ko_i2c_adap_lock);
+        adap = dfd_ko_i2c_adap_cache[bus];
+        dfd_ko_i2c_adap_cache[bus] = NULL;
+        spin_unlock(&dfd_ko_i2c_adap_lock);
+        if (adap != NULL) {
+            put_device(&adap->dev);
+        }
+    }
+}
+
+/* Get a referenced file of fpath opened for reading, release it with fput() */
+static struct file *dfd_ko_get_file(const char *fpath)
+{
+    dfd_ko_file_node_t *node;
+    struct file *filp;
+    u32 hash;
+
+    if (strlen(fpath) >= DFD_SYSFS_PATH_MAX_LEN) {
+        return filp_open(fpath, O_RDONLY, 0);
+    }
+
+    hash = full_name_hash(NULL, fpath, strlen(fpath));
+    mutex_lock(&dfd_ko_file_cache_lock);
+    hash_for_each_possible(dfd_ko_file_cache, node, hnode, hash) {
+        if (strcmp(node->fpath, fpath) == 0) {
+            filp = get_file(node->filp);
+            mutex_unlock(&dfd_ko_file_cache_lock);
+            return filp;
+        }
+    }
+
+    filp = filp_open(fpath, O_RDONLY, 0);
+    if (IS_ERR(filp) || (dfd_ko_file_cache_num >= DFD_KO_FILE_CACHE_MAX)) {
+        mutex_unlock(&dfd_ko_file_cache_lock);
+        return filp;
+    }
+
+    node = kzalloc(sizeof(dfd_ko_file_node_t), GFP_KERNEL);
+    if (node != NULL) {
+        strscpy(node->fpath, fpath, sizeof(node->fpath));
+        node->filp = get_file(filp);
+        hash_add(dfd_ko_file_cache, &node->hnode, hash);
+        dfd_ko_file_cache_num++;
+    }
+    mutex_unlock(&dfd_ko_file_cache_lock);
+
+    return filp;
+}
+
+/* Drop the cached handle of fpath, e.g. after it failed */
+static void dfd_ko_drop_file(const char *fpath)
+{
+    dfd_ko_file_node_t *node;
+    struct hlist_node *tmp;
+    u32 hash;
+
+    hash = full_name_hash(NULL, fpath, strlen(fpath));
+    mutex_lock(&dfd_ko_file_cache_lock);
+    hash_for_each_possible_safe(dfd_ko_file_cache, node, tmp, hnode, hash) {
+        if (strcmp(node->fpath, fpath) == 0) {
+            hash_del(&node->hnode);
+            dfd_ko_file_cache_num--;
+            filp_close(node->filp, NULL);
+            kfree(node);
+            break;
+        }
+    }
+    mutex_unlock(&dfd_ko_file_cache_lock);
+}
+
+static void dfd_ko_file_cache_flush(void)
+{
+    dfd_ko_file_node_t *node;
+    struct hlist_node *tmp;
+    int bkt;
+
+    mutex_lock(&dfd_ko_file_cache_lock);
+    hash_for_each_safe(dfd_ko_file_cache, bkt, tmp, node, hnode) {
+        hash_del(&node->hnode);
+        filp_close(node->filp, NULL);
+        kfree(node);
+    }
+    dfd_ko_file_cache_num = 0;
+    mutex_unlock(&dfd_ko_file_cache_lock);
+}
+
+/* Adapters and the sysfs files of i2c clients go away with their device */
+static int dfd_ko_i2c_notify(struct notifier_block *nb, unsigned long action, void *data)
+{
+    struct device *dev = data;
+    struct i2c_adapter *adap;
+
+    if (action != BUS_NOTIFY_DEL_DEVICE) {
+        return NOTIFY_DONE;
+    }
+
+    adap = i2c_verify_adapter(dev);
+    if ((adap != NULL) && (adap->nr >= 0) && (adap->nr < DFD_KO_I2C_BUS_MAX)) {
+        spin_lock(&dfd_ko_i2c_adap_lock);
+        if (dfd_ko_i2c_adap_cache[adap->nr] != adap) {
+            adap = NULL;
+        } else {
+            dfd_ko_i2c_adap_cache[adap->nr] = NULL;
+        }
+        spin_unlock(&dfd_ko_i2c_adap_lock);
+        if (adap != NULL) {
+            put_device(&adap->dev);
+        }
+    }
+    dfd_ko_file_cache_flush();
+
+    return NOTIFY_OK;
+}
+
+static struct notifier_block dfd_ko_i2c_notifier = {
+    .notifier_call = dfd_ko_i2c_notify,
+};
+
+/**
+ * dfd_ko_adapter_init - Set up the i2c adapter and file handle caches
+ *
+ * @returns: <0 Failed, others succeeded
+ */
+int dfd_ko_adapter_init(void)
+{
+    return bus_register_notifier(&i2c_bus_type, &dfd_ko_i2c_notifier);
+}
+
+/**
+ * dfd_ko_adapter_exit - Release all the cached i2c adapters and files
+ */
+void dfd_ko_adapter_exit(void)
+{
+    bus_unregister_notifier(&i2c_bus_type, &dfd_ko_i2c_notifier);
+    dfd_ko_i2c_adapter_cache_flush();
+    dfd_ko_file_cache_flush();
+}
+
 static dfd_i2c_dev_t* dfd_ko_get_cpld_i2c_dev(int sub_slot, int cpld_id)
 {
     uint64_t key;
@@ -56,21 +268,18 @@ static dfd_i2c_dev_t* dfd_ko_get_cpld_i2c_dev(int sub_slot, int cpld_id)
 
 static int dfd_ko_i2c_block_read(int bus, int addr, int offset, uint8_t *buf, uint32_t size)
 {
-    struct file *fp;
+    struct i2c_adapter *i2c_adap;
     struct i2c_client client;
     int i;
     int rv = 0;
-    char i2c_path[32];
 
-    mem_clear(i2c_path, 32);
-    snprintf(i2c_path, sizeof(i2c_path), "/dev/i2c-%d", bus);
-
-    fp = filp_open(i2c_path, O_RDWR, S_IRUSR | S_IWUSR);
-    if (IS_ERR(fp)) {
-        DBG_DEBUG(DBG_ERROR, "i2c open fail.\n");
+    i2c_adap = dfd_ko_get_i2c_adapter(bus);
+    if (i2c_adap == NULL) {
+        DBG_DEBUG(DBG_ERROR, "get i2c bus[%d] adapter fail\n", bus);
         return -1;
     }
-    memcpy(&client, fp->private_data, sizeof(struct i2c_client));
+    mem_clear(&client, sizeof(struct i2c_client));
+    client.adapter = i2c_adap;
     client.addr = addr;
 
     if (i2c_check_functionality(client.adapter, I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
@@ -91,7 +300,7 @@ static int dfd_ko_i2c_block_read(int bus, int addr, int offset, uint8_t *buf, ui
     }
 
 out:
-    filp_close(fp, NULL);
+    i2c_put_adapter(i2c_adap);
     return rv;
 }
 
@@ -101,7 +310,7 @@ static int32_t dfd_ko_i2c_smbus_transfer(int read_write, int bus, int addr, int
     struct i2c_adapter *i2c_adap;
     union i2c_smbus_data data;
 
-    i2c_adap = i2c_get_adapter(bus);
+    i2c_adap = dfd_ko_get_i2c_adapter(bus);
     if (i2c_adap == NULL) {
         DBG_DEBUG(DBG_ERROR, "get i2c bus[%d] adapter fail\n", bus);
         return -DFD_RV_DEV_FAIL;
@@ -510,21 +719,23 @@ int32_t dfd_ko_read_file(char *fpath, int32_t addr, uint8_t *val, int32_t read_b
         return -DFD_RV_INDEX_INVALID;
     }
 
-    /* Open file */
-    filp = filp_open(fpath, O_RDONLY, 0);
+    /* Open file, or reuse the handle of a previous read */
+    filp = dfd_ko_get_file(fpath);
     if (IS_ERR(filp)) {
         DBG_DEBUG(DBG_ERROR, "open file[%s] fail\n", fpath);
         return -DFD_RV_DEV_FAIL;
     }
-    /* Location file */
+    /* Location file, sysfs attributes are regenerated by a read at a new position */
     pos = addr;
     iov_iter_kvec(&iter, ITER_DEST, &iov, 1, iov.iov_len);
     ret = vfs_iter_read(filp, &iter, &pos, 0);
     if (ret < 0) {
         DBG_DEBUG(DBG_ERROR, "vfs_iter_read failed, path=%s, addr=%d, size=%d, ret=%d\n", fpath, addr, read_bytes, ret);
+        /* The handle may be stale, reopen it on the next read */
+        dfd_ko_drop_file(fpath);
         ret = -DFD_RV_DEV_FAIL;
     }
-    filp_close(filp, NULL);
+    fput(filp);
     return ret;
 }
 
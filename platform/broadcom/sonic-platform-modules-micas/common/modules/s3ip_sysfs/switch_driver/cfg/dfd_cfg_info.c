@@ -21,6 +21,11 @@
 #include <linux/string.h>
 #include <linux/types.h>
 #include <linux/slab.h>
+#include <linux/module.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+#include <linux/jiffies.h>
+#include <linux/math64.h>
 
 #include "wb_module.h"
 #include "dfd_cfg_adapter.h"
@@ -49,6 +54,35 @@ typedef enum cpld_volatge_value_s {
 #define VALID_MAC_TEMP_MIN      (-40)
 #define MAC_TEMP_INVALID        (-99999999)
 
+/* Sensor sampling period in ms, 0: every read goes to the bus */
+int g_dfd_sensor_sample_ms = 1000;
+module_param(g_dfd_sensor_sample_ms, int, S_IRUGO | S_IWUSR);
+/* Number of latest samples min/max/avg are calculated over */
+int g_dfd_sensor_sample_window = 10;
+module_param(g_dfd_sensor_sample_window, int, S_IRUGO | S_IWUSR);
+
+/* A sample older than this many periods is not served, the sampler is considered stuck */
+#define INFO_SENSOR_SAMPLE_STALE_PERIODS    (3)
+
+/* History of one sampled sensor */
+typedef struct info_sensor_sample_s {
+    uint64_t key;
+    info_hwmon_buf_f pfun;
+    int rv;                                     /* Result of the last read */
+    char latest[INFO_BUF_MAX_LEN];              /* Last read, exactly as dfd_info_get_sensor() returned it */
+    int decimals;                               /* Decimal places of the values in ring */
+    s64 ring[INFO_SENSOR_SAMPLE_RING_LEN];      /* Values scaled by 10^decimals */
+    int head;                                   /* Next slot to write */
+    int num;                                    /* Valid samples in ring */
+    unsigned long updated;                      /* Jiffies of the last read, 0: never read */
+} info_sensor_sample_t;
+
+static info_sensor_sample_t *g_info_sensor_sample;
+static int g_info_sensor_sample_num;
+static int g_info_sensor_sample_running;
+static DEFINE_SPINLOCK(g_info_sensor_sample_lock);
+static struct delayed_work g_info_sensor_sample_work;
+
 /* info_ctrl_t member string */
 char *g_info_ctrl_mem_str[INFO_CTRL_MEM_END] = {
     ".mode",
@@ -1008,3 +1042,294 @@ void dfd_info_del_no_print_string(char *buf)
     }
     return;
 }
+
+/* Parse a sensor string such as "-12.345\n", the value is returned scaled by 10^decimals */
+static int dfd_info_sensor_str_to_val(const char *str, s64 *val, int *decimals)
+{
+    const char *p;
+    int neg, digits, dec, in_frac;
+    s64 tmp;
+
+    p = str;
+    while (*p == ' ') {
+        p++;
+    }
+    neg = 0;
+    if (*p == '-') {
+        neg = 1;
+        p++;
+    }
+    tmp = 0;
+    digits = 0;
+    dec = 0;
+    in_frac = 0;
+    for (; *p != '\0'; p++) {
+        if ((*p >= '0') && (*p <= '9')) {
+            /* More digits than an s64 holds are not a sensor value */
+            if (digits >= 18) {
+                return -DFD_RV_TYPE_ERR;
+            }
+            tmp = tmp * 10 + (*p - '0');
+            digits++;
+            if (in_frac) {
+                dec++;
+            }
+        } else if ((*p == '.') && !in_frac) {
+            in_frac = 1;
+        } else {
+            break;
+        }
+    }
+    if (digits == 0) {
+        return -DFD_RV_TYPE_ERR;
+    }
+    *val = neg ? -tmp : tmp;
+    *decimals = dec;
+    return DFD_RV_OK;
+}
+
+static int dfd_info_sensor_val_to_str(s64 val, int decimals, char *buf, int buf_len)
+{
+    s64 abs_val, div_result;
+    s32 div_mod;
+    int i, divisor;
+
+    if (decimals == 0) {
+        return snprintf(buf, buf_len, "%lld\n", val);
+    }
+    divisor = 1;
+    for (i = 0; i < decimals; i++) {
+        divisor *= 10;
+    }
+    abs_val = val < 0 ? -val : val;
+    div_result = div_s64_rem(abs_val, divisor, &div_mod);
+    return snprintf(buf, buf_len, "%s%lld.%0*d\n", val < 0 ? "-" : "", div_result, decimals, div_mod);
+}
+
+static info_sensor_sample_t *dfd_info_sensor_sample_find(uint64_t key)
+{
+    int i;
+
+    for (i = 0; i < g_info_sensor_sample_num; i++) {
+        if (g_info_sensor_sample[i].key == key) {
+            return &g_info_sensor_sample[i];
+        }
+    }
+    return NULL;
+}
+
+static void dfd_info_sensor_sample_one(info_sensor_sample_t *sample)
+{
+    char buf[INFO_BUF_MAX_LEN];
+    s64 val;
+    int rv, decimals, ret;
+
+    /* The bus is read without the lock, readers only ever wait for the copy below */
+    rv = dfd_info_get_sensor(sample->key, buf, sizeof(buf), sample->pfun);
+    ret = -DFD_RV_TYPE_ERR;
+    if (rv >= 0) {
+        ret = dfd_info_sensor_str_to_val(buf, &val, &decimals);
+        if (ret < 0) {
+            DBG_DEBUG(DBG_VERBOSE, "sensor key: 0x%08llx value %s not a number, no history kept\n",
+                sample->key, buf);
+        }
+    }
+
+    spin_lock(&g_info_sensor_sample_lock);
+    sample->rv = rv;
+    sample->updated = jiffies ? jiffies : 1;
+    if (rv >= 0) {
+        memcpy(sample->latest, buf, sizeof(sample->latest));
+    }
+    if (ret == DFD_RV_OK) {
+        if ((sample->num > 0) && (sample->decimals != decimals)) {
+            sample->num = 0;
+        }
+        sample->decimals = decimals;
+        sample->ring[sample->head] = val;
+        sample->head = (sample->head + 1) % INFO_SENSOR_SAMPLE_RING_LEN;
+        if (sample->num < INFO_SENSOR_SAMPLE_RING_LEN) {
+            sample->num++;
+        }
+    }
+    spin_unlock(&g_info_sensor_sample_lock);
+}
+
+static void dfd_info_sensor_sample_work(struct work_struct *work)
+{
+    int i, period;
+
+    period = g_dfd_sensor_sample_ms;
+    if (period > 0) {
+        for (i = 0; i < g_info_sensor_sample_num; i++) {
+            dfd_info_sensor_sample_one(&g_info_sensor_sample[i]);
+        }
+    } else {
+        /* Sampling is switched off, check again later whether it was switched back on */
+        period = 1000;
+    }
+    if (READ_ONCE(g_info_sensor_sample_running)) {
+        schedule_delayed_work(&g_info_sensor_sample_work, msecs_to_jiffies(period));
+    }
+}
+
+/**
+ * dfd_info_sensor_sample_add - Add a sensor to the sampling worker
+ * @key: HWMON Configures the key
+ * @pfun: Data conversion function, the same one the sensor is read with
+ *
+ * Must be called before dfd_info_sensor_sample_start(). Sensors with a
+ * constant value are not sampled, reading them costs no bus access.
+ * @returns: <0 Failed, others succeeded
+ */
+int dfd_info_sensor_sample_add(uint64_t key, info_hwmon_buf_f pfun)
+{
+    info_ctrl_t *info_ctrl;
+    info_sensor_sample_t *sample;
+
+    if (g_info_sensor_sample_running) {
+        DBG_DEBUG(DBG_ERROR, "sensor sampling already started, key: 0x%08llx\n", key);
+        return -DFD_RV_INVALID_VALUE;
+    }
+    info_ctrl = dfd_ko_cfg_get_item(key);
+    if ((info_ctrl == NULL) || (info_ctrl->mode != INFO_CTRL_MODE_CFG)) {
+        return DFD_RV_OK;
+    }
+    if (dfd_info_sensor_sample_find(key) != NULL) {
+        return DFD_RV_OK;
+    }
+    if (g_info_sensor_sample_num >= INFO_SENSOR_SAMPLE_MAX_NUM) {
+        DBG_DEBUG(DBG_WARN, "too many sampled sensors, key: 0x%08llx read on demand\n", key);
+        return -DFD_RV_NO_MEMORY;
+    }
+    if (g_info_sensor_sample == NULL) {
+        g_info_sensor_sample = kcalloc(INFO_SENSOR_SAMPLE_MAX_NUM, sizeof(info_sensor_sample_t),
+                                   GFP_KERNEL);
+        if (g_info_sensor_sample == NULL) {
+            DBG_DEBUG(DBG_ERROR, "kcalloc sensor sample table failed\n");
+            return -DFD_RV_NO_MEMORY;
+        }
+    }
+    sample = &g_info_sensor_sample[g_info_sensor_sample_num];
+    sample->key = key;
+    sample->pfun = pfun;
+    sample->rv = -DFD_RV_NO_NODE;
+    g_info_sensor_sample_num++;
+    DBG_DEBUG(DBG_VERBOSE, "add sampled sensor key: 0x%08llx\n", key);
+    return DFD_RV_OK;
+}
+
+/**
+ * dfd_info_sensor_sample_get - Get a sensor value from the sampling history
+ * @key: HWMON Configures the key
+ * @stat: WB_SENSOR_STAT_LATEST, or min/max/avg over g_dfd_sensor_sample_window samples
+ * @buf: Result storage
+ * @buf_len: buf length
+ *
+ * Never touches the bus. -DFD_RV_NO_NODE is returned when the sensor is not
+ * sampled or the history is stale, callers then read the sensor themselves.
+ * @returns: <0 Failed, others length of buf
+ */
+int dfd_info_sensor_sample_get(uint64_t key, int stat, char *buf, int buf_len)
+{
+    info_sensor_sample_t *sample;
+    unsigned long max_age;
+    s64 val, tmp, sum;
+    int i, idx, num, window, decimals, rv;
+
+    if ((buf == NULL) || (buf_len <= 0)) {
+        return -DFD_RV_INVALID_VALUE;
+    }
+    if (!g_info_sensor_sample_running || (g_dfd_sensor_sample_ms <= 0)) {
+        return -DFD_RV_NO_NODE;
+    }
+    max_age = msecs_to_jiffies(g_dfd_sensor_sample_ms * INFO_SENSOR_SAMPLE_STALE_PERIODS);
+    window = clamp(g_dfd_sensor_sample_window, 1, INFO_SENSOR_SAMPLE_RING_LEN);
+
+    spin_lock(&g_info_sensor_sample_lock);
+    sample = dfd_info_sensor_sample_find(key);
+    if ((sample == NULL) || (sample->updated == 0) ||
+            time_after(jiffies, sample->updated + max_age)) {
+        spin_unlock(&g_info_sensor_sample_lock);
+        return -DFD_RV_NO_NODE;
+    }
+    if (stat == WB_SENSOR_STAT_LATEST) {
+        rv = sample->rv;
+        if (rv >= 0) {
+            rv = snprintf(buf, buf_len, "%s", sample->latest);
+        }
+        spin_unlock(&g_info_sensor_sample_lock);
+        return rv;
+    }
+    num = min(sample->num, window);
+    if (num == 0) {
+        rv = sample->rv < 0 ? sample->rv : -DFD_RV_TYPE_ERR;
+        spin_unlock(&g_info_sensor_sample_lock);
+        return rv;
+    }
+    decimals = sample->decimals;
+    val = 0;
+    sum = 0;
+    for (i = 0; i < num; i++) {
+        idx = (sample->head - 1 - i + INFO_SENSOR_SAMPLE_RING_LEN) % INFO_SENSOR_SAMPLE_RING_LEN;
+        tmp = sample->ring[idx];
+        if (i == 0) {
+            val = tmp;
+        } else if (stat == WB_SENSOR_STAT_MIN) {
+            val = min(val, tmp);
+        } else if (stat == WB_SENSOR_STAT_MAX) {
+            val = max(val, tmp);
+        }
+        sum += tmp;
+    }
+    spin_unlock(&g_info_sensor_sample_lock);
+
+    if (stat == WB_SENSOR_STAT_AVG) {
+        val = div_s64(sum, num);
+    } else if ((stat != WB_SENSOR_STAT_MIN) && (stat != WB_SENSOR_STAT_MAX)) {
+        DBG_DEBUG(DBG_ERROR, "unknown sensor stat: %d\n", stat);
+        return -DFD_RV_INVALID_VALUE;
+    }
+    return dfd_info_sensor_val_to_str(val, decimals, buf, buf_len);
+}
+
+/**
+ * dfd_info_sensor_sample_start - Start the sampling worker
+ *
+ * The first round is taken synchronously so readers are served from the start.
+ * @returns: void
+ */
+void dfd_info_sensor_sample_start(void)
+{
+    if (g_info_sensor_sample_num == 0) {
+        DBG_DEBUG(DBG_VERBOSE, "no sensor to sample\n");
+        return;
+    }
+    INIT_DELAYED_WORK(&g_info_sensor_sample_work, dfd_info_sensor_sample_work);
+    WRITE_ONCE(g_info_sensor_sample_running, 1);
+    dfd_info_sensor_sample_work(&g_info_sensor_sample_work.work);
+    DBG_DEBUG(DBG_VERBOSE, "sensor sampling started, %d sensors, period %dms\n",
+        g_info_sensor_sample_num, g_dfd_sensor_sample_ms);
+}
+
+/**
+ * dfd_info_sensor_sample_stop - Stop the sampling worker and drop the history
+ *
+ * @returns: void
+ */
+void dfd_info_sensor_sample_stop(void)
+{
+    info_sensor_sample_t *sample;
+
+    if (g_info_sensor_sample_running) {
+        WRITE_ONCE(g_info_sensor_sample_running, 0);
+        cancel_delayed_work_sync(&g_info_sensor_sample_work);
+    }
+    /* Readers look the table up under the lock */
+    spin_lock(&g_info_sensor_sample_lock);
+    sample = g_info_sensor_sample;
+    g_info_sensor_sample = NULL;
+    g_info_sensor_sample_num = 0;
+    spin_unlock(&g_info_sensor_sample_lock);
+    kfree(sample);
+}
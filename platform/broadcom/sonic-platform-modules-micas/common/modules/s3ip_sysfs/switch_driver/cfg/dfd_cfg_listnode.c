@@ -20,9 +20,13 @@
 
 #include <linux/list.h>
 #include <linux/slab.h>
+#include <linux/hash.h>
 
 #include "dfd_cfg_listnode.h"
 
+/* hash_min() would truncate the 64-bit key on 32-bit hosts */
+#define LNODE_BUCKET(root, key)    (&(root)->htable[hash_64((key), LNODE_HASH_BITS)])
+
 /**
  * Find node
  * @root: Root node pointer
@@ -38,8 +42,8 @@ void *lnode_find_node(lnode_root_t *root, uint64_t key)
         return NULL;
     }
 
-    /* Traversal query */
-    list_for_each_entry(lnode, &(root->root), lst) {
+    /* Only the nodes of the key's bucket are compared */
+    hlist_for_each_entry(lnode, LNODE_BUCKET(root, key), hnode) {
         if (lnode->key == key) {
             return lnode->data;
         }
@@ -81,6 +85,8 @@ int lnode_insert_node(lnode_root_t *root, uint64_t key, void *data)
     lnode->key = key;
     lnode->data = data;
     list_add_tail(&(lnode->lst), &(root->root));
+    hlist_add_head(&(lnode->hnode), LNODE_BUCKET(root, key));
+    root->count++;
 
     return LNODE_RV_OK;
 }
@@ -98,6 +104,8 @@ int lnode_init_root(lnode_root_t *root)
     }
 
     INIT_LIST_HEAD(&(root->root));
+    hash_init(root->htable);
+    root->count = 0;
 
     return LNODE_RV_OK;
 }
@@ -124,9 +132,11 @@ void lnode_free_list(lnode_root_t *root)
             lnode->key = 0;
         }
         list_del(&lnode->lst);
+        hlist_del(&lnode->hnode);
         kfree(lnode);
         lnode = NULL;
     }
+    root->count = 0;
 
     return;
 
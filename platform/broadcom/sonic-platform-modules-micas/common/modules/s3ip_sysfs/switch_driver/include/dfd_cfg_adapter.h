@@ -35,6 +35,10 @@
 #define DFD_KO_OTHER_I2C_GET_OFFSET(addr)      (addr & 0xffff)
 #define DFD_SYSFS_PATH_MAX_LEN                 (64)
 
+#define DFD_KO_I2C_BUS_MAX                     (1024)   /* Buses with a cached adapter */
+#define DFD_KO_FILE_CACHE_BITS                 (6)
+#define DFD_KO_FILE_CACHE_MAX                  (512)    /* Files with a cached handle */
+
 typedef struct dfd_i2c_dev_s {
     int bus;        /* bus number */
     int addr;       /* Bus address */
@@ -61,6 +65,18 @@ typedef enum i2c_mode_e {
 /* Global variable */
 extern char *g_dfd_i2c_dev_mem_str[DFD_I2C_DEV_MEM_END];      /* dfd_i2c_dev_t member string */
 
+/**
+ * dfd_ko_adapter_init - Set up the i2c adapter and file handle caches
+ *
+ * @returns: <0 Failed, others succeeded
+ */
+int dfd_ko_adapter_init(void);
+
+/**
+ * dfd_ko_adapter_exit - Release all the cached i2c adapters and files
+ */
+void dfd_ko_adapter_exit(void);
+
 /**
  * dfd_ko_cpld_read - cpld read operation
  * @addr: Offset address
@@ -145,6 +145,10 @@ typedef enum sensor_format_mem_s {
     MAC_TH6  = 6,
 } sensor_format_mem_t;
 
+/* Sensor sampling history */
+#define INFO_SENSOR_SAMPLE_RING_LEN     (64)    /* Samples kept per sensor */
+#define INFO_SENSOR_SAMPLE_MAX_NUM      (256)   /* Sensors that can be sampled */
+
 /* hwmon data format conversion */
 typedef int (*info_hwmon_buf_f)(uint8_t *buf, int buf_len, uint8_t *buf_new, int *buf_len_new,
                 info_ctrl_t *info_ctrl, int coefficient, int addend);
@@ -202,4 +206,38 @@ int dfd_info_get_sensor(uint64_t key, char *buf, int buf_len, info_hwmon_buf_f p
  *
  */
 void dfd_info_del_no_print_string(char *buf);
+
+/**
+ * dfd_info_sensor_sample_add - Add a sensor to the sampling worker
+ * @key: HWMON Configures the key
+ * @pfun: Data conversion function, the same one the sensor is read with
+ *
+ * @returns: <0 Failed, others succeeded
+ */
+int dfd_info_sensor_sample_add(uint64_t key, info_hwmon_buf_f pfun);
+
+/**
+ * dfd_info_sensor_sample_get - Get a sensor value from the sampling history
+ * @key: HWMON Configures the key
+ * @stat: Value to get, see wb_sensor_stat_t
+ * @buf: Result storage
+ * @buf_len: buf length
+ *
+ * @returns: <0 Failed, others length of buf
+ */
+int dfd_info_sensor_sample_get(uint64_t key, int stat, char *buf, int buf_len);
+
+/**
+ * dfd_info_sensor_sample_start - Start the sampling worker
+ *
+ * @returns: void
+ */
+void dfd_info_sensor_sample_start(void);
+
+/**
+ * dfd_info_sensor_sample_stop - Stop the sampling worker and drop the history
+ *
+ * @returns: void
+ */
+void dfd_info_sensor_sample_stop(void);
 #endif /* __DFD_CFG_INFO_H__ */
@@ -22,6 +22,7 @@
 #define __DFD_CFG_LISTNODE_H__
 
 #include <linux/list.h>
+#include <linux/hashtable.h>
 
 /* Returned value */
 #define LNODE_RV_OK             (0)
@@ -29,14 +30,20 @@
 #define LNODE_RV_NODE_EXIST     (-2)    /* Node already exists */
 #define LNODE_RV_NOMEM          (-3)    /* Node already exists */
 
+/* Number of hash buckets is 1 << LNODE_HASH_BITS */
+#define LNODE_HASH_BITS         (10)
+
 /* Root node public structure */
 typedef struct lnode_root_s {
-    struct list_head root;
+    struct list_head root;      /* All nodes, in insertion order */
+    DECLARE_HASHTABLE(htable, LNODE_HASH_BITS);     /* The same nodes, hashed by key */
+    int count;                  /* Number of nodes */
 } lnode_root_t;
 
 /* Node structure */
 typedef struct lnode_node_s {
     struct list_head lst;
+    struct hlist_node hnode;
 
     uint64_t key;               /* Node search index value */
     void *data;                 /* The actual data pointer */
@@ -31,6 +31,8 @@ struct switch_drivers_s {
     ssize_t (*get_main_board_temp_min)(unsigned int temp_index, char *buf, size_t count);
     int (*set_main_board_temp_min)(unsigned int temp_index, const char *buf, size_t count);
     ssize_t (*get_main_board_temp_value)(unsigned int temp_index, char *buf, size_t count);
+    ssize_t (*get_main_board_temp_value_stat)(unsigned int temp_index, unsigned int stat, char *buf,
+        size_t count);
     ssize_t (*get_main_board_temp_high)(unsigned int temp_index, char *buf, size_t count);
     ssize_t (*get_main_board_temp_low)(unsigned int temp_index, char *buf, size_t count);
     ssize_t (*get_main_board_temp_monitor_flag)(unsigned int temp_index, char *buf, size_t count);
@@ -45,6 +47,8 @@ struct switch_drivers_s {
     ssize_t (*get_main_board_vol_range)(unsigned int vol_index, char *buf, size_t count);
     ssize_t (*get_main_board_vol_nominal_value)(unsigned int vol_index, char *buf, size_t count);
     ssize_t (*get_main_board_vol_value)(unsigned int vol_index, char *buf, size_t count);
+    ssize_t (*get_main_board_vol_value_stat)(unsigned int vol_index, unsigned int stat, char *buf,
+        size_t count);
     ssize_t (*get_main_board_vol_monitor_flag)(unsigned int vol_index, char *buf, size_t count);
     /* current sensors */
     int (*get_main_board_curr_number)(void);
@@ -55,6 +59,8 @@ struct switch_drivers_s {
     ssize_t (*get_main_board_curr_min)(unsigned int curr_index, char *buf, size_t count);
     int (*set_main_board_curr_min)(unsigned int curr_index, const char *buf, size_t count);
     ssize_t (*get_main_board_curr_value)(unsigned int curr_index, char *buf, size_t count);
+    ssize_t (*get_main_board_curr_value_stat)(unsigned int curr_index, unsigned int stat, char *buf,
+        size_t count);
     ssize_t (*get_main_board_curr_monitor_flag)(unsigned int curr_index, char *buf, size_t count);
     /* syseeprom */
     int (*get_syseeprom_size)(void);
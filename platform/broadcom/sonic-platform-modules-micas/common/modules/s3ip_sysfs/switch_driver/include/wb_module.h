@@ -158,6 +158,14 @@ typedef enum wb_sensor_type_e {
     WB_SENSOR_LOW         = 10,    /* Sensor low */
 } wb_sensor_type_t;
 
+/* Sensor value statistics, over the sampling window */
+typedef enum wb_sensor_stat_e {
+    WB_SENSOR_STAT_LATEST = 0,     /* Last sampled value */
+    WB_SENSOR_STAT_MIN    = 1,     /* Minimum in window */
+    WB_SENSOR_STAT_MAX    = 2,     /* Maximum in window */
+    WB_SENSOR_STAT_AVG    = 3,     /* Average in window */
+} wb_sensor_stat_t;
+
 /* sff cpld attribute type */
 typedef enum wb_sff_cpld_attr_e {
     WB_SFF_POWER_ON      = 0x01,
@@ -169,6 +177,7 @@ typedef enum wb_sff_cpld_attr_e {
     WB_SFF_LPMODE,
     WB_SFF_MODULE_PRESENT,
     WB_SFF_INTERRUPT,
+    WB_SFF_CPLD_ATTR_MAX,
 } wb_sff_cpld_attr_t;
 
 /* LED attribute type */
@@ -79,4 +79,27 @@ ssize_t dfd_get_psu_sensor_info(uint8_t psu_index, uint8_t sensor_type, char *bu
  */
 int dfd_get_main_board_monitor_flag(uint8_t main_dev_id, uint8_t dev_index, uint8_t sensor_type,
         uint8_t sensor_index, char *buf, size_t count);
+
+/**
+ * dfd_get_sensor_stat_info - Get the sampled value statistics of a sensor
+ * @main_dev_id: Motherboard :0 Power supply :2 subcard :5
+ * @dev_index: If no device index exists, the value is 0, and 1 indicates slot1
+ * @sensor_type: WB_MINOR_DEV_TEMP/WB_MINOR_DEV_IN/WB_MINOR_DEV_CURR
+ * @sensor_index: Sensor index, starting at 1
+ * @stat: min/max/avg, see wb_sensor_stat_t
+ * return: Success: Returns the length of buf
+ *       : Failed: A negative value is returned
+ */
+ssize_t dfd_get_sensor_stat_info(uint8_t main_dev_id, uint8_t dev_index, uint8_t sensor_type,
+            uint8_t sensor_index, int stat, char *buf, size_t count);
+
+/**
+ * dfd_sensor_sample_init - Start sampling the main board temperature, voltage and current sensors
+ */
+void dfd_sensor_sample_init(void);
+
+/**
+ * dfd_sensor_sample_exit - Stop sampling the sensors
+ */
+void dfd_sensor_sample_exit(void);
 #endif /* _WB_SENSORS_DRIVER_H_ */
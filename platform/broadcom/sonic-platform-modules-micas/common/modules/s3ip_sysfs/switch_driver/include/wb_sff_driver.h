@@ -42,6 +42,21 @@ int dfd_set_sff_cpld_info(unsigned int sff_index, int cpld_reg_type, int value);
  */
 ssize_t dfd_get_sff_cpld_info(unsigned int sff_index, int cpld_reg_type, char *buf, size_t count);
 
+/**
+ * dfd_get_sff_cpld_info_all - Obtain the CPLD register status of all optical modules
+ * @cpld_reg_type: Optical module CPLD register type
+ * @buf: Receives one digit per module, in module order, followed by '\n'
+ * @count: buf length
+ * return: Success: Returns the length of fill buf
+ *       : Failed: A negative value is returned
+ */
+ssize_t dfd_get_sff_cpld_info_all(int cpld_reg_type, char *buf, size_t count);
+
+/**
+ * dfd_sff_status_exit - Free the sff status read plans
+ */
+void dfd_sff_status_exit(void);
+
 /**
  * dfd_get_single_eth_optoe_type - get sff optoe type
  * @sff_index: Optical module number, starting from 1
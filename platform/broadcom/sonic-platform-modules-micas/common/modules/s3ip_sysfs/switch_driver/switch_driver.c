@@ -261,6 +261,35 @@ static ssize_t dfd_get_main_board_temp_value(unsigned int temp_index, char *buf,
     return ret;
 }
 
+/*
+ * dfd_get_main_board_temp_value_stat - Used to get the min/max/avg input value of temperature sensor
+ * over the sampling window, filled the value to buf, the value is integer with millidegree Celsius
+ * @temp_index: start with 1
+ * @stat: WB_SENSOR_STAT_MIN/WB_SENSOR_STAT_MAX/WB_SENSOR_STAT_AVG
+ * @buf: Data receiving buffer
+ * @count: length of buf
+ *
+ * This function returns the length of the filled buffer,
+ * if the sensor is not sampled filled "NA" to buf,
+ * otherwise it returns a negative value on failed.
+ */
+static ssize_t dfd_get_main_board_temp_value_stat(unsigned int temp_index, unsigned int stat, char *buf,
+                   size_t count)
+{
+    ssize_t ret;
+
+    ret = dfd_get_sensor_stat_info(WB_MAIN_DEV_MAINBOARD, WB_MINOR_DEV_NONE, WB_MINOR_DEV_TEMP, temp_index, stat,
+              buf, count);
+    if (ret < 0) {
+        if (ret == -DFD_RV_DEV_NOTSUPPORT) {
+            return (ssize_t)snprintf(buf, count, "%s\n", SWITCH_DEV_NO_SUPPORT);
+        } else {
+            return (ssize_t)snprintf(buf, count, "%s\n", SWITCH_DEV_ERROR);
+        }
+    }
+    return ret;
+}
+
 /*
  * dfd_get_main_board_temp_monitor_flag - Used to get monitor flag of temperature sensor
  * filled the value to buf, the value is integer
@@ -484,6 +513,35 @@ static ssize_t dfd_get_main_board_vol_value(unsigned int vol_index, char *buf, s
     return ret;
 }
 
+/*
+ * dfd_get_main_board_vol_value_stat - Used to get the min/max/avg input value of voltage sensor
+ * over the sampling window, filled the value to buf, the value is integer with mV
+ * @vol_index: start with 1
+ * @stat: WB_SENSOR_STAT_MIN/WB_SENSOR_STAT_MAX/WB_SENSOR_STAT_AVG
+ * @buf: Data receiving buffer
+ * @count: length of buf
+ *
+ * This function returns the length of the filled buffer,
+ * if the sensor is not sampled filled "NA" to buf,
+ * otherwise it returns a negative value on failed.
+ */
+static ssize_t dfd_get_main_board_vol_value_stat(unsigned int vol_index, unsigned int stat, char *buf,
+                   size_t count)
+{
+    ssize_t ret;
+
+    ret = dfd_get_sensor_stat_info(WB_MAIN_DEV_MAINBOARD, WB_MINOR_DEV_NONE, WB_MINOR_DEV_IN, vol_index, stat,
+              buf, count);
+    if (ret < 0) {
+        if (ret == -DFD_RV_DEV_NOTSUPPORT) {
+            return (ssize_t)snprintf(buf, count, "%s\n", SWITCH_DEV_NO_SUPPORT);
+        } else {
+            return (ssize_t)snprintf(buf, count, "%s\n", SWITCH_DEV_ERROR);
+        }
+    }
+    return ret;
+}
+
 /*
  * dfd_get_main_board_vol_monitor_flag - Used to get monitor flag of voltage sensor
  * filled the value to buf, the value is integer
@@ -651,6 +709,35 @@ static ssize_t dfd_get_main_board_curr_value(unsigned int curr_index, char *buf,
     return ret;
 }
 
+/*
+ * dfd_get_main_board_curr_value_stat - Used to get the min/max/avg input value of current sensor
+ * over the sampling window, filled the value to buf, the value is integer with mA
+ * @curr_index: start with 1
+ * @stat: WB_SENSOR_STAT_MIN/WB_SENSOR_STAT_MAX/WB_SENSOR_STAT_AVG
+ * @buf: Data receiving buffer
+ * @count: length of buf
+ *
+ * This function returns the length of the filled buffer,
+ * if the sensor is not sampled filled "NA" to buf,
+ * otherwise it returns a negative value on failed.
+ */
+static ssize_t dfd_get_main_board_curr_value_stat(unsigned int curr_index, unsigned int stat, char *buf,
+                   size_t count)
+{
+    ssize_t ret;
+
+    ret = dfd_get_sensor_stat_info(WB_MAIN_DEV_MAINBOARD, WB_MINOR_DEV_NONE, WB_MINOR_DEV_CURR, curr_index, stat,
+              buf, count);
+    if (ret < 0) {
+        if (ret == -DFD_RV_DEV_NOTSUPPORT) {
+            return (ssize_t)snprintf(buf, count, "%s\n", SWITCH_DEV_NO_SUPPORT);
+        } else {
+            return (ssize_t)snprintf(buf, count, "%s\n", SWITCH_DEV_ERROR);
+        }
+    }
+    return ret;
+}
+
 /*
  * dfd_get_main_board_curr_monitor_flag - Used to get monitor flag of current sensor
  * filled the value to buf, the value is integer
@@ -2430,37 +2517,11 @@ static int dfd_set_transceiver_power_on_status(int status)
 static ssize_t dfd_get_transceiver_present_status(char *buf, size_t count)
 {
     ssize_t ret;
-    unsigned int eth_index, eth_num;
-    int len, left_len;
-
-    eth_num = dfd_get_dev_number(WB_MAIN_DEV_SFF, WB_MINOR_DEV_NONE);
-    if (eth_num <= 0) {
-        return (ssize_t)snprintf(buf, count, "%s\n", SWITCH_DEV_ERROR);
-    }
-
-    mem_clear(buf, count);
-    len = 0;
-    left_len = count - 1;
-
-    for (eth_index = 1; eth_index <= eth_num; eth_index++) {
-        SWITCH_DEBUG(DBG_VERBOSE, "eth index: %u\n", eth_index);
-        if (left_len > 0) {
-            ret = dfd_get_sff_cpld_info(eth_index, WB_SFF_MODULE_PRESENT, buf + len, left_len);
-            if (ret < 0) {
-                SWITCH_DEBUG(DBG_ERROR, "get eth%u present status failed, ret: %ld\n", eth_index, ret);
-                break;
-            }
-        } else {
-            SWITCH_DEBUG(DBG_ERROR, "error: get_transceiver_present_status are not enough buffers.\n");
-            ret = -DFD_RV_NO_MEMORY;
-            break;
-        }
-        dfd_ko_cfg_del_lf_cr(buf);  /* del '\n' */
-        len = strlen(buf);
-        left_len = count - len - 2; /* Reserve end to add '\n' and '\0' */
-    }
 
+    /* All ports are taken from one sweep of the cpld present registers */
+    ret = dfd_get_sff_cpld_info_all(WB_SFF_MODULE_PRESENT, buf, count);
     if (ret < 0) {
+        SWITCH_DEBUG(DBG_ERROR, "get transceiver present status failed, ret: %ld\n", ret);
         mem_clear(buf, count);
         if (ret == -DFD_RV_DEV_NOTSUPPORT) {
             return (ssize_t)snprintf(buf, count, "%s\n", SWITCH_DEV_NO_SUPPORT);
@@ -2468,16 +2529,7 @@ static ssize_t dfd_get_transceiver_present_status(char *buf, size_t count)
             return (ssize_t)snprintf(buf, count, "%s\n", SWITCH_DEV_ERROR);
         }
     }
-
-    len = strlen(buf);
-    if (len >= count) {
-        SWITCH_DEBUG(DBG_ERROR, "error: get_transceiver_present_status buffers too long, need: %ld, act: %d.\n", count, len);
-        mem_clear(buf, count);
-        return (ssize_t)snprintf(buf, count, "%s\n", SWITCH_DEV_ERROR);
-    }
-    buf[len] = '\n';
-    ret = strlen(buf);
-    SWITCH_DEBUG(DBG_VERBOSE, "get_transceiver_present_status ok. sff num:%d, len:%ld\n", eth_num, ret);
+    SWITCH_DEBUG(DBG_VERBOSE, "get_transceiver_present_status ok. len:%ld\n", ret);
 
     return ret;
 }
@@ -4369,6 +4421,7 @@ static struct switch_drivers_s switch_drivers = {
     .get_main_board_temp_max = dfd_get_main_board_temp_max,
     .get_main_board_temp_min = dfd_get_main_board_temp_min,
     .get_main_board_temp_value = dfd_get_main_board_temp_value,
+    .get_main_board_temp_value_stat = dfd_get_main_board_temp_value_stat,
     .get_main_board_temp_high = dfd_get_main_board_temp_high,
     .get_main_board_temp_low = dfd_get_main_board_temp_low,
     .get_main_board_temp_monitor_flag = dfd_get_main_board_temp_monitor_flag,
@@ -4381,6 +4434,7 @@ static struct switch_drivers_s switch_drivers = {
     .get_main_board_vol_range = dfd_get_main_board_vol_range,
     .get_main_board_vol_nominal_value = dfd_get_main_board_vol_nominal_value,
     .get_main_board_vol_value = dfd_get_main_board_vol_value,
+    .get_main_board_vol_value_stat = dfd_get_main_board_vol_value_stat,
     .get_main_board_vol_monitor_flag = dfd_get_main_board_vol_monitor_flag,
     /* current sensors */
     .get_main_board_curr_number = dfd_get_main_board_curr_number,
@@ -4389,6 +4443,7 @@ static struct switch_drivers_s switch_drivers = {
     .get_main_board_curr_max = dfd_get_main_board_curr_max,
     .get_main_board_curr_min = dfd_get_main_board_curr_min,
     .get_main_board_curr_value = dfd_get_main_board_curr_value,
+    .get_main_board_curr_value_stat = dfd_get_main_board_curr_value_stat,
     .get_main_board_curr_monitor_flag = dfd_get_main_board_curr_monitor_flag,
     /* syseeprom */
     .get_syseeprom_size = dfd_get_syseeprom_size,
@@ -22,6 +22,8 @@
 
 #include "wb_module.h"
 #include "dfd_cfg.h"
+#include "wb_sff_driver.h"
+#include "wb_sensors_driver.h"
 
 int g_dfd_dbg_level = 0;   /* Debug level */
 module_param(g_dfd_dbg_level, int, S_IRUGO | S_IWUSR);
@@ -33,7 +35,14 @@ module_param(g_dfd_dbg_level, int, S_IRUGO | S_IWUSR);
  */
 int32_t wb_dev_cfg_init(void)
 {
-    return dfd_dev_cfg_init();
+    int32_t ret;
+
+    ret = dfd_dev_cfg_init();
+    if (ret < 0) {
+        return ret;
+    }
+    dfd_sensor_sample_init();
+    return ret;
 }
 
 /**
@@ -44,6 +53,9 @@ int32_t wb_dev_cfg_init(void)
 
 void wb_dev_cfg_exit(void)
 {
+    /* The sensor samples and sff read plans point into the configuration items */
+    dfd_sensor_sample_exit();
+    dfd_sff_status_exit();
     dfd_dev_cfg_exit();
     return;
 }
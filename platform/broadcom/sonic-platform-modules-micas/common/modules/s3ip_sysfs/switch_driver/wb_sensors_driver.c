@@ -114,36 +114,132 @@ static int dfd_deal_hwmon_buf(uint8_t *buf, int buf_len, uint8_t *buf_new, int *
     return DFD_RV_OK;
 }
 
-static int dfd_get_sensor_info(uint8_t main_dev_id, uint8_t dev_index, uint8_t sensor_type,
-               uint8_t sensor_index, uint8_t sensor_attr, char *buf, size_t count)
+static int dfd_get_sensor_key(uint8_t main_dev_id, uint8_t dev_index, uint8_t sensor_type,
+               uint8_t sensor_index, uint8_t sensor_attr, uint64_t *key)
 {
-    uint64_t key;
     uint16_t key_index1;
     uint8_t key_index2;
-    int rv;
-    info_hwmon_buf_f pfunc;
 
     key_index1 = DFD_GET_TEMP_SENSOR_KEY1(dev_index, sensor_index);
     key_index2 = DFD_GET_TEMP_SENSOR_KEY2(main_dev_id, sensor_attr);
     if (sensor_type == WB_MINOR_DEV_TEMP) {
-        key = DFD_CFG_KEY(DFD_CFG_ITEM_HWMON_TEMP, key_index1, key_index2);
+        *key = DFD_CFG_KEY(DFD_CFG_ITEM_HWMON_TEMP, key_index1, key_index2);
     } else if (sensor_type == WB_MINOR_DEV_IN) {
-        key = DFD_CFG_KEY(DFD_CFG_ITEM_HWMON_IN, key_index1, key_index2);
+        *key = DFD_CFG_KEY(DFD_CFG_ITEM_HWMON_IN, key_index1, key_index2);
     } else if (sensor_type == WB_MINOR_DEV_CURR) {
-        key = DFD_CFG_KEY(DFD_CFG_ITEM_HWMON_CURR, key_index1, key_index2);
+        *key = DFD_CFG_KEY(DFD_CFG_ITEM_HWMON_CURR, key_index1, key_index2);
     } else {
         DFD_SENSOR_DEBUG(DBG_ERROR, "Unknow sensor type: %u\n",sensor_type);
         return -DFD_RV_INVALID_VALUE;
     }
+    return DFD_RV_OK;
+}
+
+static int dfd_get_sensor_info(uint8_t main_dev_id, uint8_t dev_index, uint8_t sensor_type,
+               uint8_t sensor_index, uint8_t sensor_attr, char *buf, size_t count)
+{
+    uint64_t key;
+    int rv;
+    info_hwmon_buf_f pfunc;
+
+    rv = dfd_get_sensor_key(main_dev_id, dev_index, sensor_type, sensor_index, sensor_attr, &key);
+    if (rv < 0) {
+        return rv;
+    }
 
     DFD_SENSOR_DEBUG(DBG_VERBOSE, "main_dev_id: %u, dev_index: 0x%x, sensor_index: 0x%x, \
         sensor_attr: 0x%x, key: 0x%08llx\n", main_dev_id, dev_index, sensor_index, sensor_attr, key);
 
+    /* Sampled sensor values are served from the history, no bus access */
+    if (sensor_attr == WB_SENSOR_INPUT) {
+        rv = dfd_info_sensor_sample_get(key, WB_SENSOR_STAT_LATEST, buf, count);
+        if (rv >= 0) {
+            return rv;
+        }
+    }
+
     pfunc = dfd_deal_hwmon_buf;
     rv = dfd_info_get_sensor(key, buf, count, pfunc);
     return rv;
 }
 
+/**
+ * dfd_get_sensor_stat_info - Get the sampled value statistics of a sensor
+ * @main_dev_id: Motherboard :0 Power supply :2 subcard :5
+ * @dev_index: If no device index exists, the value is 0, and 1 indicates slot1
+ * @sensor_type: WB_MINOR_DEV_TEMP/WB_MINOR_DEV_IN/WB_MINOR_DEV_CURR
+ * @sensor_index: Sensor index, starting at 1
+ * @stat: min/max/avg, see wb_sensor_stat_t
+ * return: Success: Returns the length of buf
+ *       : Failed: A negative value is returned
+ */
+ssize_t dfd_get_sensor_stat_info(uint8_t main_dev_id, uint8_t dev_index, uint8_t sensor_type,
+            uint8_t sensor_index, int stat, char *buf, size_t count)
+{
+    uint64_t key;
+    int rv;
+
+    if (buf == NULL) {
+        DFD_SENSOR_DEBUG(DBG_ERROR, "param error, buf is NULL\n");
+        return -DFD_RV_INVALID_VALUE;
+    }
+    if (count <= 0) {
+        DFD_SENSOR_DEBUG(DBG_ERROR, "buf size error, count: %lu\n", count);
+        return -DFD_RV_INVALID_VALUE;
+    }
+
+    rv = dfd_get_sensor_key(main_dev_id, dev_index, sensor_type, sensor_index, WB_SENSOR_INPUT, &key);
+    if (rv < 0) {
+        return rv;
+    }
+    mem_clear(buf, count);
+    rv = dfd_info_sensor_sample_get(key, stat, buf, count);
+    if (rv == -DFD_RV_NO_NODE) {
+        /* Not sampled, there is no history to take statistics from */
+        return -DFD_RV_DEV_NOTSUPPORT;
+    }
+    if (rv < 0) {
+        DFD_SENSOR_DEBUG(DBG_ERROR, "get sensor stat %d error, key: 0x%08llx, rv: %d\n", stat, key, rv);
+    } else {
+        DFD_SENSOR_DEBUG(DBG_VERBOSE, "get sensor stat %d success, value: %s\n", stat, buf);
+    }
+    return rv;
+}
+
+/**
+ * dfd_sensor_sample_init - Start sampling the main board temperature, voltage and current sensors
+ * return: void, sensors that can't be sampled keep being read on demand
+ */
+void dfd_sensor_sample_init(void)
+{
+    static const uint8_t sensor_types[] = {WB_MINOR_DEV_TEMP, WB_MINOR_DEV_IN, WB_MINOR_DEV_CURR};
+    uint64_t key;
+    int i, sensor_index, sensor_num;
+
+    for (i = 0; i < ARRAY_SIZE(sensor_types); i++) {
+        sensor_num = dfd_get_dev_number(WB_MAIN_DEV_MAINBOARD, sensor_types[i]);
+        for (sensor_index = 1; sensor_index <= sensor_num; sensor_index++) {
+            if (dfd_get_sensor_key(WB_MAIN_DEV_MAINBOARD, WB_MINOR_DEV_NONE, sensor_types[i],
+                    sensor_index, WB_SENSOR_INPUT, &key) < 0) {
+                continue;
+            }
+            if (dfd_info_sensor_sample_add(key, dfd_deal_hwmon_buf) < 0) {
+                DFD_SENSOR_DEBUG(DBG_WARN, "sensor type %u index %d not sampled\n",
+                    sensor_types[i], sensor_index);
+            }
+        }
+    }
+    dfd_info_sensor_sample_start();
+}
+
+/**
+ * dfd_sensor_sample_exit - Stop sampling the sensors
+ */
+void dfd_sensor_sample_exit(void)
+{
+    dfd_info_sensor_sample_stop();
+}
+
 /**
  * dfd_get_temp_info - Get temperature information
  * @main_dev_id: Motherboard :0 Power supply :2 subcard :5
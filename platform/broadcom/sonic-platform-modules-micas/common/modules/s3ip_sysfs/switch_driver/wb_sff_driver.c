@@ -19,15 +19,233 @@
  */
 
 #include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/mutex.h>
+#include <linux/jiffies.h>
 
 #include "wb_module.h"
 #include "dfd_cfg.h"
 #include "dfd_cfg_info.h"
 #include "dfd_cfg_adapter.h"
+#include "wb_sff_driver.h"
 
 int g_dfd_sff_dbg_level = 0;
 module_param(g_dfd_sff_dbg_level, int, S_IRUGO | S_IWUSR);
 
+/* How long a status sweep of the sff cpld registers is served from cache, 0: no caching */
+int g_dfd_sff_status_cache_ms = 100;
+module_param(g_dfd_sff_status_cache_ms, int, S_IRUGO | S_IWUSR);
+
+/*
+ * Read plan of one sff cpld register type. The single bit status of many ports lives
+ * in a few cpld bytes, so the distinct byte addresses are collected once and every
+ * port only records which byte it takes its bits from. A sweep then costs one cpld
+ * access per byte instead of one per port.
+ */
+typedef struct dfd_sff_status_plan_s {
+    int built;
+    int sff_num;
+    int *port_reg;              /* Index into reg_addr/reg_val, -1: read through dfd_info_get_int */
+    info_ctrl_t **port_ctrl;
+    int reg_num;
+    int32_t *reg_addr;
+    uint8_t *reg_val;
+    int reg_rv;                 /* Result of the last sweep */
+    unsigned long last_updated; /* In jiffies */
+    int valid;
+} dfd_sff_status_plan_t;
+
+static dfd_sff_status_plan_t g_dfd_sff_status_plan[WB_SFF_CPLD_ATTR_MAX];
+static DEFINE_MUTEX(g_dfd_sff_status_lock);
+
+static int dfd_sff_status_plan_build(dfd_sff_status_plan_t *plan, int cpld_reg_type)
+{
+    uint64_t key;
+    info_ctrl_t *info_ctrl;
+    int sff_num, port, i;
+
+    sff_num = dfd_get_dev_number(WB_MAIN_DEV_SFF, WB_MINOR_DEV_NONE);
+    if (sff_num <= 0) {
+        DFD_SFF_DEBUG(DBG_ERROR, "get sff number error, ret: %d\n", sff_num);
+        return -DFD_RV_DEV_FAIL;
+    }
+
+    plan->port_reg = kcalloc(sff_num + 1, sizeof(int), GFP_KERNEL);
+    plan->port_ctrl = kcalloc(sff_num + 1, sizeof(info_ctrl_t *), GFP_KERNEL);
+    plan->reg_addr = kcalloc(sff_num + 1, sizeof(int32_t), GFP_KERNEL);
+    plan->reg_val = kcalloc(sff_num + 1, sizeof(uint8_t), GFP_KERNEL);
+    if (!plan->port_reg || !plan->port_ctrl || !plan->reg_addr || !plan->reg_val) {
+        kfree(plan->port_reg);
+        kfree(plan->port_ctrl);
+        kfree(plan->reg_addr);
+        kfree(plan->reg_val);
+        mem_clear(plan, sizeof(*plan));
+        return -DFD_RV_NO_MEMORY;
+    }
+
+    plan->sff_num = sff_num;
+    plan->reg_num = 0;
+    for (port = 1; port <= sff_num; port++) {
+        plan->port_reg[port] = -1;
+        key = DFD_CFG_KEY(DFD_CFG_ITEM_SFF_CPLD_REG, port, cpld_reg_type);
+        info_ctrl = dfd_ko_cfg_get_item(key);
+        /* Only single cpld bits can be coalesced, anything else keeps the generic path */
+        if ((info_ctrl == NULL) || (info_ctrl->mode != INFO_CTRL_MODE_CFG) ||
+                (info_ctrl->src != INFO_SRC_CPLD) || !IS_INFO_FRMT_BIT(info_ctrl->frmt) ||
+                !INFO_BIT_OFFSET_VALID(info_ctrl->bit_offset)) {
+            continue;
+        }
+        for (i = 0; i < plan->reg_num; i++) {
+            if (plan->reg_addr[i] == info_ctrl->addr) {
+                break;
+            }
+        }
+        if (i == plan->reg_num) {
+            plan->reg_addr[plan->reg_num++] = info_ctrl->addr;
+        }
+        plan->port_reg[port] = i;
+        plan->port_ctrl[port] = info_ctrl;
+    }
+    plan->built = 1;
+    DFD_SFF_DEBUG(DBG_VERBOSE, "sff cpld reg type %d: %d ports in %d cpld registers\n",
+        cpld_reg_type, sff_num, plan->reg_num);
+
+    return DFD_RV_OK;
+}
+
+/* Called with g_dfd_sff_status_lock held */
+static int dfd_sff_status_sweep(dfd_sff_status_plan_t *plan, int cpld_reg_type)
+{
+    int i, rv;
+
+    if (!plan->built) {
+        rv = dfd_sff_status_plan_build(plan, cpld_reg_type);
+        if (rv < 0) {
+            return rv;
+        }
+    }
+
+    if (plan->valid && (g_dfd_sff_status_cache_ms > 0) &&
+            time_before(jiffies, plan->last_updated + msecs_to_jiffies(g_dfd_sff_status_cache_ms))) {
+        return plan->reg_rv;
+    }
+
+    plan->reg_rv = DFD_RV_OK;
+    for (i = 0; i < plan->reg_num; i++) {
+        rv = dfd_ko_cpld_read(plan->reg_addr[i], &plan->reg_val[i]);
+        if (rv < 0) {
+            DFD_SFF_DEBUG(DBG_ERROR, "read sff cpld reg type %d addr 0x%x fail, rv: %d\n",
+                cpld_reg_type, plan->reg_addr[i], rv);
+            plan->reg_rv = rv;
+            break;
+        }
+    }
+    plan->last_updated = jiffies;
+    plan->valid = 1;
+
+    return plan->reg_rv;
+}
+
+/* Called with g_dfd_sff_status_lock held, after a successful sweep */
+static int dfd_sff_status_port_value(dfd_sff_status_plan_t *plan, unsigned int sff_index,
+               int cpld_reg_type, int *value)
+{
+    uint64_t key;
+    info_ctrl_t *info_ctrl;
+    uint8_t val;
+
+    if ((sff_index == 0) || (sff_index > plan->sff_num) || (plan->port_reg[sff_index] < 0)) {
+        key = DFD_CFG_KEY(DFD_CFG_ITEM_SFF_CPLD_REG, sff_index, cpld_reg_type);
+        return dfd_info_get_int(key, value, NULL);
+    }
+
+    /* Same decoding as dfd_info_get_int() applies to a bit format */
+    info_ctrl = plan->port_ctrl[sff_index];
+    val = plan->reg_val[plan->port_reg[sff_index]];
+    if (info_ctrl->pola == INFO_POLA_NEGA) {
+        val = ~val;
+    }
+    *value = (int)((val >> info_ctrl->bit_offset) & (~(0xff << info_ctrl->len)));
+
+    return DFD_RV_OK;
+}
+
+static void dfd_sff_status_invalidate(int cpld_reg_type)
+{
+    if ((cpld_reg_type < 0) || (cpld_reg_type >= WB_SFF_CPLD_ATTR_MAX)) {
+        return;
+    }
+    mutex_lock(&g_dfd_sff_status_lock);
+    g_dfd_sff_status_plan[cpld_reg_type].valid = 0;
+    mutex_unlock(&g_dfd_sff_status_lock);
+}
+
+/**
+ * dfd_get_sff_cpld_info_all - Obtain the CPLD register status of all optical modules
+ * @cpld_reg_type: Optical module CPLD register type
+ * @buf: Receives one digit per module, in module order, followed by '\n'
+ * @count: buf length
+ * return: Success: Returns the length of fill buf
+ *       : Failed: A negative value is returned
+ */
+ssize_t dfd_get_sff_cpld_info_all(int cpld_reg_type, char *buf, size_t count)
+{
+    dfd_sff_status_plan_t *plan;
+    unsigned int sff_index;
+    int ret, value, len;
+
+    if ((buf == NULL) || (count <= 0) || (cpld_reg_type < 0) || (cpld_reg_type >= WB_SFF_CPLD_ATTR_MAX)) {
+        DFD_SFF_DEBUG(DBG_ERROR, "param error, cpld_reg_type: %d\n", cpld_reg_type);
+        return -DFD_RV_INVALID_VALUE;
+    }
+    mem_clear(buf, count);
+
+    mutex_lock(&g_dfd_sff_status_lock);
+    plan = &g_dfd_sff_status_plan[cpld_reg_type];
+    ret = dfd_sff_status_sweep(plan, cpld_reg_type);
+    len = 0;
+    for (sff_index = 1; (ret >= 0) && (sff_index <= plan->sff_num); sff_index++) {
+        ret = dfd_sff_status_port_value(plan, sff_index, cpld_reg_type, &value);
+        if (ret < 0) {
+            DFD_SFF_DEBUG(DBG_ERROR, "get sff%u cpld reg type %d error, ret: %d\n",
+                sff_index, cpld_reg_type, ret);
+            break;
+        }
+        /* Reserve end to add '\n' and '\0' */
+        if (len + 2 >= count) {
+            ret = -DFD_RV_NO_MEMORY;
+            break;
+        }
+        len += snprintf(buf + len, count - len, "%d", value);
+    }
+    mutex_unlock(&g_dfd_sff_status_lock);
+
+    if (ret < 0) {
+        mem_clear(buf, count);
+        return ret;
+    }
+    buf[len++] = '\n';
+    return (ssize_t)len;
+}
+
+/**
+ * dfd_sff_status_exit - Free the sff status read plans
+ */
+void dfd_sff_status_exit(void)
+{
+    int i;
+
+    mutex_lock(&g_dfd_sff_status_lock);
+    for (i = 0; i < WB_SFF_CPLD_ATTR_MAX; i++) {
+        kfree(g_dfd_sff_status_plan[i].port_reg);
+        kfree(g_dfd_sff_status_plan[i].port_ctrl);
+        kfree(g_dfd_sff_status_plan[i].reg_addr);
+        kfree(g_dfd_sff_status_plan[i].reg_val);
+        mem_clear(&g_dfd_sff_status_plan[i], sizeof(dfd_sff_status_plan_t));
+    }
+    mutex_unlock(&g_dfd_sff_status_lock);
+}
+
 /**
  * dfd_set_sff_cpld_info - Example Set the CPLD register status of the optical module
  * @sff_index: Optical module number, starting from 1
@@ -48,6 +266,7 @@ int dfd_set_sff_cpld_info(unsigned int sff_index, int cpld_reg_type, int value)
     }
     key = DFD_CFG_KEY(DFD_CFG_ITEM_SFF_CPLD_REG, sff_index, cpld_reg_type);
     ret = dfd_info_set_int(key, value);
+    dfd_sff_status_invalidate(cpld_reg_type);
     if (ret < 0) {
         DFD_SFF_DEBUG(DBG_ERROR, "set sff%u cpld reg type %d error, key_name: %s, ret: %d.\n",
             sff_index, cpld_reg_type, key_to_name(DFD_CFG_ITEM_SFF_CPLD_REG), ret);
@@ -70,6 +289,7 @@ ssize_t dfd_get_sff_cpld_info(unsigned int sff_index, int cpld_reg_type, char *b
 {
     uint64_t key;
     int ret, value;
+    dfd_sff_status_plan_t *plan;
 
     if (buf == NULL) {
         DFD_SFF_DEBUG(DBG_ERROR, "param error, buf is NULL. sff_index: %u, cpld_reg_type: %d\n",
@@ -82,8 +302,22 @@ ssize_t dfd_get_sff_cpld_info(unsigned int sff_index, int cpld_reg_type, char *b
         return -DFD_RV_INVALID_VALUE;
     }
     mem_clear(buf, count);
-    key = DFD_CFG_KEY(DFD_CFG_ITEM_SFF_CPLD_REG, sff_index, cpld_reg_type);
-    ret = dfd_info_get_int(key, &value, NULL);
+    ret = -DFD_RV_INDEX_INVALID;
+    if ((cpld_reg_type >= 0) && (cpld_reg_type < WB_SFF_CPLD_ATTR_MAX)) {
+        /* Served from the shared sweep of the cpld registers of this type */
+        mutex_lock(&g_dfd_sff_status_lock);
+        plan = &g_dfd_sff_status_plan[cpld_reg_type];
+        ret = dfd_sff_status_sweep(plan, cpld_reg_type);
+        if (ret >= 0) {
+            ret = dfd_sff_status_port_value(plan, sff_index, cpld_reg_type, &value);
+        }
+        mutex_unlock(&g_dfd_sff_status_lock);
+    }
+    if (ret < 0) {
+        /* Unknown types and failed sweeps read the port register on its own */
+        key = DFD_CFG_KEY(DFD_CFG_ITEM_SFF_CPLD_REG, sff_index, cpld_reg_type);
+        ret = dfd_info_get_int(key, &value, NULL);
+    }
     if (ret < 0) {
         DFD_SFF_DEBUG(DBG_ERROR, "get sff%u cpld reg type %d error, key_name: %s, ret: %d\n",
             sff_index, cpld_reg_type, key_to_name(DFD_CFG_ITEM_SFF_CPLD_REG), ret);
@@ -52,27 +52,15 @@ module_param(g_dfd_watchdog_dbg_level, int, S_IRUGO | S_IWUSR);
 static int watchdog_file_read(char *fpath, char *buf, int size)
 {
     int ret;
-    struct file *filp;
-    loff_t pos;
-
-    filp = filp_open(fpath, O_RDONLY, 0);
-    if (IS_ERR(filp)) {
-        DFD_WDT_DEBUG(DBG_ERROR, "watchdog can't open %s.\n", fpath);
-        filp = NULL;
-        ret = -ENOENT;
-        return ret;
-    }
 
+    /* Goes through the cached file handles of the cfg adapter */
     mem_clear(buf, size);
-    pos = 0;
-    ret = kernel_read(filp, buf, size - 1, &pos);
+    ret = dfd_ko_read_file(fpath, 0, (uint8_t *)buf, size - 1);
     if (ret < 0) {
-        DFD_WDT_DEBUG(DBG_ERROR, "kernel_read failed, path=%s, addr=0, size=%d, ret=%d\n",
+        DFD_WDT_DEBUG(DBG_ERROR, "read failed, path=%s, addr=0, size=%d, ret=%d\n",
             fpath, size -1, ret);
     }
 
-    filp_close(filp, NULL);
-    filp = NULL;
     return ret;
 }
 
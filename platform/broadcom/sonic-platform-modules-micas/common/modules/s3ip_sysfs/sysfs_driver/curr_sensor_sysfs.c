@@ -74,6 +74,33 @@ static ssize_t curr_sensor_value_show(struct switch_obj *obj, struct switch_attr
     return g_curr_sensor_drv->get_main_board_curr_value(curr_index, buf, PAGE_SIZE);
 }
 
+static ssize_t curr_sensor_value_stat_show(struct switch_obj *obj, unsigned int stat, char *buf)
+{
+    unsigned int curr_index;
+
+    check_p(g_curr_sensor_drv);
+    check_p(g_curr_sensor_drv->get_main_board_curr_value_stat);
+
+    curr_index = obj->index;
+    CURR_SENSOR_DBG("curr index: %u, stat: %u\n", curr_index, stat);
+    return g_curr_sensor_drv->get_main_board_curr_value_stat(curr_index, stat, buf, PAGE_SIZE);
+}
+
+static ssize_t curr_sensor_value_min_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    return curr_sensor_value_stat_show(obj, WB_SENSOR_STAT_MIN, buf);
+}
+
+static ssize_t curr_sensor_value_max_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    return curr_sensor_value_stat_show(obj, WB_SENSOR_STAT_MAX, buf);
+}
+
+static ssize_t curr_sensor_value_avg_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    return curr_sensor_value_stat_show(obj, WB_SENSOR_STAT_AVG, buf);
+}
+
 static ssize_t curr_sensor_alias_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
 {
     unsigned int curr_index;
@@ -191,6 +218,9 @@ static struct attribute_group curr_sensor_root_attr_group = {
 
 /*******************************curr1 curr2 dir and attrs*******************************************/
 static struct switch_attribute curr_value_attr = __ATTR(value, S_IRUGO, curr_sensor_value_show, NULL);
+static struct switch_attribute curr_value_min_attr = __ATTR(value_min, S_IRUGO, curr_sensor_value_min_show, NULL);
+static struct switch_attribute curr_value_max_attr = __ATTR(value_max, S_IRUGO, curr_sensor_value_max_show, NULL);
+static struct switch_attribute curr_value_avg_attr = __ATTR(value_avg, S_IRUGO, curr_sensor_value_avg_show, NULL);
 static struct switch_attribute curr_alias_attr = __ATTR(alias, S_IRUGO, curr_sensor_alias_show, NULL);
 static struct switch_attribute curr_type_attr = __ATTR(type, S_IRUGO, curr_sensor_type_show, NULL);
 static struct switch_attribute curr_max_attr = __ATTR(max, S_IRUGO | S_IWUSR, curr_sensor_max_show, curr_sensor_max_store);
@@ -199,6 +229,9 @@ static struct switch_attribute curr_monitor_flag_attr = __ATTR(monitor_flag,  S_
 
 static struct attribute *curr_sensor_attrs[] = {
     &curr_value_attr.attr,
+    &curr_value_min_attr.attr,
+    &curr_value_max_attr.attr,
+    &curr_value_avg_attr.attr,
     &curr_alias_attr.attr,
     &curr_type_attr.attr,
     &curr_max_attr.attr,
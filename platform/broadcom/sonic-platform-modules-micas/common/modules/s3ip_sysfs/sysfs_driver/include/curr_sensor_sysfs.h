@@ -30,6 +30,8 @@ struct s3ip_sysfs_curr_sensor_drivers_s {
     ssize_t (*get_main_board_curr_min)(unsigned int curr_index, char *buf, size_t count);
     int (*set_main_board_curr_min)(unsigned int curr_index, const char *buf, size_t count);
     ssize_t (*get_main_board_curr_value)(unsigned int curr_index, char *buf, size_t count);
+    ssize_t (*get_main_board_curr_value_stat)(unsigned int curr_index, unsigned int stat, char *buf,
+        size_t count);
     ssize_t (*get_main_board_curr_monitor_flag)(unsigned int curr_index, char *buf, size_t count);
 };
 
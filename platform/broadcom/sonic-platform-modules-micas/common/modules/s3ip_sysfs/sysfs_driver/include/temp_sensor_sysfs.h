@@ -34,6 +34,8 @@ struct s3ip_sysfs_temp_sensor_drivers_s {
     ssize_t (*get_main_board_temp_low)(unsigned int temp_index, char *buf, size_t count);
     int (*set_main_board_temp_low)(unsigned int temp_index, const char *buf, size_t count);
     ssize_t (*get_main_board_temp_value)(unsigned int temp_index, char *buf, size_t count);
+    ssize_t (*get_main_board_temp_value_stat)(unsigned int temp_index, unsigned int stat, char *buf,
+        size_t count);
     ssize_t (*get_main_board_temp_monitor_flag)(unsigned int temp_index, char *buf, size_t count);
 };
 
@@ -32,6 +32,8 @@ struct s3ip_sysfs_vol_sensor_drivers_s {
     ssize_t (*get_main_board_vol_range)(unsigned int vol_index, char *buf, size_t count);
     ssize_t (*get_main_board_vol_nominal_value)(unsigned int vol_index, char *buf, size_t count);
     ssize_t (*get_main_board_vol_value)(unsigned int vol_index, char *buf, size_t count);
+    ssize_t (*get_main_board_vol_value_stat)(unsigned int vol_index, unsigned int stat, char *buf,
+        size_t count);
     ssize_t (*get_main_board_vol_monitor_flag)(unsigned int vol_index, char *buf, size_t count);
 };
 
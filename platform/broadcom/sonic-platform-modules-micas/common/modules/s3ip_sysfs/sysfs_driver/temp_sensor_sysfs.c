@@ -74,6 +74,33 @@ static ssize_t temp_sensor_value_show(struct switch_obj *obj, struct switch_attr
     return g_temp_sensor_drv->get_main_board_temp_value(temp_index, buf, PAGE_SIZE);
 }
 
+static ssize_t temp_sensor_value_stat_show(struct switch_obj *obj, unsigned int stat, char *buf)
+{
+    unsigned int temp_index;
+
+    check_p(g_temp_sensor_drv);
+    check_p(g_temp_sensor_drv->get_main_board_temp_value_stat);
+
+    temp_index = obj->index;
+    TEMP_SENSOR_DBG("temp index: %u, stat: %u\n", temp_index, stat);
+    return g_temp_sensor_drv->get_main_board_temp_value_stat(temp_index, stat, buf, PAGE_SIZE);
+}
+
+static ssize_t temp_sensor_value_min_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    return temp_sensor_value_stat_show(obj, WB_SENSOR_STAT_MIN, buf);
+}
+
+static ssize_t temp_sensor_value_max_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    return temp_sensor_value_stat_show(obj, WB_SENSOR_STAT_MAX, buf);
+}
+
+static ssize_t temp_sensor_value_avg_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    return temp_sensor_value_stat_show(obj, WB_SENSOR_STAT_AVG, buf);
+}
+
 static ssize_t temp_sensor_alias_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
 {
     unsigned int temp_index;
@@ -260,6 +287,9 @@ static struct attribute_group temp_sensor_root_attr_group = {
 
 /*******************************temp1 temp2 dir and attrs*******************************************/
 static struct switch_attribute temp_value_attr = __ATTR(value, S_IRUGO, temp_sensor_value_show, NULL);
+static struct switch_attribute temp_value_min_attr = __ATTR(value_min, S_IRUGO, temp_sensor_value_min_show, NULL);
+static struct switch_attribute temp_value_max_attr = __ATTR(value_max, S_IRUGO, temp_sensor_value_max_show, NULL);
+static struct switch_attribute temp_value_avg_attr = __ATTR(value_avg, S_IRUGO, temp_sensor_value_avg_show, NULL);
 static struct switch_attribute temp_alias_attr = __ATTR(alias, S_IRUGO, temp_sensor_alias_show, NULL);
 static struct switch_attribute temp_type_attr = __ATTR(type, S_IRUGO, temp_sensor_type_show, NULL);
 static struct switch_attribute temp_max_attr = __ATTR(max, S_IRUGO | S_IWUSR, temp_sensor_max_show, temp_sensor_max_store);
@@ -270,6 +300,9 @@ static struct switch_attribute temp_monitor_flag_attr = __ATTR(monitor_flag,  S_
 
 static struct attribute *temp_sensor_attrs[] = {
     &temp_value_attr.attr,
+    &temp_value_min_attr.attr,
+    &temp_value_max_attr.attr,
+    &temp_value_avg_attr.attr,
     &temp_alias_attr.attr,
     &temp_type_attr.attr,
     &temp_max_attr.attr,
@@ -74,6 +74,33 @@ static ssize_t vol_sensor_value_show(struct switch_obj *obj, struct switch_attri
     return g_vol_sensor_drv->get_main_board_vol_value(vol_index, buf, PAGE_SIZE);
 }
 
+static ssize_t vol_sensor_value_stat_show(struct switch_obj *obj, unsigned int stat, char *buf)
+{
+    unsigned int vol_index;
+
+    check_p(g_vol_sensor_drv);
+    check_p(g_vol_sensor_drv->get_main_board_vol_value_stat);
+
+    vol_index = obj->index;
+    VOL_SENSOR_DBG("vol index: %u, stat: %u\n", vol_index, stat);
+    return g_vol_sensor_drv->get_main_board_vol_value_stat(vol_index, stat, buf, PAGE_SIZE);
+}
+
+static ssize_t vol_sensor_value_min_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    return vol_sensor_value_stat_show(obj, WB_SENSOR_STAT_MIN, buf);
+}
+
+static ssize_t vol_sensor_value_max_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    return vol_sensor_value_stat_show(obj, WB_SENSOR_STAT_MAX, buf);
+}
+
+static ssize_t vol_sensor_value_avg_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    return vol_sensor_value_stat_show(obj, WB_SENSOR_STAT_AVG, buf);
+}
+
 static ssize_t vol_sensor_alias_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
 {
     unsigned int vol_index;
@@ -216,6 +243,9 @@ static struct attribute_group vol_sensor_root_attr_group = {
 
 /*******************************vol1 vol2 dir and attrs*******************************************/
 static struct switch_attribute vol_value_attr = __ATTR(value, S_IRUGO, vol_sensor_value_show, NULL);
+static struct switch_attribute vol_value_min_attr = __ATTR(value_min, S_IRUGO, vol_sensor_value_min_show, NULL);
+static struct switch_attribute vol_value_max_attr = __ATTR(value_max, S_IRUGO, vol_sensor_value_max_show, NULL);
+static struct switch_attribute vol_value_avg_attr = __ATTR(value_avg, S_IRUGO, vol_sensor_value_avg_show, NULL);
 static struct switch_attribute vol_alias_attr = __ATTR(alias, S_IRUGO, vol_sensor_alias_show, NULL);
 static struct switch_attribute vol_type_attr = __ATTR(type, S_IRUGO, vol_sensor_type_show, NULL);
 static struct switch_attribute vol_max_attr = __ATTR(max, S_IRUGO | S_IWUSR, vol_sensor_max_show, vol_sensor_max_store);
@@ -226,6 +256,9 @@ static struct switch_attribute vol_monitor_flag_attr = __ATTR(monitor_flag,  S_I
 
 static struct attribute *vol_sensor_attrs[] = {
     &vol_value_attr.attr,
+    &vol_value_min_attr.attr,
+    &vol_value_max_attr.attr,
+    &vol_value_avg_attr.attr,
     &vol_alias_attr.attr,
     &vol_type_attr.attr,
     &vol_max_attr.attr,
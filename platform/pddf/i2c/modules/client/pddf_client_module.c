@@ -29,6 +29,9 @@
 #include <linux/dmi.h>
 #include <linux/kobject.h>
 #include <linux/hashtable.h>
+#include <linux/jhash.h>
+#include <linux/rcupdate.h>
+#include <linux/spinlock.h>
 #include "pddf_client_defs.h"
 
 
@@ -199,16 +202,14 @@ EXPORT_SYMBOL(store_pddf_data);
 
 
 DEFINE_HASHTABLE(htable, 8);
+/* Serializes writers of htable; readers only take rcu_read_lock() */
+static DEFINE_SPINLOCK(htable_lock);
+/* Bumped by every delete, so cached lookups know to resolve the name again */
+static atomic_t htable_gen = ATOMIC_INIT(0);
 
 int get_hash(char *name)
 {
-    int i=0;
-    int hash=0;
-    for(i=0; i<strlen(name); i++)
-    {
-        hash+=name[i];
-    }
-    return hash;
+    return (int)jhash(name, strlen(name), 0);
 }
 
 void init_device_table(void)
@@ -222,37 +223,55 @@ void add_device_table(char *name, void *ptr)
     if(!hdev)return;
     strcpy(hdev->name, name);
     hdev->data = ptr;
+    hdev->hash = get_hash(hdev->name);
     pddf_dbg(CLIENT, KERN_ERR "%s: Adding ptr 0x%p to the hash table\n", __FUNCTION__, ptr);
-    hash_add(htable, &hdev->node, get_hash(hdev->name));
+    spin_lock(&htable_lock);
+    hash_add_rcu(htable, &hdev->node, hdev->hash);
+    spin_unlock(&htable_lock);
 }
 EXPORT_SYMBOL(add_device_table);
 
 void* get_device_table(char *name)
 {
     PDEVICE *dev=NULL;
-    int i=0;
-    
-    hash_for_each(htable, i, dev, node) {
-        if(strcmp(dev->name, name)==0) {
-            return (void *)dev->data;
+    void *data=NULL;
+    u32 hash = get_hash(name);
+
+    rcu_read_lock();
+    hash_for_each_possible_rcu(htable, dev, node, hash) {
+        if((dev->hash == hash) && (strcmp(dev->name, name)==0)) {
+            data = dev->data;
+            break;
         }
     }
+    rcu_read_unlock();
 
-    return NULL;
+    return data;
 }
 EXPORT_SYMBOL(get_device_table);
 
+unsigned int get_device_table_gen(void)
+{
+    return (unsigned int)atomic_read(&htable_gen);
+}
+EXPORT_SYMBOL(get_device_table_gen);
+
 void delete_device_table(char *name)
 {
     PDEVICE *dev=NULL;
-    int i=0;
-    
-    hash_for_each(htable, i, dev, node) {
-        if(strcmp(dev->name, name)==0) {
+    struct hlist_node *tmp=NULL;
+    u32 hash = get_hash(name);
+
+    spin_lock(&htable_lock);
+    hash_for_each_possible_safe(htable, dev, tmp, node, hash) {
+        if((dev->hash == hash) && (strcmp(dev->name, name)==0)) {
             pddf_dbg(CLIENT, KERN_ERR "found entry to delete: %s  0x%p\n", dev->name, dev->data);
-            hash_del(&(dev->node));
+            hash_del_rcu(&(dev->node));
+            kfree_rcu(dev, rcu);
         }
     }
+    atomic_inc(&htable_gen);
+    spin_unlock(&htable_lock);
     return;
 }
 EXPORT_SYMBOL(delete_device_table);
@@ -260,11 +279,15 @@ EXPORT_SYMBOL(delete_device_table);
 void traverse_device_table(void )
 {
     PDEVICE *dev=NULL;
-    int i=0;
-    hash_for_each(htable, i, dev, node) {
+    int i=0, count=0;
+
+    rcu_read_lock();
+    hash_for_each_rcu(htable, i, dev, node) {
         pddf_dbg(CLIENT, KERN_ERR "Entry[%d]: %s : 0x%p\n", i, dev->name, dev->data);
+        count++;
     }
-    showall = i;
+    rcu_read_unlock();
+    showall = count;
 }
 EXPORT_SYMBOL(traverse_device_table);
 
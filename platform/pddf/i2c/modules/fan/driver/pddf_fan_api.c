@@ -28,6 +28,9 @@
 #include <linux/sysfs.h>
 #include <linux/slab.h>
 #include <linux/dmi.h>
+#include <linux/kthread.h>
+#include <linux/seqlock.h>
+#include "pddf_client_defs.h"
 #include "pddf_fan_defs.h"
 #include "pddf_fan_driver.h"
 #include "pddf_multifpgapci_defs.h"
@@ -128,15 +131,13 @@ void get_fan_extra_default_sysfs(int idx, char *str)
 }
 
 
-int fan_update_hw(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR *udata)
+/* Write info->val to the hardware. Called with info->update_lock held */
+static void __fan_update_hw(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR *udata)
 {
 	int status = 0;
     struct i2c_client *client = to_i2c_client(dev);
 	FAN_SYSFS_ATTR_DATA *sysfs_attr_data = NULL;
 
-
-    mutex_lock(&info->update_lock);
-
 	sysfs_attr_data = udata->access_data;
 	if (sysfs_attr_data->pre_set != NULL)
 	{
@@ -157,22 +158,50 @@ int fan_update_hw(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR
 		if (status!=0)
 			dev_warn(&client->dev, "%s: post_set function fails for %s attribute. ret %d\n", __FUNCTION__, udata->aname, status);
 	}
+}
 
+int fan_update_hw(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR *udata)
+{
+    mutex_lock(&info->update_lock);
+    __fan_update_hw(dev, info, udata);
     mutex_unlock(&info->update_lock);
 
     return 0;
 }
 
-int fan_update_attr(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR *udata)
+/*
+ * Write val to the hardware. The published snapshot is dropped in the same
+ * critical section, so neither readers nor the refresh kthread can hand out
+ * or overwrite the value from before the write.
+ */
+static void fan_store_hw(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR *udata, int val)
+{
+    mutex_lock(&info->update_lock);
+
+    write_seqlock(&info->snap_lock);
+    info->val.intval = val;
+    info->snap_valid = 0;
+    write_sequnlock(&info->snap_lock);
+
+    __fan_update_hw(dev, info, udata);
+
+    /* Read the value back from the hardware on the next access */
+    info->valid = 0;
+
+    mutex_unlock(&info->update_lock);
+}
+
+static int __fan_update_attr(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR *udata, int force)
 {
 	int status = 0;
     struct i2c_client *client = to_i2c_client(dev);
+    struct fan_data *data = i2c_get_clientdata(client);
 	FAN_SYSFS_ATTR_DATA *sysfs_attr_data = NULL;
 
 
     mutex_lock(&info->update_lock);
 
-    if (time_after(jiffies, info->last_updated + HZ + HZ / 2) || !info->valid) 
+    if (force || time_after(jiffies, info->last_updated + msecs_to_jiffies(data->max_age_ms)) || !info->valid)
 	{
         dev_dbg(&client->dev, "Starting pddf_fan update\n");
         info->valid = 0;
@@ -201,6 +230,12 @@ int fan_update_attr(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATT
 		
         info->last_updated = jiffies;
         info->valid = 1;
+
+        write_seqlock(&info->snap_lock);
+        info->snap = info->val;
+        info->snap_updated = info->last_updated;
+        info->snap_valid = 1;
+        write_sequnlock(&info->snap_lock);
     }
 
     mutex_unlock(&info->update_lock);
@@ -208,37 +243,163 @@ int fan_update_attr(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATT
     return 0;
 }
 
-ssize_t fan_show_default(struct device *dev, struct device_attribute *da, char *buf)
+int fan_update_attr(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR *udata)
 {
-    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
-    struct i2c_client *client = to_i2c_client(dev);
+    return __fan_update_attr(dev, info, udata, 0);
+}
+
+/* Copy the last published value of an attribute. Returns 0 if it is younger than max_age_ms */
+static int fan_get_snapshot(struct fan_attr_info *info, int max_age_ms, union fan_attr_val *val)
+{
+    unsigned int seq;
+    unsigned long updated;
+    char valid;
+
+    do {
+        seq = read_seqbegin(&info->snap_lock);
+        *val = info->snap;
+        updated = info->snap_updated;
+        valid = info->snap_valid;
+    } while (read_seqretry(&info->snap_lock, seq));
+
+    if (!valid || time_after(jiffies, updated + msecs_to_jiffies(max_age_ms)))
+        return -EAGAIN;
+
+    return 0;
+}
+
+/* Get the value of an attribute, from the snapshot while it is recent enough, else from the hardware */
+static void fan_read_attr(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR *udata, union fan_attr_val *val)
+{
+    struct fan_data *data = i2c_get_clientdata(to_i2c_client(dev));
+
+    if (fan_get_snapshot(info, data->max_age_ms, val) == 0)
+        return;
+
+    fan_update_attr(dev, info, udata);
+    mutex_lock(&info->update_lock);
+    *val = info->val;
+    mutex_unlock(&info->update_lock);
+}
+
+/* Telemetry refresh kthread: reads every attribute of the fan controller in one burst */
+static int fan_refresh_thread(void *arg)
+{
+    struct i2c_client *client = (struct i2c_client *)arg;
     struct fan_data *data = i2c_get_clientdata(client);
     FAN_PDATA *pdata = (FAN_PDATA *)(client->dev.platform_data);
-    FAN_DATA_ATTR *usr_data = NULL;
-    struct fan_attr_info *attr_info = NULL;
-    int i, status=0;
-	char new_str[ATTR_NAME_LEN] = "";
-	FAN_SYSFS_ATTR_DATA *ptr = NULL;
+    FAN_SYSFS_ATTR_DATA *ptr = NULL;
+    int i;
 
-    for (i=0;i<data->num_attr;i++)
+    while (!kthread_should_stop())
     {
-		ptr = (FAN_SYSFS_ATTR_DATA *)pdata->fan_attrs[i].access_data;
-		get_fan_duplicate_sysfs(ptr->index , new_str);
-        if (strcmp(attr->dev_attr.attr.name, pdata->fan_attrs[i].aname) == 0 || strcmp(attr->dev_attr.attr.name, new_str) == 0)
+        for (i = 0; i < data->num_attr && !kthread_should_stop(); i++)
         {
-			attr_info = &data->attr_info[i];
-            usr_data = &pdata->fan_attrs[i];
-			strcpy(new_str, "");
+            /* Unknown attributes have no sysfs entry and no locks */
+            if (!data->attr_info[i].bound)
+                continue;
+            ptr = (FAN_SYSFS_ATTR_DATA *)pdata->fan_attrs[i].access_data;
+            /* Write only attributes and the eeprom strings are left to on-demand reads */
+            if (ptr == NULL || ptr->do_get == NULL)
+                continue;
+            __fan_update_attr(&client->dev, &data->attr_info[i], &pdata->fan_attrs[i], 1);
         }
+
+        set_current_state(TASK_INTERRUPTIBLE);
+        if (!kthread_should_stop())
+            schedule_timeout(msecs_to_jiffies(data->refresh_ms));
+        __set_current_state(TASK_RUNNING);
     }
 
-    if (attr_info==NULL || usr_data==NULL)
+    return 0;
+}
+
+int fan_refresh_set(struct i2c_client *client, int refresh_ms)
+{
+    struct fan_data *data = i2c_get_clientdata(client);
+    int status = 0;
+
+    if (refresh_ms < 0)
+        return -EINVAL;
+
+    mutex_lock(&data->refresh_lock);
+    if (data->refresh_task)
     {
-        printk(KERN_ERR "%s is not supported attribute for this client\n", usr_data->aname);
+        kthread_stop(data->refresh_task);
+        data->refresh_task = NULL;
+    }
+    data->refresh_ms = refresh_ms;
+    if (refresh_ms > 0)
+    {
+        data->refresh_task = kthread_run(fan_refresh_thread, client, "pddf_fan-%s", dev_name(&client->dev));
+        if (IS_ERR(data->refresh_task))
+        {
+            status = PTR_ERR(data->refresh_task);
+            data->refresh_task = NULL;
+            data->refresh_ms = 0;
+        }
+    }
+    mutex_unlock(&data->refresh_lock);
+
+    return status;
+}
+
+ssize_t fan_show_cache_cfg(struct device *dev, struct device_attribute *da, char *buf)
+{
+    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
+    struct fan_data *data = i2c_get_clientdata(to_i2c_client(dev));
+
+    return sprintf(buf, "%d\n", attr->index == FAN_CACHE_REFRESH_MS ? data->refresh_ms : data->max_age_ms);
+}
+
+ssize_t fan_store_cache_cfg(struct device *dev, struct device_attribute *da, const char *buf, size_t count)
+{
+    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
+    struct i2c_client *client = to_i2c_client(dev);
+    struct fan_data *data = i2c_get_clientdata(client);
+    int ret, val;
+
+    ret = kstrtoint(buf, 10, &val);
+    if (ret)
+        return ret;
+    if (val < 0)
+        return -EINVAL;
+
+    if (attr->index == FAN_CACHE_REFRESH_MS)
+    {
+        ret = fan_refresh_set(client, val);
+        if (ret)
+            return ret;
+    }
+    else
+        data->max_age_ms = val;
+
+    return count;
+}
+
+ssize_t fan_show_default(struct device *dev, struct device_attribute *da, char *buf)
+{
+    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
+    struct fan_sysfs_attr *bound = container_of(attr, struct fan_sysfs_attr, sda);
+    struct i2c_client *client = to_i2c_client(dev);
+    struct fan_data *data = i2c_get_clientdata(client);
+    FAN_PDATA *pdata = (FAN_PDATA *)(client->dev.platform_data);
+    FAN_DATA_ATTR *usr_data = NULL;
+    struct fan_attr_info *attr_info = NULL;
+    union fan_attr_val val;
+    int status=0;
+
+    /* The attribute was bound to its data slot when it was created in probe */
+    if (bound->idx < 0 || bound->idx >= data->num_attr)
+    {
+        printk(KERN_ERR "%s is not supported attribute for this client\n", attr->dev_attr.attr.name);
 		goto exit;
 	}
+    attr_info = &data->attr_info[bound->idx];
+    usr_data = &pdata->fan_attrs[bound->idx];
 
-    fan_update_attr(dev, attr_info, usr_data);
+    /* Serve a recent enough value without touching the bus */
+    fan_read_attr(dev, attr_info, usr_data, &val);
 
 	/*Decide the o/p based on attribute type */
 	switch(attr->index)
@@ -324,7 +485,7 @@ ssize_t fan_show_default(struct device *dev, struct device_attribute *da, char *
 		case FAN15_FAULT:
 		case FAN16_FAULT:
 		case FAN_DUTY_CYCLE:
-            status = attr_info->val.intval;
+            status = val.intval;
 			break;
 		default:
 			fan_dbg(KERN_ERR "%s: Unable to find the attribute index for %s\n", __FUNCTION__, usr_data->aname);
@@ -376,8 +537,6 @@ ssize_t fan_store_default(struct device *dev, struct device_attribute *da, const
                 printk(KERN_ERR "%s: Duty cycle %d is not valid. Valid range [0-100]\n", __FUNCTION__, val);
                 return -EINVAL;
             }
-			/*Update the value of attr_info here, and use it to update the HW values*/
-			attr_info->val.intval = val;
 			break;
 
 		case FAN1_PWM:
@@ -402,8 +561,6 @@ ssize_t fan_store_default(struct device *dev, struct device_attribute *da, const
 				printk(KERN_ERR "%s: Unable to convert string into value for %s\n", __FUNCTION__, usr_data->aname);
 				return ret;
 			}
-			/*Update the value of attr_info here, and use it to update the HW values*/
-			attr_info->val.intval = val;
 			break;
 		default:
 			printk(KERN_ERR "%s: Unable to find the attr index for %s\n", __FUNCTION__, usr_data->aname);
@@ -411,7 +568,7 @@ ssize_t fan_store_default(struct device *dev, struct device_attribute *da, const
 	}
 
 	fan_dbg(KERN_ERR "%s: pwm to be set is %d\n", __FUNCTION__, val);
-	fan_update_hw(dev, attr_info, usr_data);
+	fan_store_hw(dev, attr_info, usr_data, val);
 
 exit:
 	return count;
@@ -562,7 +719,7 @@ int fan_multifpgapci_read(FAN_DATA_ATTR *udata, int *output)
         goto ret;
     }
 
-    pci_dev = (struct pci_dev *)get_device_table(udata->devname);
+    pci_dev = (struct pci_dev *)get_device_table_cached(udata->devname, &udata->devptr, &udata->devgen);
     if (pci_dev == NULL) {
         printk(KERN_ERR "PDDF_FAN: Unable to get pci_dev of %s for %s\n", udata->devname, udata->aname);
         status = -1;
@@ -591,7 +748,7 @@ int fan_multifpgapci_write(FAN_DATA_ATTR *udata, uint32_t val)
         return -1;
     }
 
-    pci_dev = (struct pci_dev *)get_device_table(udata->devname);
+    pci_dev = (struct pci_dev *)get_device_table_cached(udata->devname, &udata->devptr, &udata->devgen);
     if (pci_dev == NULL) {
         printk(KERN_ERR "PDDF_FAN: Unable to get pci_dev of %s for %s\n", udata->devname, udata->aname);
         status = -1;
@@ -937,6 +1094,7 @@ ssize_t fan_show_status(struct device *dev, struct device_attribute *da, char *b
     char fan_attr[ATTR_NAME_LEN]="";
     char *attr_name, *end;
     int fan_attr_len = 0, presence = 0, speed = 0;
+    union fan_attr_val pres_val, speed_val;
 
 
     /* Find out the fan_id */
@@ -985,12 +1143,12 @@ ssize_t fan_show_status(struct device *dev, struct device_attribute *da, char *b
 	}
     kfree(attr_name);
 
-    fan_update_attr(dev, pres_attr_info, pres_usr_data);
-    fan_update_attr(dev, speed_attr_info, speed_usr_data);
+    fan_read_attr(dev, pres_attr_info, pres_usr_data, &pres_val);
+    fan_read_attr(dev, speed_attr_info, speed_usr_data, &speed_val);
 
 	/*Decide the o/p based on attribute type */
-    presence = pres_attr_info->val.intval;
-    speed = speed_attr_info->val.intval;
+    presence = pres_val.intval;
+    speed = speed_val.intval;
 
     /* As per S3IP spec, 0:Not present, 1:Present and normal, 2:Present and not normal */
     if (presence == 0)
@@ -36,6 +36,15 @@
 
 #define DRVNAME "pddf_fan"
 
+static SENSOR_DEVICE_ATTR(telemetry_max_age_ms, S_IWUSR|S_IRUGO, fan_show_cache_cfg, fan_store_cache_cfg, FAN_CACHE_MAX_AGE_MS);
+static SENSOR_DEVICE_ATTR(telemetry_refresh_ms, S_IWUSR|S_IRUGO, fan_show_cache_cfg, fan_store_cache_cfg, FAN_CACHE_REFRESH_MS);
+
+static struct attribute *fan_cache_cfg_attributes[] = {
+	&sensor_dev_attr_telemetry_max_age_ms.dev_attr.attr,
+	&sensor_dev_attr_telemetry_refresh_ms.dev_attr.attr,
+	NULL
+};
+
 struct pddf_ops_t pddf_fan_ops = {
 	.pre_init = NULL,
 	.post_init = NULL,
@@ -447,10 +456,13 @@ static int pddf_fan_probe(struct i2c_client *client)
 	fan_platform_data = (FAN_PDATA *)(client->dev.platform_data);
 	num = fan_platform_data->len;
 	data->num_attr = num;
+	data->max_age_ms = FAN_DEFAULT_MAX_AGE_MS;
+	mutex_init(&data->refresh_lock);
 
 	for (i=0;i<num;i++)
 	{
 		/*struct attribute *aptr = NULL;*/
+		struct fan_sysfs_attr *bound = NULL;
 		struct sensor_device_attribute *dy_ptr = NULL;
         data_attr = fan_platform_data->fan_attrs + i;
 		sysfs_data_entry = get_fan_access_data(data_attr->aname);
@@ -459,10 +471,15 @@ static int pddf_fan_probe(struct i2c_client *client)
 			printk(KERN_ERR "%s: Wrong attribute name provided by user '%s'\n", __FUNCTION__, data_attr->aname);
 			continue;
 		}
+		/* Resolve the backing device once instead of on every attribute access */
+		if (strcmp(data_attr->devtype, "multifpgapci") == 0)
+			get_device_table_cached(data_attr->devname, &data_attr->devptr, &data_attr->devgen);
 			
-		dy_ptr = (struct sensor_device_attribute *)kzalloc(sizeof(struct sensor_device_attribute)+ATTR_NAME_LEN, GFP_KERNEL);
-        dy_ptr->dev_attr.attr.name = (char *)&dy_ptr[1];
-        strcpy((char *)dy_ptr->dev_attr.attr.name, data_attr->aname);
+		bound = kzalloc(sizeof(struct fan_sysfs_attr), GFP_KERNEL);
+		bound->idx = i;
+		dy_ptr = &bound->sda;
+        dy_ptr->dev_attr.attr.name = bound->name;
+        strcpy(bound->name, data_attr->aname);
         dy_ptr->dev_attr.attr.mode = sysfs_data_entry->a_ptr->mode;
         dy_ptr->dev_attr.show = sysfs_data_entry->a_ptr->show;
         dy_ptr->dev_attr.store = sysfs_data_entry->a_ptr->store;
@@ -472,15 +489,19 @@ static int pddf_fan_probe(struct i2c_client *client)
         strcpy(data->attr_info[i].name, data_attr->aname);
         data->attr_info[i].valid = 0;
 		mutex_init(&data->attr_info[i].update_lock);
+		seqlock_init(&data->attr_info[i].snap_lock);
+		data->attr_info[i].bound = 1;
 
 		/*Create a duplicate entry i.e. show, store funcs etc and other access data is same as data_attr->aname*/
         idx = dy_ptr->index;
 		get_fan_duplicate_sysfs(idx, new_duplicate_str);
 		if (strcmp(new_duplicate_str,""))
 		{
-			dy_ptr = (struct sensor_device_attribute *)kzalloc(sizeof(struct sensor_device_attribute)+ATTR_NAME_LEN, GFP_KERNEL);
-			dy_ptr->dev_attr.attr.name = (char *)&dy_ptr[1];
-			strcpy((char *)dy_ptr->dev_attr.attr.name, new_duplicate_str);
+			bound = kzalloc(sizeof(struct fan_sysfs_attr), GFP_KERNEL);
+			bound->idx = i;
+			dy_ptr = &bound->sda;
+			dy_ptr->dev_attr.attr.name = bound->name;
+			strcpy(bound->name, new_duplicate_str);
 			dy_ptr->dev_attr.attr.mode = sysfs_data_entry->a_ptr->mode;
 			dy_ptr->dev_attr.show = sysfs_data_entry->a_ptr->show;
 			dy_ptr->dev_attr.store = sysfs_data_entry->a_ptr->store;
@@ -500,9 +521,12 @@ static int pddf_fan_probe(struct i2c_client *client)
                 printk(KERN_ERR "%s: Invalid name for extra default attribute '%s'. No access data exists\n", __FUNCTION__, new_default_str);
                 continue;
             }
-			dy_ptr = (struct sensor_device_attribute *)kzalloc(sizeof(struct sensor_device_attribute)+ATTR_NAME_LEN, GFP_KERNEL);
-			dy_ptr->dev_attr.attr.name = (char *)&dy_ptr[1];
-			strcpy((char *)dy_ptr->dev_attr.attr.name, new_default_str);
+			/* Extra defaults are derived from other attributes and have no slot of their own */
+			bound = kzalloc(sizeof(struct fan_sysfs_attr), GFP_KERNEL);
+			bound->idx = -1;
+			dy_ptr = &bound->sda;
+			dy_ptr->dev_attr.attr.name = bound->name;
+			strcpy(bound->name, new_default_str);
 			dy_ptr->dev_attr.attr.mode = extra_sysfs_data_entry->a_ptr->mode;
 			dy_ptr->dev_attr.show = extra_sysfs_data_entry->a_ptr->show;
 			dy_ptr->dev_attr.store = extra_sysfs_data_entry->a_ptr->store;
@@ -512,6 +536,7 @@ static int pddf_fan_probe(struct i2c_client *client)
             strcpy(data->attr_info[num+j].name, new_default_str);
             data->attr_info[num+j].valid = 0;
 		    mutex_init(&data->attr_info[num+j].update_lock);
+		    seqlock_init(&data->attr_info[num+j].snap_lock);
 			j++;
 			strcpy(new_default_str, "");
 		}
@@ -525,6 +550,12 @@ static int pddf_fan_probe(struct i2c_client *client)
         goto exit_free;
     }
 
+    data->fan_cache_cfg_group.attrs = fan_cache_cfg_attributes;
+    status = sysfs_create_group(&client->dev.kobj, &data->fan_cache_cfg_group);
+    if (status) {
+        goto exit_remove_attrs;
+    }
+
     data->hwmon_dev = hwmon_device_register_with_groups(&client->dev, client->name, NULL, NULL);
     if (IS_ERR(data->hwmon_dev)) {
         status = PTR_ERR(data->hwmon_dev);
@@ -546,6 +577,9 @@ static int pddf_fan_probe(struct i2c_client *client)
 	return 0;
 
 exit_remove:
+    sysfs_remove_group(&client->dev.kobj, &data->fan_cache_cfg_group);
+    fan_refresh_set(client, 0);
+exit_remove_attrs:
     sysfs_remove_group(&client->dev.kobj, &data->fan_attribute_group);
 exit_free:
 	/* Free all the allocated attributes */
@@ -575,6 +609,9 @@ static void pddf_fan_remove(struct i2c_client *client)
 			printk(KERN_ERR "FAN pre_remove function failed\n");
 	}
 
+    /* Remove the tunables first so that no store can restart the refresh thread */
+    sysfs_remove_group(&client->dev.kobj, &data->fan_cache_cfg_group);
+    fan_refresh_set(client, 0);
     hwmon_device_unregister(data->hwmon_dev);
     sysfs_remove_group(&client->dev.kobj, &data->fan_attribute_group);
     for (i=0; data->fan_attribute_list[i]!=NULL; i++)
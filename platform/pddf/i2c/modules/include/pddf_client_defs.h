@@ -130,12 +130,36 @@ struct pddf_ops_t
 typedef struct PDEVICE
 {
     struct hlist_node node;
+    struct rcu_head rcu;
+    u32 hash;
     char name[GEN_NAME_SIZE];
     void *data;
 
 }PDEVICE;
 
 void add_device_table(char *name, void *ptr);
+void *get_device_table(char *name);
+void delete_device_table(char *name);
+unsigned int get_device_table_gen(void);
+
+/*
+ * Return the device table entry for name cached in *devptr. The entry is
+ * looked up again if it was not found before, or if any entry has been
+ * deleted since it was cached, so a deleted device is never handed out.
+ */
+static inline void *get_device_table_cached(char *name, void **devptr, unsigned int *devgen)
+{
+    unsigned int gen = get_device_table_gen();
+    void *ptr;
+
+    if (READ_ONCE(*devgen) == gen && (ptr = READ_ONCE(*devptr)) != NULL)
+        return ptr;
+
+    ptr = get_device_table(name);
+    WRITE_ONCE(*devptr, ptr);
+    WRITE_ONCE(*devgen, gen);
+    return ptr;
+}
 
 
 #endif
@@ -30,6 +30,9 @@ extern ssize_t fan_show_default(struct device *dev, struct device_attribute *da,
 extern ssize_t fan_store_default(struct device *dev, struct device_attribute *da, const char *buf, size_t count);
 extern ssize_t fan_show_status(struct device *dev, struct device_attribute *da, char *buf);
 extern ssize_t fan_show_string(struct device *dev, struct device_attribute *da, char *buf);
+extern ssize_t fan_show_cache_cfg(struct device *dev, struct device_attribute *da, char *buf);
+extern ssize_t fan_store_cache_cfg(struct device *dev, struct device_attribute *da, const char *buf, size_t count);
+extern int fan_refresh_set(struct i2c_client *client, int refresh_ms);
 
 
 extern int sonic_i2c_get_fan_present_default(void *client, FAN_DATA_ATTR *adata, void *data);
@@ -43,6 +43,8 @@ typedef struct FAN_DATA_ATTR
     int mult;                       // Multiplication factor to get the actual data
     uint8_t is_divisor;                     // Check if the value is a divisor and mult is dividend
     void *access_data;
+    void *devptr;                   // Handle of devname, resolved once at probe time
+    unsigned int devgen;            // Device table generation devptr was resolved in
 }FAN_DATA_ATTR;
 
 typedef struct FAN_SYSFS_ATTR_DATA
@@ -123,26 +123,53 @@ enum fan_sysfs_attributes {
     FAN_HW_VERSION,
 	FAN_MAX_ATTR 
 };
+union fan_attr_val {
+    char strval[STR_ATTR_SIZE];
+    int  intval;
+    u16  shortval;
+    u8   charval;
+};
+
 /* Each client has this additional data */
 struct fan_attr_info {
 	char				name[ATTR_NAME_LEN];
     struct mutex		update_lock;
     char				valid;           /* != 0 if registers are valid */
     unsigned long		last_updated;    /* In jiffies */
-	union {
-        char strval[STR_ATTR_SIZE];
-        int  intval;
-        u16  shortval;
-        u8   charval;
-    }val;
+	char				bound;           /* != 0 if a sysfs attribute uses this slot */
+	union fan_attr_val	val;
+	/* Copy of val published after every update, readable without update_lock */
+	seqlock_t			snap_lock;
+	char				snap_valid;
+	unsigned long		snap_updated;    /* In jiffies */
+	union fan_attr_val	snap;
+};
+
+/* Sysfs attribute created at probe time, bound to its fan_attrs/attr_info slot (-1 if none) */
+struct fan_sysfs_attr {
+	struct sensor_device_attribute	sda;
+	int								idx;
+	char							name[ATTR_NAME_LEN];
+};
+
+/* Index of the per client telemetry cache tunables */
+enum fan_cache_cfg {
+	FAN_CACHE_MAX_AGE_MS,
+	FAN_CACHE_REFRESH_MS
 };
 
+#define FAN_DEFAULT_MAX_AGE_MS	1500
 struct fan_data {
     struct device			*hwmon_dev;
 	int						num_attr;
 	struct attribute		*fan_attribute_list[MAX_FAN_ATTRS];
 	struct attribute_group	fan_attribute_group;
+	struct attribute_group	fan_cache_cfg_group;
 	struct fan_attr_info	attr_info[MAX_FAN_ATTRS];
+	int						max_age_ms;		/* oldest value served without a bus access */
+	int						refresh_ms;		/* period of refresh_task, 0 when it is not running */
+	struct task_struct		*refresh_task;	/* optional kthread reading all the telemetry in one burst */
+	struct mutex			refresh_lock;
 };
 
 #endif
@@ -87,6 +87,19 @@ extern struct pddf_multi_fpgapci_ops_t pddf_multi_fpgapci_ops;
 extern int (*ptr_multifpgapci_readpci)(struct pci_dev *, uint32_t, uint32_t *);
 extern int (*ptr_multifpgapci_writepci)(struct pci_dev *, uint32_t, uint32_t);
 
+// One register of a batched access. Reads return (reg & mask) in val, writes
+// only update the bits set in mask.
+struct multifpgapci_reg_op {
+	uint32_t offset;
+	uint32_t mask;
+	uint32_t val;
+};
+
+extern int multifpgapci_readpci_batch(struct pci_dev *pci_dev,
+				      struct multifpgapci_reg_op *ops, int num);
+extern int multifpgapci_writepci_batch(struct pci_dev *pci_dev,
+				       struct multifpgapci_reg_op *ops, int num);
+
 extern int multifpgapci_register_protocol(const char *name,
 					  struct protocol_ops *ops);
 extern void multifpgapci_unregister_protocol(const char *name);
@@ -23,6 +23,9 @@
 extern void get_psu_duplicate_sysfs(int idx, char *str);
 extern ssize_t psu_show_default(struct device *dev, struct device_attribute *da, char *buf);
 extern ssize_t psu_store_default(struct device *dev, struct device_attribute *da, const char *buf, size_t count);
+extern ssize_t psu_show_cache_cfg(struct device *dev, struct device_attribute *da, char *buf);
+extern ssize_t psu_store_cache_cfg(struct device *dev, struct device_attribute *da, const char *buf, size_t count);
+extern int psu_refresh_set(struct i2c_client *client, int refresh_ms);
 
 extern int sonic_i2c_get_psu_byte_default(void *client, PSU_DATA_ATTR *adata, void *data);
 extern int sonic_i2c_get_psu_block_default(void *client, PSU_DATA_ATTR *adata, void *data);
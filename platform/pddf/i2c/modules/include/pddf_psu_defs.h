@@ -47,6 +47,8 @@ typedef struct PSU_DATA_ATTR
     int b;
     int r;
     void *access_data;
+    void *devptr;                   // Handle of devname, resolved once at probe time
+    unsigned int devgen;            // Device table generation devptr was resolved in
 }PSU_DATA_ATTR;
 
 typedef struct PSU_SYSFS_ATTR_DATA
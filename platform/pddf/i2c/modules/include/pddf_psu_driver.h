@@ -46,6 +46,13 @@ enum psu_sysfs_attributes {
 };
 
 
+union psu_attr_val {
+	char strval[STR_ATTR_SIZE];
+	int	 intval;
+	u16	 shortval;
+	u8   charval;
+};
+
 /* Every client has psu_data which is divided into per attribute data */
 struct psu_attr_info {
 	char				name[ATTR_NAME_LEN];
@@ -53,13 +60,29 @@ struct psu_attr_info {
     char                valid;           /* !=0 if registers are valid */
     unsigned long       last_updated;    /* In jiffies */
 	u8					status;
-	union {
-		char strval[STR_ATTR_SIZE];
-		int	 intval;
-		u16	 shortval;
-		u8   charval;
-	}val;
+	char				bound;           /* != 0 if a sysfs attribute uses this slot */
+	union psu_attr_val	val;
+	/* Copy of val published after every update, readable without update_lock */
+	seqlock_t			snap_lock;
+	char				snap_valid;
+	unsigned long		snap_updated;    /* In jiffies */
+	union psu_attr_val	snap;
+};
+
+/* Sysfs attribute created at probe time, bound to its psu_attrs/attr_info slot */
+struct psu_sysfs_attr {
+	struct sensor_device_attribute	sda;
+	int								idx;
+	char							name[ATTR_NAME_LEN];
 };
+
+/* Index of the per client telemetry cache tunables */
+enum psu_cache_cfg {
+	PSU_CACHE_MAX_AGE_MS,
+	PSU_CACHE_REFRESH_MS
+};
+
+#define PSU_DEFAULT_MAX_AGE_MS	1500
 struct psu_data {
 	struct device			*hwmon_dev;
 	u8						index;
@@ -75,7 +98,12 @@ struct psu_data {
 	int						num_attr;
 	struct attribute		*psu_attribute_list[MAX_PSU_ATTRS];
 	struct attribute_group	psu_attribute_group;
+	struct attribute_group	psu_cache_cfg_group;
 	struct psu_attr_info	attr_info[MAX_PSU_ATTRS];
+	int						max_age_ms;		/* oldest value served without a bus access */
+	int						refresh_ms;		/* period of refresh_task, 0 when it is not running */
+	struct task_struct		*refresh_task;	/* optional kthread reading all the telemetry in one burst */
+	struct mutex			refresh_lock;
 };
 
 
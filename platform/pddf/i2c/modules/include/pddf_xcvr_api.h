@@ -41,4 +41,29 @@ extern ssize_t get_module_txdisable(struct device *dev, struct device_attribute
 extern ssize_t set_module_txdisable(struct device *dev, struct device_attribute *da, const char *buf, size_t count);
 extern ssize_t get_module_txfault(struct device *dev, struct device_attribute *da, char *buf);
 
+extern int xcvr_read_attr_reg(XCVR_ATTR *info, int *val);
+extern void xcvr_bulk_register(struct i2c_client *client, int port);
+extern void xcvr_bulk_unregister(struct i2c_client *client, int port);
+extern ssize_t get_xcvr_bulk_status(struct device *dev, struct device_attribute *da, char *buf);
+extern ssize_t get_xcvr_bulk_stats(struct device *dev, struct device_attribute *da, char *buf);
+extern ssize_t get_xcvr_bus_stats(struct device *dev, struct device_attribute *da, char *buf);
+extern ssize_t store_xcvr_tunable(struct device *dev, struct device_attribute *da, const char *buf, size_t count);
+extern int xcvr_bus_stats_init(void);
+extern void xcvr_bus_stats_exit(void);
+extern int xcvr_bulk_max_age_ms;
+extern int xcvr_retry_count;
+extern int xcvr_retry_min_us;
+extern int xcvr_retry_max_us;
+extern int xcvr_block_read;
+
+extern int xcvr_event_start(struct kobject *kobj);
+extern void xcvr_event_stop(void);
+extern ssize_t get_xcvr_event(struct device *dev, struct device_attribute *da, char *buf);
+extern ssize_t set_xcvr_event_ops(struct device *dev, struct device_attribute *da, const char *buf, size_t count);
+extern int xcvr_event_irq;
+extern int xcvr_event_irq_trigger;
+extern int xcvr_event_gpio;
+extern int xcvr_event_poll_ms;
+extern int xcvr_event_debounce_ms;
+
 #endif
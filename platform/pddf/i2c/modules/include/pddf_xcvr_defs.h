@@ -23,6 +23,9 @@
 
 #define MAX_NUM_XCVR 5
 #define MAX_XCVR_ATTRS 20
+#define XCVR_BULK_MAX_PORTS 256     // ports covered by the chassis-wide status bitmaps
+#define XCVR_BULK_MAX_REGS 64       // distinct status registers cached during one bulk sweep
+#define XCVR_BUS_STATS_MAX 32       // i2c buses the retry policy and counters are kept for
 
 typedef struct XCVR_ATTR
 {
@@ -34,6 +37,8 @@ typedef struct XCVR_ATTR
     uint32_t mask;
     uint32_t cmpval;
     uint32_t len;
+    void *devptr;           // handle of devname, resolved once at probe time
+    unsigned int devgen;    // device table generation devptr was resolved in
 
     int (*pre_access)(void *client, void *data);
     int (*do_access)(void *client, void *data);
@@ -72,6 +77,17 @@ typedef enum xcvr_port_type_e {
     PDDF_PORT_TYPE_QSFP28
 } xcvr_port_type_t;
 
+enum xcvr_sysfs_attributes {
+    XCVR_PRESENT,
+    XCVR_RESET,
+    XCVR_INTR_STATUS,
+    XCVR_LPMODE,
+    XCVR_RXLOS,
+    XCVR_TXDISABLE,
+    XCVR_TXFAULT,
+    XCVR_ATTR_MAX
+};
+
 /* Each client has this additional data
  */
 struct xcvr_data {
@@ -88,6 +104,7 @@ struct xcvr_data {
     uint32_t            rxlos;
     uint32_t            txdisable;
     uint32_t            txfault;
+    XCVR_ATTR           *attrs[XCVR_ATTR_MAX];  /* platform attr data, indexed by xcvr_sysfs_attributes */
 };
 
 typedef struct XCVR_SYSFS_ATTR_OPS
@@ -103,15 +120,30 @@ typedef struct XCVR_SYSFS_ATTR_OPS
     int (*post_set)(struct i2c_client *client, XCVR_ATTR *adata, struct xcvr_data *data);
 } XCVR_SYSFS_ATTR_OPS;
 
-enum xcvr_sysfs_attributes {
-    XCVR_PRESENT,
-    XCVR_RESET,
-    XCVR_INTR_STATUS,
-    XCVR_LPMODE,
-    XCVR_RXLOS,
-    XCVR_TXDISABLE,
-    XCVR_TXFAULT,
-    XCVR_ATTR_MAX
+/* Chassis-wide snapshot of one status bit across all the registered ports */
+struct xcvr_bulk_snapshot {
+    unsigned long       bitmap[BITS_TO_LONGS(XCVR_BULK_MAX_PORTS)];
+    int                 nports;          /* highest registered port index + 1 */
+    char                valid;           /* !=0 if bitmap is valid */
+    unsigned long       last_updated;    /* In jiffies */
+};
+
+/* Accepted values of an integer tunable, stored through store_xcvr_tunable() */
+struct xcvr_tunable_range {
+    int                 min;
+    int                 max;
+};
+
+/* Retry policy state and counters of one i2c bus carrying xcvr status registers */
+struct xcvr_bus_stats {
+    int                 nr;              /* i2c adapter number, -1 if the slot is unused */
+    unsigned int        backoff_us;      /* first retry delay, doubles while the bus keeps failing */
+    unsigned long       reads;
+    unsigned long       block_reads;
+    unsigned long       retries;
+    unsigned long       errors;          /* reads that failed after all retries */
+    u64                 total_ns;
+    u64                 max_ns;
 };
 
 extern int board_i2c_cpld_read_new(unsigned short cpld_addr, char *name, u8 reg);
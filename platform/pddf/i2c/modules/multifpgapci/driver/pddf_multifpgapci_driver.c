@@ -33,6 +33,7 @@
 #include <linux/kdev_t.h>
 #include <linux/kernel.h>
 #include <linux/kobject.h>
+#include <linux/kref.h>
 #include <linux/list.h>
 #include <linux/module.h>
 #include <linux/moduleparam.h>
@@ -112,6 +113,8 @@ struct fpga_data_node {
 	void __iomem *fpga_ctl_addr;
 	unsigned long bar_start;
 	struct list_head list;
+	struct kref ref;	// held by fpga_list and by get_fpga_data_node() callers
+	struct rcu_head rcu;
 
 	// sysfs attrs
 	struct pddf_attrs attrs;
@@ -243,6 +246,112 @@ int default_multifpgapci_writepci(struct pci_dev *pci_dev, uint32_t val,
 	return 0;
 }
 
+static void __iomem *multifpgapci_batch_base(struct pci_dev *pci_dev)
+{
+	struct pddf_multifpgapci_drvdata *pci_drvdata;
+
+	if (!pci_dev)
+		return NULL;
+
+	pci_drvdata = dev_get_drvdata(&pci_dev->dev);
+	if (!pci_drvdata || !pci_drvdata->bar_initialized)
+		return NULL;
+
+	return pci_drvdata->fpga_data_base_addr;
+}
+
+// Read a vector of registers in one pass. The accesses are issued relaxed and
+// ordered against later memory accesses by a single barrier at the end.
+// A platform that overrides ptr_multifpgapci_readpci gets one call per register.
+int multifpgapci_readpci_batch(struct pci_dev *pci_dev,
+			       struct multifpgapci_reg_op *ops, int num)
+{
+	void __iomem *base;
+	uint32_t val;
+	int i, ret;
+
+	if (!ops || num < 0)
+		return -EINVAL;
+
+	if (ptr_multifpgapci_readpci != default_multifpgapci_readpci) {
+		for (i = 0; i < num; i++) {
+			ret = ptr_multifpgapci_readpci(pci_dev, ops[i].offset,
+						       &val);
+			if (ret)
+				return ret;
+			ops[i].val = val & ops[i].mask;
+		}
+		return 0;
+	}
+
+	base = multifpgapci_batch_base(pci_dev);
+	if (!base) {
+		pddf_dbg(MULTIFPGA, KERN_ERR "%s pci bar not initialized\n",
+			 __FUNCTION__);
+		return -ENODEV;
+	}
+
+	for (i = 0; i < num; i++)
+		ops[i].val = readl_relaxed(base + ops[i].offset) & ops[i].mask;
+	rmb();
+
+	return 0;
+}
+EXPORT_SYMBOL(multifpgapci_readpci_batch);
+
+// Write a vector of registers in one pass, read-modify-write for partial
+// masks. A single barrier orders the batch after earlier memory accesses.
+int multifpgapci_writepci_batch(struct pci_dev *pci_dev,
+				struct multifpgapci_reg_op *ops, int num)
+{
+	void __iomem *base;
+	uint32_t val;
+	int i, ret;
+
+	if (!ops || num < 0)
+		return -EINVAL;
+
+	if (ptr_multifpgapci_readpci != default_multifpgapci_readpci ||
+	    ptr_multifpgapci_writepci != default_multifpgapci_writepci) {
+		for (i = 0; i < num; i++) {
+			val = ops[i].val & ops[i].mask;
+			if (ops[i].mask != 0xffffffff) {
+				uint32_t cur;
+
+				ret = ptr_multifpgapci_readpci(
+					pci_dev, ops[i].offset, &cur);
+				if (ret)
+					return ret;
+				val |= cur & ~ops[i].mask;
+			}
+			ret = ptr_multifpgapci_writepci(pci_dev, val,
+							ops[i].offset);
+			if (ret)
+				return ret;
+		}
+		return 0;
+	}
+
+	base = multifpgapci_batch_base(pci_dev);
+	if (!base) {
+		pddf_dbg(MULTIFPGA, KERN_ERR "%s pci bar not initialized\n",
+			 __FUNCTION__);
+		return -ENODEV;
+	}
+
+	wmb();
+	for (i = 0; i < num; i++) {
+		val = ops[i].val & ops[i].mask;
+		if (ops[i].mask != 0xffffffff)
+			val |= readl_relaxed(base + ops[i].offset) &
+			       ~ops[i].mask;
+		writel_relaxed(val, base + ops[i].offset);
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(multifpgapci_writepci_batch);
+
 void free_pci_drvdata(struct pci_dev *pci_dev)
 {
 	pci_set_drvdata(pci_dev, NULL);
@@ -257,6 +366,31 @@ void free_sysfs_attr_groups(struct fpga_data_node *node)
 		sysfs_remove_group(node->kobj, &pddf_clients_data_group);
 }
 
+static void release_fpga_data_node(struct kref *ref)
+{
+	struct fpga_data_node *node =
+		container_of(ref, struct fpga_data_node, ref);
+
+	KOBJ_FREE(node->kobj);
+	// Lock-free lookups may still be looking at the node
+	kfree_rcu(node, rcu);
+}
+
+static void put_fpga_data_node(struct fpga_data_node *node)
+{
+	kref_put(&node->ref, release_fpga_data_node);
+}
+
+// Tear down a node already unlinked from fpga_list and drop the list reference
+static void cleanup_fpga_data_node(struct fpga_data_node *node)
+{
+	detach_protocols_for_fpga(node->dev, node->kobj);
+	free_pci_drvdata(node->dev);
+	// Waits for sysfs stores, which may hold a reference, to finish
+	free_sysfs_attr_groups(node);
+	put_fpga_data_node(node);
+}
+
 void delete_fpga_data_node(const char *bdf)
 {
 	struct fpga_data_node *node, *tmp_node;
@@ -267,7 +401,7 @@ void delete_fpga_data_node(const char *bdf)
 	mutex_lock(&fpga_list_lock);
 	list_for_each_entry_safe(node, tmp_node, &fpga_list, list) {
 		if (strcmp(node->bdf, bdf) == 0) {
-			list_del(&node->list);
+			list_del_rcu(&node->list);
 			found_node = node;
 			break;
 		}
@@ -277,65 +411,73 @@ void delete_fpga_data_node(const char *bdf)
 	if (!found_node)
 		return;
 
-	// Cleanup
-	detach_protocols_for_fpga(found_node->dev, found_node->kobj);
-	free_pci_drvdata(found_node->dev);
-	free_sysfs_attr_groups(found_node);
-	KOBJ_FREE(found_node->kobj);
-	kfree(found_node);
+	cleanup_fpga_data_node(found_node);
 }
 
 void delete_all_fpga_data_nodes(void)
 {
-	struct fpga_data_node *node, *tmp;
-	struct list_head local_list;
+	struct fpga_data_node *node;
 
-	// Clear the global list after moving it to local
-	mutex_lock(&fpga_list_lock);
-	list_replace_init(&fpga_list, &local_list);
-	mutex_unlock(&fpga_list_lock);
+	// Unlink one node at a time, readers may still walk the list
+	for (;;) {
+		mutex_lock(&fpga_list_lock);
+		node = list_first_entry_or_null(&fpga_list,
+						struct fpga_data_node, list);
+		if (node)
+			list_del_rcu(&node->list);
+		mutex_unlock(&fpga_list_lock);
 
-	// Work on the local copy without the need for a lock
-	list_for_each_entry_safe(node, tmp, &local_list, list) {
-		detach_protocols_for_fpga(node->dev, node->kobj);
-		free_pci_drvdata(node->dev);
-		free_sysfs_attr_groups(node);
-		KOBJ_FREE(node->kobj);
-		kfree(node);
+		if (!node)
+			break;
+		cleanup_fpga_data_node(node);
 	}
 }
 
-struct fpga_data_node *get_fpga_data_node(const char *bdf)
+// Caller must hold rcu_read_lock() or fpga_list_lock
+static struct fpga_data_node *__get_fpga_data_node(const char *bdf)
 {
 	struct fpga_data_node *node;
-	struct fpga_data_node *found_node = NULL;
 
-	mutex_lock(&fpga_list_lock);
-
-	list_for_each_entry(node, &fpga_list, list) {
-		if (strcmp(node->bdf, bdf) == 0) {
-			found_node = node;
-			break;
-		}
+	list_for_each_entry_rcu(node, &fpga_list, list,
+				lockdep_is_held(&fpga_list_lock)) {
+		if (strcmp(node->bdf, bdf) == 0)
+			return node;
 	}
 
-	mutex_unlock(&fpga_list_lock);
+	return NULL;
+}
+
+// Returns the node with a reference held, release it with put_fpga_data_node()
+struct fpga_data_node *get_fpga_data_node(const char *bdf)
+{
+	struct fpga_data_node *found_node;
+
+	rcu_read_lock();
+	found_node = __get_fpga_data_node(bdf);
+	if (found_node && !kref_get_unless_zero(&found_node->ref))
+		found_node = NULL;
+	rcu_read_unlock();
 
 	return found_node;
 }
 
 void __iomem *get_fpga_ctl_addr_impl(const char *bdf)
 {
-	struct fpga_data_node *node = get_fpga_data_node(bdf);
+	struct fpga_data_node *node;
+	void __iomem *addr = NULL;
+
+	rcu_read_lock();
+	node = __get_fpga_data_node(bdf);
+	if (node)
+		addr = node->fpga_ctl_addr;
+	rcu_read_unlock();
 
-	if (!node) {
+	if (!node)
 		pddf_dbg(MULTIFPGA,
 			 KERN_ERR "[%s] No matching fpga data node\n",
 			 __FUNCTION__);
-		return NULL;
-	}
 
-	return node->fpga_ctl_addr;
+	return addr;
 }
 
 void __iomem *(*get_fpga_ctl_addr)(const char *bdf) = get_fpga_ctl_addr_impl;
@@ -362,6 +504,7 @@ static int pddf_pci_add_fpga(char *bdf, struct pci_dev *dev)
 	}
 
 	fpga_data->dev = dev;
+	kref_init(&fpga_data->ref);
 
 	PDDF_DATA_ATTR(
 		dev_ops, S_IWUSR | S_IRUGO, NULL, dev_operation,
@@ -376,7 +519,7 @@ static int pddf_pci_add_fpga(char *bdf, struct pci_dev *dev)
 
 	// Add to FPGA list
 	mutex_lock(&fpga_list_lock);
-	list_add(&fpga_data->list, &fpga_list);
+	list_add_rcu(&fpga_data->list, &fpga_list);
 	mutex_unlock(&fpga_list_lock);
 
 	// Attach all registered protocols to this new FPGA
@@ -406,8 +549,12 @@ free_fpga_attr_group:
 	sysfs_remove_group(fpga_data->kobj, &fpga_data->fpga_attr_group);
 	fpga_data->fpga_attr_group_initialized = false;
 free_fpga_kobj:
-	attach_protocols_for_fpga(dev, fpga_data->kobj);
-	kobject_put(fpga_data->kobj);
+	detach_protocols_for_fpga(dev, fpga_data->kobj);
+	mutex_lock(&fpga_list_lock);
+	list_del_rcu(&fpga_data->list);
+	mutex_unlock(&fpga_list_lock);
+	put_fpga_data_node(fpga_data);
+	return ret;
 free_fpga_data:
 	kfree(fpga_data);
 	return ret;
@@ -594,6 +741,7 @@ ssize_t dev_operation(struct device *dev, struct device_attribute *da,
 		if (cdata->i2c_name[0] == 0) {
 			pddf_dbg(MULTIFPGA, KERN_ERR "[%s] no i2c_name specified\n",
 					 __FUNCTION__);
+			put_fpga_data_node(fpga_node);
 			return -EINVAL;
 		}
 
@@ -607,6 +755,7 @@ ssize_t dev_operation(struct device *dev, struct device_attribute *da,
 		add_device_table(fpga_node->dev_name, (void *)pci_dev_get(pci_dev));
 
 		ret = fpgapci_init(pci_dev, fpga_node, n_msi_vectors, reg_width);
+		put_fpga_data_node(fpga_node);
 		if (ret)
 			return ret;
 
@@ -726,6 +875,7 @@ static int map_bars(const char *bdf,
 	} else {
 		pddf_dbg(MULTIFPGA, KERN_INFO "[%s] Failed to find BAR\n",
 			 __FUNCTION__);
+		put_fpga_data_node(fpga_node);
 		return -1;
 	}
 
@@ -737,6 +887,7 @@ static int map_bars(const char *bdf,
 		 pci_privdata->fpga_data_base_addr, FPGAPCI_BAR_INDEX,
 		 pci_privdata->bar_length, barStart);
 
+	put_fpga_data_node(fpga_node);
 	return 0;
 }
 
@@ -1085,6 +1236,7 @@ static void detach_protocols_for_all_fpgas(struct protocol_module *proto)
 			if (fpga_node) {
 				proto->ops->detach(pci_entry->pci_dev,
 						   fpga_node->kobj);
+				put_fpga_data_node(fpga_node);
 			}
 		}
 		kfree(pci_entry);
@@ -29,6 +29,9 @@
 #include <linux/delay.h>
 #include <linux/dmi.h>
 #include <linux/kobject.h>
+#include <linux/kthread.h>
+#include <linux/seqlock.h>
+#include "pddf_client_defs.h"
 #include "pddf_multifpgapci_defs.h"
 #include "pddf_psu_defs.h"
 #include "pddf_psu_driver.h"
@@ -122,15 +125,16 @@ int psu_update_hw(struct device *dev, struct psu_attr_info *info, PSU_DATA_ATTR
 }
 
 
-int psu_update_attr(struct device *dev, struct psu_attr_info *data, PSU_DATA_ATTR *udata)
+static int __psu_update_attr(struct device *dev, struct psu_attr_info *data, PSU_DATA_ATTR *udata, int force)
 {
     int status = 0;
     struct i2c_client *client = to_i2c_client(dev);
+    struct psu_data *psu = i2c_get_clientdata(client);
     PSU_SYSFS_ATTR_DATA *sysfs_attr_data=NULL;
 
     mutex_lock(&data->update_lock);
 
-    if (time_after(jiffies, data->last_updated + HZ + HZ / 2) || !data->valid)
+    if (force || time_after(jiffies, data->last_updated + msecs_to_jiffies(psu->max_age_ms)) || !data->valid)
     {
         dev_dbg(&client->dev, "Starting update for %s\n", data->name);
 
@@ -157,12 +161,141 @@ int psu_update_attr(struct device *dev, struct psu_attr_info *data, PSU_DATA_ATT
 
         data->last_updated = jiffies;
         data->valid = 1;
+
+        write_seqlock(&data->snap_lock);
+        data->snap = data->val;
+        data->snap_updated = data->last_updated;
+        data->snap_valid = 1;
+        write_sequnlock(&data->snap_lock);
     }
 
     mutex_unlock(&data->update_lock);
     return 0;
 }
 
+int psu_update_attr(struct device *dev, struct psu_attr_info *data, PSU_DATA_ATTR *udata)
+{
+    return __psu_update_attr(dev, data, udata, 0);
+}
+
+/* Copy the last published value of an attribute. Returns 0 if it is younger than max_age_ms */
+static int psu_get_snapshot(struct psu_attr_info *info, int max_age_ms, union psu_attr_val *val)
+{
+    unsigned int seq;
+    unsigned long updated;
+    char valid;
+
+    do {
+        seq = read_seqbegin(&info->snap_lock);
+        *val = info->snap;
+        updated = info->snap_updated;
+        valid = info->snap_valid;
+    } while (read_seqretry(&info->snap_lock, seq));
+
+    if (!valid || time_after(jiffies, updated + msecs_to_jiffies(max_age_ms)))
+        return -EAGAIN;
+
+    return 0;
+}
+
+/* Telemetry refresh kthread: reads every attribute of the PSU in one burst */
+static int psu_refresh_thread(void *arg)
+{
+    struct i2c_client *client = (struct i2c_client *)arg;
+    struct psu_data *data = i2c_get_clientdata(client);
+    PSU_PDATA *pdata = (PSU_PDATA *)(client->dev.platform_data);
+    PSU_SYSFS_ATTR_DATA *ptr = NULL;
+    int i;
+
+    while (!kthread_should_stop())
+    {
+        for (i = 0; i < data->num_attr && !kthread_should_stop(); i++)
+        {
+            /* Skipped or unknown attributes have no sysfs entry and no locks */
+            if (!data->attr_info[i].bound)
+                continue;
+            ptr = (PSU_SYSFS_ATTR_DATA *)pdata->psu_attrs[i].access_data;
+            if (ptr == NULL || ptr->do_get == NULL)
+                continue;
+            /* Inventory strings don't change at runtime, leave them to on-demand reads */
+            if (ptr->index == PSU_MODEL_NAME || ptr->index == PSU_MFR_ID ||
+                ptr->index == PSU_SERIAL_NUM || ptr->index == PSU_FAN_DIR)
+                continue;
+            __psu_update_attr(&client->dev, &data->attr_info[i], &pdata->psu_attrs[i], 1);
+        }
+
+        set_current_state(TASK_INTERRUPTIBLE);
+        if (!kthread_should_stop())
+            schedule_timeout(msecs_to_jiffies(data->refresh_ms));
+        __set_current_state(TASK_RUNNING);
+    }
+
+    return 0;
+}
+
+int psu_refresh_set(struct i2c_client *client, int refresh_ms)
+{
+    struct psu_data *data = i2c_get_clientdata(client);
+    int status = 0;
+
+    if (refresh_ms < 0)
+        return -EINVAL;
+
+    mutex_lock(&data->refresh_lock);
+    if (data->refresh_task)
+    {
+        kthread_stop(data->refresh_task);
+        data->refresh_task = NULL;
+    }
+    data->refresh_ms = refresh_ms;
+    if (refresh_ms > 0)
+    {
+        data->refresh_task = kthread_run(psu_refresh_thread, client, "pddf_psu%d", data->index + 1);
+        if (IS_ERR(data->refresh_task))
+        {
+            status = PTR_ERR(data->refresh_task);
+            data->refresh_task = NULL;
+            data->refresh_ms = 0;
+        }
+    }
+    mutex_unlock(&data->refresh_lock);
+
+    return status;
+}
+
+ssize_t psu_show_cache_cfg(struct device *dev, struct device_attribute *da, char *buf)
+{
+    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
+    struct psu_data *data = i2c_get_clientdata(to_i2c_client(dev));
+
+    return sprintf(buf, "%d\n", attr->index == PSU_CACHE_REFRESH_MS ? data->refresh_ms : data->max_age_ms);
+}
+
+ssize_t psu_store_cache_cfg(struct device *dev, struct device_attribute *da, const char *buf, size_t count)
+{
+    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
+    struct i2c_client *client = to_i2c_client(dev);
+    struct psu_data *data = i2c_get_clientdata(client);
+    int ret, val;
+
+    ret = kstrtoint(buf, 10, &val);
+    if (ret)
+        return ret;
+    if (val < 0)
+        return -EINVAL;
+
+    if (attr->index == PSU_CACHE_REFRESH_MS)
+    {
+        ret = psu_refresh_set(client, val);
+        if (ret)
+            return ret;
+    }
+    else
+        data->max_age_ms = val;
+
+    return count;
+}
+
 static u8 psu_get_vout_mode(struct i2c_client *client)
 {
     u8 status = 0, retry = 10;
@@ -277,16 +410,13 @@ static long pmbus_direct_to_int(s16 value, s32 m, s32 b, s32 R, int multiplier)
 
 static long get_real_world_value(struct i2c_client *client,
                                 PSU_DATA_ATTR *usr_data,
-                                struct psu_attr_info *sysfs_attr_info,
+                                u16 reg_value,
                                 const char *default_format,
                                 int multiplier)
 {
-    u16 reg_value;
     u8 vout_mode;
     const char *data_format;
 
-    reg_value = sysfs_attr_info->val.shortval;
-
     if (usr_data->data_format && usr_data->data_format[0] != '\0')
     {
         data_format = usr_data->data_format;
@@ -342,48 +472,46 @@ static long get_real_world_value(struct i2c_client *client,
 ssize_t psu_show_default(struct device *dev, struct device_attribute *da, char *buf)
 {
     struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
+    struct psu_sysfs_attr *bound = container_of(attr, struct psu_sysfs_attr, sda);
     struct i2c_client *client = to_i2c_client(dev);
     struct psu_data *data = i2c_get_clientdata(client);
     PSU_PDATA *pdata = (PSU_PDATA *)(client->dev.platform_data);
     PSU_DATA_ATTR *usr_data = NULL;
     struct psu_attr_info *sysfs_attr_info = NULL;
-    int i, status=0;
+    union psu_attr_val val;
+    int status=0;
     int multiplier = 1000;
-    char new_str[ATTR_NAME_LEN] = "";
-    PSU_SYSFS_ATTR_DATA *ptr = NULL;
-
-    for (i=0;i<data->num_attr;i++)
-    {
-        ptr = (PSU_SYSFS_ATTR_DATA *)pdata->psu_attrs[i].access_data;
-        get_psu_duplicate_sysfs(ptr->index , new_str);
-        if ( strcmp(attr->dev_attr.attr.name, pdata->psu_attrs[i].aname) == 0 || strcmp(attr->dev_attr.attr.name, new_str) == 0 )
-        {
-            sysfs_attr_info = &data->attr_info[i];
-            usr_data = &pdata->psu_attrs[i];
-            strcpy(new_str, "");
-        }
-    }
 
-    if (sysfs_attr_info==NULL || usr_data==NULL)
+    /* The attribute was bound to its data slot when it was created in probe */
+    if (bound->idx < 0 || bound->idx >= data->num_attr)
     {
         printk(KERN_ERR "%s is not supported attribute for this client\n", attr->dev_attr.attr.name);
         goto exit;
     }
+    sysfs_attr_info = &data->attr_info[bound->idx];
+    usr_data = &pdata->psu_attrs[bound->idx];
 
-    psu_update_attr(dev, sysfs_attr_info, usr_data);
+    /* Serve a recent enough value without touching the bus */
+    if (psu_get_snapshot(sysfs_attr_info, data->max_age_ms, &val) != 0)
+    {
+        psu_update_attr(dev, sysfs_attr_info, usr_data);
+        mutex_lock(&sysfs_attr_info->update_lock);
+        val = sysfs_attr_info->val;
+        mutex_unlock(&sysfs_attr_info->update_lock);
+    }
 
     switch(attr->index)
     {
         case PSU_PRESENT:
         case PSU_POWER_GOOD:
-            status = sysfs_attr_info->val.intval;
+            status = val.intval;
             return sprintf(buf, "%d\n", status);
             break;
         case PSU_MODEL_NAME:
         case PSU_MFR_ID:
         case PSU_SERIAL_NUM:
         case PSU_FAN_DIR:
-            return sprintf(buf, "%s\n", sysfs_attr_info->val.strval);
+            return sprintf(buf, "%s\n", val.strval);
             break;
         case PSU_V_OUT:
         case PSU_V_OUT_MIN:
@@ -393,16 +521,16 @@ ssize_t psu_show_default(struct device *dev, struct device_attribute *da, char *
         case PSU_I_IN:
         case PSU_P_OUT_MAX:
             multiplier = 1000;
-            return sprintf(buf, "%ld\n", get_real_world_value(client, usr_data, sysfs_attr_info, "linear11", multiplier));
+            return sprintf(buf, "%ld\n", get_real_world_value(client, usr_data, val.shortval, "linear11", multiplier));
             break;
         case PSU_P_IN:
         case PSU_P_OUT:
             multiplier = 1000000;
-            return sprintf(buf, "%ld\n", get_real_world_value(client, usr_data, sysfs_attr_info, "linear11", multiplier));
+            return sprintf(buf, "%ld\n", get_real_world_value(client, usr_data, val.shortval, "linear11", multiplier));
             break;
         case PSU_FAN1_SPEED:
             multiplier = 1;
-            return sprintf(buf, "%ld\n", get_real_world_value(client, usr_data, sysfs_attr_info, "linear11", multiplier));
+            return sprintf(buf, "%ld\n", get_real_world_value(client, usr_data, val.shortval, "linear11", multiplier));
             break;
         case PSU_TEMP1_INPUT:
         case PSU_TEMP1_HIGH_THRESHOLD:
@@ -411,7 +539,7 @@ ssize_t psu_show_default(struct device *dev, struct device_attribute *da, char *
         case PSU_TEMP3_INPUT:
         case PSU_TEMP3_HIGH_THRESHOLD:
             multiplier = 1000;
-            return sprintf(buf, "%ld\n", get_real_world_value(client, usr_data, sysfs_attr_info, "linear11", multiplier));
+            return sprintf(buf, "%ld\n", get_real_world_value(client, usr_data, val.shortval, "linear11", multiplier));
             break;
         default:
             printk(KERN_ERR "%s: Unable to find attribute index for %s\n", __FUNCTION__, usr_data->aname);
@@ -468,7 +596,7 @@ int psu_multifpgapci_read(PSU_DATA_ATTR *adata, int *output) {
         return -1;
     }
 
-    pci_dev = (struct pci_dev *)get_device_table(adata->devname);
+    pci_dev = (struct pci_dev *)get_device_table_cached(adata->devname, &adata->devptr, &adata->devgen);
     if (pci_dev == NULL) {
         printk(KERN_ERR "PDDF_PSU: Unable to get pci_dev of %s for %s\n", adata->devname, adata->aname);
         return -1;
@@ -37,6 +37,15 @@
 
 static unsigned short normal_i2c[] = { I2C_CLIENT_END };
 
+static SENSOR_DEVICE_ATTR(telemetry_max_age_ms, S_IWUSR|S_IRUGO, psu_show_cache_cfg, psu_store_cache_cfg, PSU_CACHE_MAX_AGE_MS);
+static SENSOR_DEVICE_ATTR(telemetry_refresh_ms, S_IWUSR|S_IRUGO, psu_show_cache_cfg, psu_store_cache_cfg, PSU_CACHE_REFRESH_MS);
+
+static struct attribute *psu_cache_cfg_attributes[] = {
+	&sensor_dev_attr_telemetry_max_age_ms.dev_attr.attr,
+	&sensor_dev_attr_telemetry_refresh_ms.dev_attr.attr,
+	NULL
+};
+
 struct pddf_ops_t pddf_psu_ops = {
 	.pre_init = NULL,
 	.post_init = NULL,
@@ -257,13 +266,15 @@ static int psu_probe(struct i2c_client *client)
 	data->num_psu_thermals = psu_platform_data->num_psu_thermals;
 	data->psu_temp_high_thresh_bitmap = psu_platform_data->psu_temp_high_thresh_bitmap;
 	data->num_attr = num;
-
+	data->max_age_ms = PSU_DEFAULT_MAX_AGE_MS;
+	mutex_init(&data->refresh_lock);
 
 
 	/* Create and Add supported attr in the 'attributes' list */
 	for (i=0; i<num; i++)
 	{
 		/*struct attribute *aptr = NULL;*/
+		struct psu_sysfs_attr *bound = NULL;
 		struct sensor_device_attribute *dy_ptr = NULL;
 		data_attr = psu_platform_data->psu_attrs + i;
 		sysfs_data_entry = get_psu_access_data(data_attr->aname);
@@ -278,9 +289,15 @@ static int psu_probe(struct i2c_client *client)
 			continue;
 		}
 
-		dy_ptr = (struct sensor_device_attribute *)kzalloc(sizeof(struct sensor_device_attribute)+ATTR_NAME_LEN, GFP_KERNEL);
-		dy_ptr->dev_attr.attr.name = (char *)&dy_ptr[1];
-		strcpy((char *)dy_ptr->dev_attr.attr.name, data_attr->aname);
+		/* Resolve the backing device once instead of on every attribute access */
+		if (strcmp(data_attr->devtype, "multifpgapci") == 0)
+			get_device_table_cached(data_attr->devname, &data_attr->devptr, &data_attr->devgen);
+
+		bound = kzalloc(sizeof(struct psu_sysfs_attr), GFP_KERNEL);
+		bound->idx = i;
+		dy_ptr = &bound->sda;
+		dy_ptr->dev_attr.attr.name = bound->name;
+		strcpy(bound->name, data_attr->aname);
 		dy_ptr->dev_attr.attr.mode = sysfs_data_entry->a_ptr->mode;
 		dy_ptr->dev_attr.show = sysfs_data_entry->a_ptr->show;
 		dy_ptr->dev_attr.store = sysfs_data_entry->a_ptr->store;
@@ -290,14 +307,18 @@ static int psu_probe(struct i2c_client *client)
 		strcpy(data->attr_info[i].name, data_attr->aname);
 		data->attr_info[i].valid = 0;
 		mutex_init(&data->attr_info[i].update_lock);
+		seqlock_init(&data->attr_info[i].snap_lock);
+		data->attr_info[i].bound = 1;
 
 		/*Create a duplicate entry*/
 		get_psu_duplicate_sysfs(dy_ptr->index, new_str);
 		if (strcmp(new_str,""))
 		{
-			dy_ptr = (struct sensor_device_attribute *)kzalloc(sizeof(struct sensor_device_attribute)+ATTR_NAME_LEN, GFP_KERNEL);
-			dy_ptr->dev_attr.attr.name = (char *)&dy_ptr[1];
-			strcpy((char *)dy_ptr->dev_attr.attr.name, new_str);
+			bound = kzalloc(sizeof(struct psu_sysfs_attr), GFP_KERNEL);
+			bound->idx = i;
+			dy_ptr = &bound->sda;
+			dy_ptr->dev_attr.attr.name = bound->name;
+			strcpy(bound->name, new_str);
 			dy_ptr->dev_attr.attr.mode = sysfs_data_entry->a_ptr->mode;
 			dy_ptr->dev_attr.show = sysfs_data_entry->a_ptr->show;
 			dy_ptr->dev_attr.store = sysfs_data_entry->a_ptr->store;
@@ -317,6 +338,12 @@ static int psu_probe(struct i2c_client *client)
         goto exit_free;
     }
 
+	data->psu_cache_cfg_group.attrs = psu_cache_cfg_attributes;
+	status = sysfs_create_group(&client->dev.kobj, &data->psu_cache_cfg_group);
+	if (status) {
+		goto exit_remove_attrs;
+	}
+
 	data->hwmon_dev = hwmon_device_register_with_groups(&client->dev, client->name, NULL, NULL);
 	if (IS_ERR(data->hwmon_dev)) {
 		status = PTR_ERR(data->hwmon_dev);
@@ -339,6 +366,9 @@ static int psu_probe(struct i2c_client *client)
 
 
 exit_remove:
+    sysfs_remove_group(&client->dev.kobj, &data->psu_cache_cfg_group);
+    psu_refresh_set(client, 0);
+exit_remove_attrs:
     sysfs_remove_group(&client->dev.kobj, &data->psu_attribute_group);
 exit_free:
 	/* Free all the allocated attributes */
@@ -369,6 +399,9 @@ static void psu_remove(struct i2c_client *client)
             printk(KERN_ERR "FAN pre_remove function failed\n");
     }
 
+	/* Remove the tunables first so that no store can restart the refresh thread */
+	sysfs_remove_group(&client->dev.kobj, &data->psu_cache_cfg_group);
+	psu_refresh_set(client, 0);
 	hwmon_device_unregister(data->hwmon_dev);
 	sysfs_remove_group(&client->dev.kobj, &data->psu_attribute_group);
 	for (i=0; data->psu_attribute_list[i]!=NULL; i++)
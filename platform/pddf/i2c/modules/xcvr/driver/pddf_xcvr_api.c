@@ -29,6 +29,15 @@
 #include <linux/delay.h>
 #include <linux/dmi.h>
 #include <linux/kobject.h>
+#include <linux/bitmap.h>
+#include <linux/gpio.h>
+#include <linux/interrupt.h>
+#include <linux/irq.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/spinlock.h>
+#include "pddf_client_defs.h"
 #include "pddf_multifpgapci_defs.h"
 #include "pddf_xcvr_defs.h"
 
@@ -49,10 +58,163 @@ extern int (*ptr_fpgapci_write)(uint32_t, uint32_t);
 int get_xcvr_module_attr_data(struct i2c_client *client, struct device *dev,
                             struct device_attribute *da);
 
+/*
+ * Retry policy of the i2c status reads.
+ * A failed read is retried after xcvr_retry_min_us, the delay doubling on every
+ * further failure up to xcvr_retry_max_us. Each bus remembers the delay its last
+ * retry needed so a flaky bus does not spin, while a healthy one retries within
+ * microseconds. A single stuck port therefore costs milliseconds of a sweep instead
+ * of the 600ms the fixed 60ms sleeps used to.
+ */
+int xcvr_retry_count = 10;
+int xcvr_retry_min_us = 50;
+int xcvr_retry_max_us = 60000;
+int xcvr_block_read = 0;
+
+static struct xcvr_bus_stats *xcvr_bus_stats;
+static int xcvr_bus_stats_num;
+static DEFINE_SPINLOCK(xcvr_bus_stats_lock);
+
+int xcvr_bus_stats_init(void)
+{
+    xcvr_bus_stats = kcalloc(XCVR_BUS_STATS_MAX, sizeof(*xcvr_bus_stats), GFP_KERNEL);
+    return xcvr_bus_stats ? 0 : -ENOMEM;
+}
+
+void xcvr_bus_stats_exit(void)
+{
+    struct xcvr_bus_stats *table;
+    unsigned long flags;
+
+    spin_lock_irqsave(&xcvr_bus_stats_lock, flags);
+    table = xcvr_bus_stats;
+    xcvr_bus_stats = NULL;
+    xcvr_bus_stats_num = 0;
+    spin_unlock_irqrestore(&xcvr_bus_stats_lock, flags);
+
+    kfree(table);
+}
+
+/* Store an integer tunable, rejecting values outside the range in the attribute data */
+ssize_t store_xcvr_tunable(struct device *dev, struct device_attribute *da, const char *buf, size_t count)
+{
+    PDDF_ATTR *ptr = (PDDF_ATTR *)da;
+    struct xcvr_tunable_range *range = (struct xcvr_tunable_range *)ptr->data;
+    int ret, num;
+
+    ret = kstrtoint(buf, 10, &num);
+    if (ret)
+        return ret;
+    if (num < range->min || num > range->max)
+        return -EINVAL;
+    WRITE_ONCE(*(int *)ptr->addr, num);
+
+    return count;
+}
+
+static struct xcvr_bus_stats *xcvr_bus_stats_get(struct i2c_adapter *adap)
+{
+    struct xcvr_bus_stats *bus = NULL;
+    unsigned long flags;
+    int i;
+
+    spin_lock_irqsave(&xcvr_bus_stats_lock, flags);
+    for (i = 0; xcvr_bus_stats && i < xcvr_bus_stats_num; i++)
+    {
+        if (xcvr_bus_stats[i].nr == adap->nr)
+        {
+            bus = &xcvr_bus_stats[i];
+            break;
+        }
+    }
+    if (bus == NULL && xcvr_bus_stats && xcvr_bus_stats_num < XCVR_BUS_STATS_MAX)
+    {
+        bus = &xcvr_bus_stats[xcvr_bus_stats_num++];
+        memset(bus, 0, sizeof(*bus));
+        bus->nr = adap->nr;
+        bus->backoff_us = xcvr_retry_min_us;
+    }
+    spin_unlock_irqrestore(&xcvr_bus_stats_lock, flags);
+
+    return bus;
+}
+
+static void xcvr_retry_sleep(unsigned int us)
+{
+    /* usleep_range() is meant for delays up to ~20ms */
+    if (us >= 20000)
+        msleep(DIV_ROUND_UP(us, 1000));
+    else
+        usleep_range(us, us + us / 2 + 1);
+}
+
+static int xcvr_i2c_read_once(struct i2c_client *client, XCVR_ATTR *info, int cpld, u8 *block)
+{
+    if (block)
+        return i2c_smbus_read_i2c_block_data(client, info->offset, info->len, block);
+    if (info->len == 2)
+        return i2c_smbus_read_word_swapped(client, info->offset);
+    if (cpld)
+        return board_i2c_cpld_read_new(info->devaddr, info->devname, info->offset);
+    return i2c_smbus_read_byte_data(client, info->offset);
+}
+
+/*
+ * Read info->len bytes at info->offset (or info->len bytes into block) under the
+ * retry policy of the bus and account the result to it.
+ */
+static int xcvr_i2c_read_retry(struct i2c_client *client, XCVR_ATTR *info, int cpld, u8 *block)
+{
+    struct xcvr_bus_stats *bus = xcvr_bus_stats_get(client->adapter);
+    unsigned int delay, min_us, max_us;
+    unsigned long flags;
+    int status, attempt, count;
+    ktime_t start;
+    u64 ns;
+
+    /* The tunables are range checked on store, only their order is not */
+    min_us = READ_ONCE(xcvr_retry_min_us);
+    max_us = max_t(unsigned int, READ_ONCE(xcvr_retry_max_us), min_us);
+    count = READ_ONCE(xcvr_retry_count);
+    delay = bus ? clamp(READ_ONCE(bus->backoff_us), min_us, max_us) : min_us;
+
+    start = ktime_get();
+    for (attempt = 0; ; attempt++)
+    {
+        status = xcvr_i2c_read_once(client, info, cpld, block);
+        if (likely(status >= 0) || attempt + 1 >= count)
+            break;
+        xcvr_retry_sleep(delay);
+        delay = min(delay * 2, max_us);
+    }
+    ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+    if (bus == NULL)
+        return status;
+
+    spin_lock_irqsave(&xcvr_bus_stats_lock, flags);
+    bus->reads++;
+    if (block)
+        bus->block_reads++;
+    bus->retries += attempt;
+    if (status < 0)
+        bus->errors++;
+    bus->total_ns += ns;
+    if (ns > bus->max_ns)
+        bus->max_ns = ns;
+    /* Start the next retry on this bus where this one ended, relax again on clean reads */
+    if (attempt)
+        bus->backoff_us = delay;
+    else if (bus->backoff_us > min_us)
+        bus->backoff_us = max(bus->backoff_us / 2, min_us);
+    spin_unlock_irqrestore(&xcvr_bus_stats_lock, flags);
+
+    return status;
+}
+
 int xcvr_i2c_cpld_read(XCVR_ATTR *info)
 {
     int status = -1;
-    int retry = 10;
     struct i2c_client *client_ptr=NULL;
 
     if (info!=NULL)
@@ -61,34 +223,8 @@ int xcvr_i2c_cpld_read(XCVR_ATTR *info)
         client_ptr = (struct i2c_client *)get_device_table(info->devname);
         if (client_ptr)
         {
-            if (info->len==1)
-            {
-                while (retry)
-                {
-                    status = board_i2c_cpld_read_new(info->devaddr, info->devname, info->offset);
-                    if (unlikely(status < 0))
-                    {
-                        msleep(60);
-                        retry--;
-                        continue;
-                    }
-                    break;
-                }
-            }
-            else if (info->len==2)
-            {
-                while(retry)
-                {
-                    status = i2c_smbus_read_word_swapped(client_ptr, info->offset);
-                    if (unlikely(status < 0))
-                    {
-                        msleep(60);
-                        retry--;
-                        continue;
-                    }
-                    break;
-                }
-            }
+            if (info->len==1 || info->len==2)
+                status = xcvr_i2c_read_retry(client_ptr, info, 1, NULL);
             else
                 printk(KERN_ERR "PDDF_XCVR: Doesn't support block CPLD read yet");
         }
@@ -154,7 +290,6 @@ int xcvr_i2c_cpld_write(XCVR_ATTR *info, uint32_t val)
 int xcvr_i2c_fpga_read(XCVR_ATTR *info)
 {
     int status = -1;
-    int retry = 10;
 
     if (info!=NULL)
     {
@@ -163,35 +298,8 @@ int xcvr_i2c_fpga_read(XCVR_ATTR *info)
         client_ptr = (struct i2c_client *)get_device_table(info->devname);
         if (client_ptr)
         {
-            if (info->len==1)
-            {
-                while(retry)
-                {
-                    status = i2c_smbus_read_byte_data(client_ptr , info->offset);
-                    if (unlikely(status < 0))
-                    {
-                        msleep(60);
-                        retry--;
-                        continue;
-                    }
-                    break;
-                }
-            }
-            else if (info->len==2)
-            {
-                retry = 10;
-                while(retry)
-                {
-                    status = i2c_smbus_read_word_swapped(client_ptr, info->offset);
-                    if (unlikely(status < 0))
-                    {
-                        msleep(60);
-                        retry--;
-                        continue;
-                    }
-                    break;
-                }
-            }
+            if (info->len==1 || info->len==2)
+                status = xcvr_i2c_read_retry(client_ptr, info, 0, NULL);
             else
                 printk(KERN_ERR "PDDF_XCVR: Doesn't support block FPGAI2C read yet");
         }
@@ -306,7 +414,7 @@ int xcvr_multifpgapci_read(XCVR_ATTR *info, int *output)
         goto ret;
     }
 
-    pci_dev = (struct pci_dev *)get_device_table(info->devname);
+    pci_dev = (struct pci_dev *)get_device_table_cached(info->devname, &info->devptr, &info->devgen);
     if (pci_dev == NULL) {
         printk(KERN_ERR "PDDF_XCVR: Unable to get pci_dev of %s for %s\n", info->devname, info->aname);
         status = -1;
@@ -336,7 +444,7 @@ int xcvr_multifpgapci_write(XCVR_ATTR *info, uint32_t val)
         return (-1);
     }
 
-    pci_dev = (struct pci_dev *)get_device_table(info->devname);
+    pci_dev = (struct pci_dev *)get_device_table_cached(info->devname, &info->devptr, &info->devgen);
     if (pci_dev == NULL) {
         printk(KERN_ERR "PDDF_XCVR: Unable to get pci_dev of %s for %s\n", info->devname, info->aname);
         status = -1;
@@ -1300,3 +1408,664 @@ ssize_t get_module_txfault(struct device *dev, struct device_attribute *da,
     }
     return sprintf(buf,"%s","");
 }
+
+/* Read the raw register backing an xcvr attribute, whatever the device type */
+int xcvr_read_attr_reg(XCVR_ATTR *info, int *val)
+{
+    int status = 0;
+
+    if (strcmp(info->devtype, "cpld") == 0)
+        status = xcvr_i2c_cpld_read(info);
+    else if (strcmp(info->devtype, "fpgai2c") == 0)
+        status = xcvr_i2c_fpga_read(info);
+    else if (strcmp(info->devtype, "fpgapci") == 0)
+        status = xcvr_fpgapci_read(info);
+    else if (strcmp(info->devtype, "multifpgapci") == 0)
+        return xcvr_multifpgapci_read(info, val);
+    else
+        return -EINVAL;
+
+    if (status < 0)
+        return status;
+
+    *val = status;
+    return 0;
+}
+
+/*
+ * Chassis-wide status bitmaps.
+ * Every probed xcvr client registers itself here by port index. A bulk sweep reads
+ * each distinct backing register once and derives the bit of every port from it,
+ * instead of one bus transaction per port.
+ */
+static struct i2c_client *xcvr_bulk_ports[XCVR_BULK_MAX_PORTS];
+static struct xcvr_bulk_snapshot xcvr_bulk_snap[XCVR_ATTR_MAX];
+static DEFINE_MUTEX(xcvr_bulk_lock);
+
+struct xcvr_bulk_reg {
+    XCVR_ATTR *info;
+    int done;
+    int status;
+    int val;
+};
+static struct xcvr_bulk_reg xcvr_bulk_regs[XCVR_BULK_MAX_REGS];
+/* Per sweep scratch, protected by xcvr_bulk_lock */
+static int xcvr_bulk_port_reg[XCVR_BULK_MAX_PORTS];
+static struct multifpgapci_reg_op xcvr_bulk_ops[XCVR_BULK_MAX_REGS];
+static int xcvr_bulk_op_reg[XCVR_BULK_MAX_REGS];
+
+int xcvr_bulk_max_age_ms = 100;
+unsigned long xcvr_bulk_sweeps = 0;
+unsigned long xcvr_bulk_reg_reads = 0;
+unsigned long xcvr_bulk_batched_reads = 0;
+unsigned long xcvr_bulk_block_reads = 0;
+
+void xcvr_bulk_register(struct i2c_client *client, int port)
+{
+    if (port < 0 || port >= XCVR_BULK_MAX_PORTS)
+        return;
+
+    mutex_lock(&xcvr_bulk_lock);
+    xcvr_bulk_ports[port] = client;
+    memset(xcvr_bulk_snap, 0, sizeof(xcvr_bulk_snap));
+    mutex_unlock(&xcvr_bulk_lock);
+}
+
+void xcvr_bulk_unregister(struct i2c_client *client, int port)
+{
+    if (port < 0 || port >= XCVR_BULK_MAX_PORTS)
+        return;
+
+    mutex_lock(&xcvr_bulk_lock);
+    if (xcvr_bulk_ports[port] == client)
+        xcvr_bulk_ports[port] = NULL;
+    memset(xcvr_bulk_snap, 0, sizeof(xcvr_bulk_snap));
+    mutex_unlock(&xcvr_bulk_lock);
+}
+
+static int xcvr_bulk_same_reg(XCVR_ATTR *a, XCVR_ATTR *b)
+{
+    return (a->devaddr == b->devaddr) && (a->offset == b->offset) && (a->len == b->len) &&
+           (strcmp(a->devtype, b->devtype) == 0) && (strcmp(a->devname, b->devname) == 0);
+}
+
+/*
+ * Read every collected register that lives in the BAR of the same multifpgapci
+ * device as regs[first] with one batched access. Returns -1 if the batch could not
+ * be issued, the registers are then read one by one.
+ */
+static int xcvr_bulk_read_batch(int first, int nregs)
+{
+    XCVR_ATTR *info = xcvr_bulk_regs[first].info;
+    struct pci_dev *pci_dev;
+    int i, nops = 0, status;
+
+    if (strcmp(info->devtype, "multifpgapci") != 0)
+        return -1;
+    pci_dev = get_device_table_cached(info->devname, &info->devptr, &info->devgen);
+    if (pci_dev == NULL)
+        return -1;
+
+    for (i = first; i < nregs; i++)
+    {
+        XCVR_ATTR *other = xcvr_bulk_regs[i].info;
+
+        if (xcvr_bulk_regs[i].done || strcmp(other->devtype, "multifpgapci") != 0 ||
+            get_device_table_cached(other->devname, &other->devptr, &other->devgen) != pci_dev)
+            continue;
+        xcvr_bulk_ops[nops].offset = other->devaddr + other->offset;
+        xcvr_bulk_ops[nops].mask = 0xffffffff;
+        xcvr_bulk_op_reg[nops] = i;
+        nops++;
+    }
+
+    status = multifpgapci_readpci_batch(pci_dev, xcvr_bulk_ops, nops);
+    if (status != 0)
+        return -1;
+
+    for (i = 0; i < nops; i++)
+    {
+        struct xcvr_bulk_reg *reg = &xcvr_bulk_regs[xcvr_bulk_op_reg[i]];
+
+        reg->val = xcvr_bulk_ops[i].val;
+        reg->status = 0;
+        reg->done = 1;
+    }
+    xcvr_bulk_reg_reads += nops;
+    xcvr_bulk_batched_reads += nops;
+
+    return 0;
+}
+
+/*
+ * Read the collected single byte i2c registers of the same CPLD/FPGA as regs[first]
+ * that form one contiguous run of offsets with a single SMBus block read. Gaps are
+ * never bridged, so no register outside the configured ones is touched. Returns -1
+ * if no block read was issued, the registers are then read one by one.
+ */
+static int xcvr_bulk_read_block(int first, int nregs)
+{
+    XCVR_ATTR *info = xcvr_bulk_regs[first].info;
+    struct i2c_client *client;
+    XCVR_ATTR block_info;
+    u8 block[I2C_SMBUS_BLOCK_MAX];
+    int i, j, lo, hi, nops = 0, cpld, status;
+
+    if (!xcvr_block_read || info->len != 1)
+        return -1;
+    cpld = (strcmp(info->devtype, "cpld") == 0);
+    if (!cpld && strcmp(info->devtype, "fpgai2c") != 0)
+        return -1;
+    client = (struct i2c_client *)get_device_table(info->devname);
+    if (client == NULL || !i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_READ_I2C_BLOCK))
+        return -1;
+
+    /* Grow the run of offsets around regs[first] while the neighbours are collected too */
+    for (i = first; i < nregs; i++)
+    {
+        XCVR_ATTR *other = xcvr_bulk_regs[i].info;
+
+        xcvr_bulk_op_reg[i] = 0;
+        if (xcvr_bulk_regs[i].done || other->len != 1 || other->devaddr != info->devaddr ||
+            strcmp(other->devtype, info->devtype) != 0 || strcmp(other->devname, info->devname) != 0)
+            continue;
+        xcvr_bulk_op_reg[i] = 1;
+    }
+    lo = hi = info->offset;
+    do
+    {
+        j = 0;
+        for (i = first; i < nregs; i++)
+        {
+            int off = xcvr_bulk_regs[i].info->offset;
+
+            if (!xcvr_bulk_op_reg[i])
+                continue;
+            if (off == lo - 1 && hi - lo + 1 < I2C_SMBUS_BLOCK_MAX)
+            {
+                lo = off;
+                j = 1;
+            }
+            else if (off == hi + 1 && hi - lo + 1 < I2C_SMBUS_BLOCK_MAX)
+            {
+                hi = off;
+                j = 1;
+            }
+        }
+    } while (j);
+
+    if (hi == lo)
+        return -1;
+
+    block_info = *info;
+    block_info.offset = lo;
+    block_info.len = hi - lo + 1;
+    status = xcvr_i2c_read_retry(client, &block_info, cpld, block);
+    if (status != block_info.len)
+        return -1;
+
+    for (i = first; i < nregs; i++)
+    {
+        struct xcvr_bulk_reg *reg = &xcvr_bulk_regs[i];
+
+        if (!xcvr_bulk_op_reg[i] || reg->info->offset < lo || reg->info->offset > hi)
+            continue;
+        reg->val = block[reg->info->offset - lo];
+        reg->status = 0;
+        reg->done = 1;
+        nops++;
+    }
+    xcvr_bulk_reg_reads++;
+    xcvr_bulk_block_reads += nops;
+
+    return 0;
+}
+
+/* The getters a sweep reproduces from the raw registers, indexed by attribute type */
+static int (* const xcvr_bulk_default_get[XCVR_ATTR_MAX])(struct i2c_client *client, XCVR_ATTR *info,
+                                                          struct xcvr_data *data) = {
+    [XCVR_PRESENT] = sonic_i2c_get_mod_pres,
+    [XCVR_RESET] = sonic_i2c_get_mod_reset,
+    [XCVR_INTR_STATUS] = sonic_i2c_get_mod_intr_status,
+    [XCVR_LPMODE] = sonic_i2c_get_mod_lpmode,
+    [XCVR_RXLOS] = sonic_i2c_get_mod_rxlos,
+};
+
+/* Platform drivers may hook or replace the getters, their results can't be batched */
+static int xcvr_bulk_ops_overridden(int type)
+{
+    XCVR_SYSFS_ATTR_OPS *attr_ops = &xcvr_ops[type];
+
+    return attr_ops->pre_get != NULL || attr_ops->post_get != NULL ||
+           attr_ops->do_get != xcvr_bulk_default_get[type];
+}
+
+/* Read the status of one port through the xcvr_ops hooks, as its sysfs attribute does */
+static int xcvr_bulk_port_get(struct i2c_client *client, struct xcvr_data *data, XCVR_ATTR *info, int type)
+{
+    XCVR_SYSFS_ATTR_OPS *attr_ops = &xcvr_ops[type];
+    int val = 0;
+
+    mutex_lock(&data->update_lock);
+    if (attr_ops->pre_get != NULL)
+        (attr_ops->pre_get)(client, info, data);
+    if (attr_ops->do_get != NULL)
+        (attr_ops->do_get)(client, info, data);
+    if (attr_ops->post_get != NULL)
+        (attr_ops->post_get)(client, info, data);
+
+    switch (type)
+    {
+        case XCVR_PRESENT:
+            val = data->modpres;
+            break;
+        case XCVR_RESET:
+            val = data->reset;
+            break;
+        case XCVR_INTR_STATUS:
+            val = data->intr_status;
+            break;
+        case XCVR_LPMODE:
+            val = data->lpmode;
+            break;
+        case XCVR_RXLOS:
+            val = data->rxlos;
+            break;
+        default:
+            break;
+    }
+    mutex_unlock(&data->update_lock);
+
+    return val;
+}
+
+/* Called with xcvr_bulk_lock held */
+static void xcvr_bulk_sweep(int type)
+{
+    struct xcvr_bulk_snapshot *snap = &xcvr_bulk_snap[type];
+    struct xcvr_data *data;
+    XCVR_ATTR *info;
+    int port, i, nregs = 0, status, val;
+    int hooked = xcvr_bulk_ops_overridden(type);
+
+    bitmap_zero(snap->bitmap, XCVR_BULK_MAX_PORTS);
+    snap->nports = 0;
+
+    /* Collect the distinct registers backing this attribute across all ports */
+    for (port = 0; port < XCVR_BULK_MAX_PORTS; port++)
+    {
+        xcvr_bulk_port_reg[port] = -1;
+        if (xcvr_bulk_ports[port] == NULL)
+            continue;
+        snap->nports = port + 1;
+        if (hooked)
+            continue;   /* read port by port below */
+
+        data = i2c_get_clientdata(xcvr_bulk_ports[port]);
+        info = data ? data->attrs[type] : NULL;
+        if (info == NULL)
+            continue;
+
+        for (i = 0; i < nregs; i++)
+        {
+            if (xcvr_bulk_same_reg(xcvr_bulk_regs[i].info, info))
+                break;
+        }
+
+        if (i == nregs)
+        {
+            if (nregs == XCVR_BULK_MAX_REGS)
+                continue;   /* read on its own below */
+            xcvr_bulk_regs[nregs].info = info;
+            xcvr_bulk_regs[nregs].done = 0;
+            nregs++;
+        }
+        xcvr_bulk_port_reg[port] = i;
+    }
+
+    /* Fetch them, one batch per FPGA where possible */
+    for (i = 0; i < nregs; i++)
+    {
+        if (xcvr_bulk_regs[i].done)
+            continue;
+        if (xcvr_bulk_read_batch(i, nregs) == 0)
+            continue;
+        if (xcvr_bulk_read_block(i, nregs) == 0)
+            continue;
+
+        xcvr_bulk_regs[i].status = xcvr_read_attr_reg(xcvr_bulk_regs[i].info, &xcvr_bulk_regs[i].val);
+        xcvr_bulk_regs[i].done = 1;
+        xcvr_bulk_reg_reads++;
+    }
+
+    /* Derive the bit of every port */
+    for (port = 0; port < snap->nports; port++)
+    {
+        if (xcvr_bulk_ports[port] == NULL)
+            continue;
+
+        data = i2c_get_clientdata(xcvr_bulk_ports[port]);
+        info = data ? data->attrs[type] : NULL;
+        if (info == NULL)
+            continue;
+
+        if (hooked)
+        {
+            if (xcvr_bulk_port_get(xcvr_bulk_ports[port], data, info, type))
+                set_bit(port, snap->bitmap);
+            continue;
+        }
+
+        i = xcvr_bulk_port_reg[port];
+        if (i >= 0)
+        {
+            status = xcvr_bulk_regs[i].status;
+            val = xcvr_bulk_regs[i].val;
+        }
+        else
+        {
+            status = xcvr_read_attr_reg(info, &val);
+            xcvr_bulk_reg_reads++;
+        }
+
+        if (status == 0 && ((val & BIT_INDEX(info->mask)) == info->cmpval))
+            set_bit(port, snap->bitmap);
+    }
+
+    xcvr_bulk_sweeps++;
+    snap->valid = 1;
+    snap->last_updated = jiffies;
+}
+
+ssize_t get_xcvr_bulk_status(struct device *dev, struct device_attribute *da, char *buf)
+{
+    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
+    struct xcvr_bulk_snapshot *snap;
+    ssize_t ret;
+
+    if (attr->index < 0 || attr->index >= XCVR_ATTR_MAX)
+        return -EINVAL;
+
+    snap = &xcvr_bulk_snap[attr->index];
+
+    mutex_lock(&xcvr_bulk_lock);
+    if (!snap->valid || xcvr_bulk_max_age_ms <= 0 ||
+        time_after(jiffies, snap->last_updated + msecs_to_jiffies(xcvr_bulk_max_age_ms)))
+        xcvr_bulk_sweep(attr->index);
+
+    if (snap->nports)
+        ret = bitmap_print_to_pagebuf(false, buf, snap->bitmap, snap->nports);
+    else
+        ret = sprintf(buf, "0\n");
+    mutex_unlock(&xcvr_bulk_lock);
+
+    return ret;
+}
+
+ssize_t get_xcvr_bulk_stats(struct device *dev, struct device_attribute *da, char *buf)
+{
+    ssize_t ret;
+
+    mutex_lock(&xcvr_bulk_lock);
+    ret = sprintf(buf, "sweeps: %lu\nreg_reads: %lu\nbatched_reads: %lu\nblock_reads: %lu\n",
+                  xcvr_bulk_sweeps, xcvr_bulk_reg_reads, xcvr_bulk_batched_reads, xcvr_bulk_block_reads);
+    mutex_unlock(&xcvr_bulk_lock);
+
+    return ret;
+}
+
+ssize_t get_xcvr_bus_stats(struct device *dev, struct device_attribute *da, char *buf)
+{
+    struct xcvr_bus_stats *bus;
+    unsigned long flags;
+    ssize_t len = 0;
+    int i;
+
+    len += scnprintf(buf + len, PAGE_SIZE - len, "bus reads block_reads retries errors avg_us max_us backoff_us\n");
+    spin_lock_irqsave(&xcvr_bus_stats_lock, flags);
+    for (i = 0; xcvr_bus_stats && i < xcvr_bus_stats_num; i++)
+    {
+        bus = &xcvr_bus_stats[i];
+        len += scnprintf(buf + len, PAGE_SIZE - len, "%d %lu %lu %lu %lu %llu %llu %u\n",
+                         bus->nr, bus->reads, bus->block_reads, bus->retries, bus->errors,
+                         bus->reads ? div64_u64(bus->total_ns, bus->reads) / 1000 : 0,
+                         div64_u64(bus->max_ns, 1000), bus->backoff_us);
+    }
+    spin_unlock_irqrestore(&xcvr_bus_stats_lock, flags);
+
+    return len;
+}
+
+/*
+ * Presence/interrupt change events.
+ * Changes are detected either from a CPLD/FPGA interrupt line (or a GPIO of the pddf
+ * gpio expanders) or, on boards without one, by a polling kthread. A change is only
+ * reported when a re-sample event_debounce_ms later agrees with it. The changed ports
+ * accumulate in a bitmap which is cleared when read; readers are woken through
+ * sysfs_notify() so daemons can block in poll() on the 'xcvr_event' attribute.
+ * The trigger of an interrupt line comes from event_irq_trigger (IRQF_TRIGGER_* bits),
+ * else from the firmware description of the line; a GPIO defaults to falling edge.
+ */
+int xcvr_event_irq = -1;
+int xcvr_event_irq_trigger = 0;
+int xcvr_event_gpio = -1;
+int xcvr_event_poll_ms = 1000;
+int xcvr_event_debounce_ms = 50;
+
+static struct kobject *xcvr_event_kobj;
+static struct task_struct *xcvr_event_task;
+static int xcvr_event_irq_bound = -1;
+static DEFINE_MUTEX(xcvr_event_lock);
+static DEFINE_MUTEX(xcvr_event_ctrl_lock);     /* serializes enable/disable */
+static unsigned long xcvr_event_stable[2][BITS_TO_LONGS(XCVR_BULK_MAX_PORTS)];
+static unsigned long xcvr_event_changed[BITS_TO_LONGS(XCVR_BULK_MAX_PORTS)];
+static int xcvr_event_nports = 0;
+static const int xcvr_event_types[2] = { XCVR_PRESENT, XCVR_INTR_STATUS };
+
+/* Take a fresh sample of one status type, bypassing the bulk staleness window */
+static int xcvr_bulk_fetch(int type, unsigned long *bitmap)
+{
+    int nports;
+
+    mutex_lock(&xcvr_bulk_lock);
+    xcvr_bulk_sweep(type);
+    bitmap_copy(bitmap, xcvr_bulk_snap[type].bitmap, XCVR_BULK_MAX_PORTS);
+    nports = xcvr_bulk_snap[type].nports;
+    mutex_unlock(&xcvr_bulk_lock);
+
+    return nports;
+}
+
+static void xcvr_event_sample(void)
+{
+    unsigned long cur[ARRAY_SIZE(xcvr_event_types)][BITS_TO_LONGS(XCVR_BULK_MAX_PORTS)];
+    unsigned long unstable[ARRAY_SIZE(xcvr_event_types)][BITS_TO_LONGS(XCVR_BULK_MAX_PORTS)];
+    DECLARE_BITMAP(again, XCVR_BULK_MAX_PORTS);
+    DECLARE_BITMAP(diff, XCVR_BULK_MAX_PORTS);
+    int i, nports = 0, changed = 0, notify = 0;
+
+    for (i = 0; i < ARRAY_SIZE(xcvr_event_types); i++)
+    {
+        nports = max(nports, xcvr_bulk_fetch(xcvr_event_types[i], cur[i]));
+        bitmap_zero(unstable[i], XCVR_BULK_MAX_PORTS);
+    }
+
+    mutex_lock(&xcvr_event_lock);
+    xcvr_event_nports = max(xcvr_event_nports, nports);
+    for (i = 0; i < ARRAY_SIZE(xcvr_event_types); i++)
+    {
+        if (!bitmap_equal(cur[i], xcvr_event_stable[i], XCVR_BULK_MAX_PORTS))
+            changed |= 1 << i;
+    }
+    mutex_unlock(&xcvr_event_lock);
+
+    if (!changed)
+        return;
+
+    /* Debounce without holding the lock: ignore the bits which differ on a second sample */
+    if (xcvr_event_debounce_ms > 0)
+    {
+        msleep(xcvr_event_debounce_ms);
+        for (i = 0; i < ARRAY_SIZE(xcvr_event_types); i++)
+        {
+            if (!(changed & (1 << i)))
+                continue;
+            xcvr_bulk_fetch(xcvr_event_types[i], again);
+            bitmap_xor(unstable[i], cur[i], again, XCVR_BULK_MAX_PORTS);
+        }
+    }
+
+    mutex_lock(&xcvr_event_lock);
+    for (i = 0; i < ARRAY_SIZE(xcvr_event_types); i++)
+    {
+        if (!(changed & (1 << i)))
+            continue;
+        bitmap_xor(diff, cur[i], xcvr_event_stable[i], XCVR_BULK_MAX_PORTS);
+        bitmap_andnot(diff, diff, unstable[i], XCVR_BULK_MAX_PORTS);
+        if (bitmap_empty(diff, XCVR_BULK_MAX_PORTS))
+            continue;
+
+        bitmap_xor(xcvr_event_stable[i], xcvr_event_stable[i], diff, XCVR_BULK_MAX_PORTS);
+        bitmap_or(xcvr_event_changed, xcvr_event_changed, diff, XCVR_BULK_MAX_PORTS);
+        notify = 1;
+    }
+    mutex_unlock(&xcvr_event_lock);
+
+    if (notify && xcvr_event_kobj)
+        sysfs_notify(xcvr_event_kobj, NULL, "xcvr_event");
+}
+
+static irqreturn_t xcvr_event_isr(int irq, void *dev_id)
+{
+    /* Threaded handler; the line stays masked until the status registers are read */
+    xcvr_event_sample();
+    return IRQ_HANDLED;
+}
+
+static int xcvr_event_thread(void *arg)
+{
+    while (!kthread_should_stop())
+    {
+        xcvr_event_sample();
+
+        set_current_state(TASK_INTERRUPTIBLE);
+        if (!kthread_should_stop())
+            schedule_timeout(msecs_to_jiffies(xcvr_event_poll_ms > 0 ? xcvr_event_poll_ms : 1000));
+        __set_current_state(TASK_RUNNING);
+    }
+    return 0;
+}
+
+int xcvr_event_start(struct kobject *kobj)
+{
+    int irq = xcvr_event_irq;
+    int i, status = 0;
+    unsigned long trigger;
+
+    mutex_lock(&xcvr_event_ctrl_lock);
+    if (xcvr_event_task || xcvr_event_irq_bound >= 0)
+    {
+        status = -EBUSY;
+        goto out;
+    }
+
+    xcvr_event_kobj = kobj;
+
+    /* Baseline, so that the ports present at start are not reported as changes */
+    mutex_lock(&xcvr_event_lock);
+    for (i = 0; i < ARRAY_SIZE(xcvr_event_types); i++)
+        xcvr_event_nports = max(xcvr_event_nports, xcvr_bulk_fetch(xcvr_event_types[i], xcvr_event_stable[i]));
+    bitmap_zero(xcvr_event_changed, XCVR_BULK_MAX_PORTS);
+    mutex_unlock(&xcvr_event_lock);
+
+    if (xcvr_event_gpio >= 0)
+    {
+        irq = gpio_to_irq(xcvr_event_gpio);
+        if (irq < 0)
+            printk(KERN_ERR "PDDF_XCVR: Unable to map gpio %d to an irq, ret %d\n", xcvr_event_gpio, irq);
+    }
+
+    if (irq >= 0)
+    {
+        /* A line without a known trigger type could storm, don't guess one */
+        trigger = xcvr_event_irq_trigger & IRQF_TRIGGER_MASK;
+        if (trigger == 0)
+            trigger = (xcvr_event_gpio >= 0) ? IRQF_TRIGGER_FALLING : irq_get_trigger_type(irq);
+        if (trigger == 0)
+        {
+            printk(KERN_ERR "PDDF_XCVR: No trigger type for irq %d, set event_irq_trigger. Falling back to polling\n", irq);
+            irq = -1;
+        }
+    }
+
+    if (irq >= 0)
+    {
+        status = request_threaded_irq(irq, NULL, xcvr_event_isr, IRQF_ONESHOT | trigger,
+                                      "pddf_xcvr_event", &xcvr_event_kobj);
+        if (status == 0)
+        {
+            xcvr_event_irq_bound = irq;
+            pddf_dbg(XCVR, KERN_INFO "%s: bound xcvr events to irq %d, trigger 0x%lx\n", __FUNCTION__, irq, trigger);
+            goto out;
+        }
+        printk(KERN_ERR "PDDF_XCVR: Unable to request irq %d, ret %d. Falling back to polling\n", irq, status);
+        status = 0;
+    }
+
+    xcvr_event_task = kthread_run(xcvr_event_thread, NULL, "pddf_xcvr_event");
+    if (IS_ERR(xcvr_event_task))
+    {
+        status = PTR_ERR(xcvr_event_task);
+        xcvr_event_task = NULL;
+    }
+
+out:
+    mutex_unlock(&xcvr_event_ctrl_lock);
+    return status;
+}
+
+void xcvr_event_stop(void)
+{
+    mutex_lock(&xcvr_event_ctrl_lock);
+    if (xcvr_event_irq_bound >= 0)
+    {
+        free_irq(xcvr_event_irq_bound, &xcvr_event_kobj);
+        xcvr_event_irq_bound = -1;
+    }
+    if (xcvr_event_task)
+    {
+        kthread_stop(xcvr_event_task);
+        xcvr_event_task = NULL;
+    }
+    mutex_unlock(&xcvr_event_ctrl_lock);
+}
+
+ssize_t get_xcvr_event(struct device *dev, struct device_attribute *da, char *buf)
+{
+    ssize_t ret;
+
+    mutex_lock(&xcvr_event_lock);
+    if (xcvr_event_nports)
+        ret = bitmap_print_to_pagebuf(false, buf, xcvr_event_changed, xcvr_event_nports);
+    else
+        ret = sprintf(buf, "0\n");
+    bitmap_zero(xcvr_event_changed, XCVR_BULK_MAX_PORTS);
+    mutex_unlock(&xcvr_event_lock);
+
+    return ret;
+}
+
+ssize_t set_xcvr_event_ops(struct device *dev, struct device_attribute *da, const char *buf, size_t count)
+{
+    int status = 0;
+
+    /* The xcvr_bulk attributes live on a plain kobject, which is what 'dev' really is */
+    if (strncmp(buf, "enable", strlen("enable")) == 0)
+        status = xcvr_event_start((struct kobject *)dev);
+    else if (strncmp(buf, "disable", strlen("disable")) == 0)
+        xcvr_event_stop();
+    else
+        status = -EINVAL;
+
+    return status ? status : count;
+}
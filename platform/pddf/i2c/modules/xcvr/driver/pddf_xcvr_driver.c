@@ -91,6 +91,63 @@ static const struct attribute_group xcvr_group = {
     .attrs = xcvr_attributes,
 };
 
+/* Chassis-wide status bitmaps, one bit per port index, under /sys/kernel/pddf/devices/xcvr_bulk */
+static struct sensor_device_attribute xcvr_bulk_present = SENSOR_ATTR(xcvr_present, S_IRUGO, get_xcvr_bulk_status, NULL, XCVR_PRESENT);
+static struct sensor_device_attribute xcvr_bulk_reset = SENSOR_ATTR(xcvr_reset, S_IRUGO, get_xcvr_bulk_status, NULL, XCVR_RESET);
+static struct sensor_device_attribute xcvr_bulk_intr_status = SENSOR_ATTR(xcvr_intr_status, S_IRUGO, get_xcvr_bulk_status, NULL, XCVR_INTR_STATUS);
+static struct sensor_device_attribute xcvr_bulk_lpmode = SENSOR_ATTR(xcvr_lpmode, S_IRUGO, get_xcvr_bulk_status, NULL, XCVR_LPMODE);
+static struct sensor_device_attribute xcvr_bulk_rxlos = SENSOR_ATTR(xcvr_rxlos, S_IRUGO, get_xcvr_bulk_status, NULL, XCVR_RXLOS);
+static struct sensor_device_attribute xcvr_bulk_stats = SENSOR_ATTR(stats, S_IRUGO, get_xcvr_bulk_stats, NULL, 0);
+PDDF_DATA_ATTR(max_age_ms, S_IWUSR|S_IRUGO, show_pddf_data, store_pddf_data, PDDF_INT_DEC, sizeof(int), (void*)&xcvr_bulk_max_age_ms, NULL);
+
+/* Retry policy of the i2c status reads and the per bus counters */
+static struct sensor_device_attribute xcvr_bus_stats = SENSOR_ATTR(bus_stats, S_IRUGO, get_xcvr_bus_stats, NULL, 0);
+static struct xcvr_tunable_range xcvr_retry_count_range = { 1, 100 };
+static struct xcvr_tunable_range xcvr_retry_us_range = { 1, 1000000 };
+static struct xcvr_tunable_range xcvr_block_read_range = { 0, 1 };
+PDDF_DATA_ATTR(retry_count, S_IWUSR|S_IRUGO, show_pddf_data, store_xcvr_tunable, PDDF_INT_DEC, sizeof(int), (void*)&xcvr_retry_count, (void*)&xcvr_retry_count_range);
+PDDF_DATA_ATTR(retry_min_us, S_IWUSR|S_IRUGO, show_pddf_data, store_xcvr_tunable, PDDF_INT_DEC, sizeof(int), (void*)&xcvr_retry_min_us, (void*)&xcvr_retry_us_range);
+PDDF_DATA_ATTR(retry_max_us, S_IWUSR|S_IRUGO, show_pddf_data, store_xcvr_tunable, PDDF_INT_DEC, sizeof(int), (void*)&xcvr_retry_max_us, (void*)&xcvr_retry_us_range);
+PDDF_DATA_ATTR(block_read, S_IWUSR|S_IRUGO, show_pddf_data, store_xcvr_tunable, PDDF_INT_DEC, sizeof(int), (void*)&xcvr_block_read, (void*)&xcvr_block_read_range);
+
+/* Presence/interrupt change events; poll() on xcvr_event, read returns and clears the changed ports */
+static struct sensor_device_attribute xcvr_bulk_event = SENSOR_ATTR(xcvr_event, S_IRUGO, get_xcvr_event, NULL, 0);
+PDDF_DATA_ATTR(event_irq, S_IWUSR|S_IRUGO, show_pddf_data, store_pddf_data, PDDF_INT_DEC, sizeof(int), (void*)&xcvr_event_irq, NULL);
+PDDF_DATA_ATTR(event_irq_trigger, S_IWUSR|S_IRUGO, show_pddf_data, store_pddf_data, PDDF_INT_HEX, sizeof(int), (void*)&xcvr_event_irq_trigger, NULL);
+PDDF_DATA_ATTR(event_gpio, S_IWUSR|S_IRUGO, show_pddf_data, store_pddf_data, PDDF_INT_DEC, sizeof(int), (void*)&xcvr_event_gpio, NULL);
+PDDF_DATA_ATTR(event_poll_ms, S_IWUSR|S_IRUGO, show_pddf_data, store_pddf_data, PDDF_INT_DEC, sizeof(int), (void*)&xcvr_event_poll_ms, NULL);
+PDDF_DATA_ATTR(event_debounce_ms, S_IWUSR|S_IRUGO, show_pddf_data, store_pddf_data, PDDF_INT_DEC, sizeof(int), (void*)&xcvr_event_debounce_ms, NULL);
+PDDF_DATA_ATTR(event_ops, S_IWUSR, NULL, set_xcvr_event_ops, PDDF_CHAR, 8, NULL, NULL);
+
+static struct attribute *xcvr_bulk_attributes[] = {
+    &xcvr_bulk_present.dev_attr.attr,
+    &xcvr_bulk_reset.dev_attr.attr,
+    &xcvr_bulk_intr_status.dev_attr.attr,
+    &xcvr_bulk_lpmode.dev_attr.attr,
+    &xcvr_bulk_rxlos.dev_attr.attr,
+    &xcvr_bulk_stats.dev_attr.attr,
+    &attr_max_age_ms.dev_attr.attr,
+    &xcvr_bus_stats.dev_attr.attr,
+    &attr_retry_count.dev_attr.attr,
+    &attr_retry_min_us.dev_attr.attr,
+    &attr_retry_max_us.dev_attr.attr,
+    &attr_block_read.dev_attr.attr,
+    &xcvr_bulk_event.dev_attr.attr,
+    &attr_event_irq.dev_attr.attr,
+    &attr_event_irq_trigger.dev_attr.attr,
+    &attr_event_gpio.dev_attr.attr,
+    &attr_event_poll_ms.dev_attr.attr,
+    &attr_event_debounce_ms.dev_attr.attr,
+    &attr_event_ops.dev_attr.attr,
+    NULL
+};
+
+static const struct attribute_group xcvr_bulk_group = {
+    .attrs = xcvr_bulk_attributes,
+};
+
+static struct kobject *xcvr_bulk_kobj;
+
 enum xcvr_intf 
 {
     XCVR_CTRL_INTF,
@@ -152,6 +209,9 @@ static int xcvr_probe(struct i2c_client *client)
     {
         struct attribute *aptr = NULL;
         attr_data = xcvr_platform_data->xcvr_attrs + i;
+        /* Resolve the backing device once instead of on every attribute access */
+        if (strcmp(attr_data->devtype, "multifpgapci") == 0)
+            get_device_table_cached(attr_data->devname, &attr_data->devptr, &attr_data->devgen);
         for(j=0;j<XCVR_ATTR_MAX;j++)
         {
             aptr = &xcvr_attr_list[j]->dev_attr.attr;
@@ -161,7 +221,10 @@ static int xcvr_probe(struct i2c_client *client)
         }
         
         if (j<XCVR_ATTR_MAX)
+        {
             xcvr_attributes[i] = &xcvr_attr_list[j]->dev_attr.attr;
+            data->attrs[j] = attr_data;
+        }
 
     }
     xcvr_attributes[i] = NULL;
@@ -190,6 +253,7 @@ static int xcvr_probe(struct i2c_client *client)
             goto exit_remove;
     }
 
+    xcvr_bulk_register(client, data->index);
 
     return 0;
 
@@ -217,6 +281,7 @@ static void xcvr_remove(struct i2c_client *client)
             printk(KERN_ERR "FAN pre_remove function failed\n");
     }
 
+    xcvr_bulk_unregister(client, data->index);
     hwmon_device_unregister(data->xdev);
     sysfs_remove_group(&client->dev.kobj, &xcvr_group);
     kfree(data);
@@ -263,9 +328,32 @@ int xcvr_init(void)
     }
 
     pddf_dbg(XCVR, KERN_ERR "PDDF XCVR DRIVER.. init Invoked..\n");
+    ret = xcvr_bus_stats_init();
+    if (ret!=0)
+        return ret;
+
     ret = i2c_add_driver(&xcvr_driver);
     if (ret!=0)
+    {
+        xcvr_bus_stats_exit();
         return ret;
+    }
+
+    xcvr_bulk_kobj = kobject_create_and_add("xcvr_bulk", get_device_i2c_kobj());
+    if (!xcvr_bulk_kobj)
+    {
+        i2c_del_driver(&xcvr_driver);
+        xcvr_bus_stats_exit();
+        return -ENOMEM;
+    }
+    ret = sysfs_create_group(xcvr_bulk_kobj, &xcvr_bulk_group);
+    if (ret)
+    {
+        kobject_put(xcvr_bulk_kobj);
+        i2c_del_driver(&xcvr_driver);
+        xcvr_bus_stats_exit();
+        return ret;
+    }
 
     if (pddf_xcvr_ops.post_init)
     {
@@ -282,7 +370,11 @@ void xcvr_exit(void)
 {
     pddf_dbg(XCVR, "PDDF XCVR DRIVER.. exit\n");
     if (pddf_xcvr_ops.pre_exit) (pddf_xcvr_ops.pre_exit)();
+    xcvr_event_stop();
+    sysfs_remove_group(xcvr_bulk_kobj, &xcvr_bulk_group);
+    kobject_put(xcvr_bulk_kobj);
     i2c_del_driver(&xcvr_driver);
+    xcvr_bus_stats_exit();
     if (pddf_xcvr_ops.post_exit) (pddf_xcvr_ops.post_exit)();
 
 }